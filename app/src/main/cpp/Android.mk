@@ -75,6 +75,15 @@ LOCAL_CFLAGS += "-DDARWIN_NO_CARBON"
 LOCAL_CFLAGS += "-DFT2_BUILD_LIBRARY"
 include $(BUILD_SHARED_LIBRARY)
 
+# Add headless mock runtime, selected through mock_runtime/mock_runtime.json
+include $(CLEAR_VARS)
+LOCAL_MODULE := openxr_mock_runtime
+LOCAL_CFLAGS += -DXR_USE_PLATFORM_ANDROID=1 -DXR_USE_GRAPHICS_API_OPENGL_ES=1 -DXR_USE_TIMESPEC=1
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/openxr_loader/include
+LOCAL_SRC_FILES := mock_runtime/mock_runtime.cpp
+LOCAL_LDLIBS := -llog -lGLESv3 -lEGL
+include $(BUILD_SHARED_LIBRARY)
+
 # Add demos library
 include $(CLEAR_VARS)
 LOCAL_MODULE := openxr_demos
@@ -92,7 +101,17 @@ LOCAL_SRC_FILES := main.cpp \
                    graphicsplugin_opengles.cpp \
                    openxr_loader/include/common/gfxwrapper_opengl.c \
                    openxr_program.cpp \
+                   posecache.cpp \
+                   demos/cameraBuffer.cpp \
+                   demos/frameArena.cpp \
+                   demos/glState.cpp \
+                   demos/glyphAtlas.cpp \
+                   demos/instanceBuffer.cpp \
+                   demos/lateLatch.cpp \
+                   demos/profiler.cpp \
+                   demos/renderQueue.cpp \
                    demos/shader.cpp \
+                   demos/platform_android.cpp \
                    demos/utils.cpp \
                    demos/mesh.cpp \
                    demos/model.cpp \
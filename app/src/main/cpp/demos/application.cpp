@@ -1,5 +1,6 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #include <dirent.h>
+#include <atomic>
 #include "pch.h"
 #include "common.h"
 #include "options.h"
@@ -15,6 +16,14 @@
 #include "utils.h"
 #include "graphicsplugin.h"
 #include "cube.h"
+#include "frameArena.h"
+#include "lateLatch.h"
+#include "profiler.h"
+#include "glState.h"
+#include "renderQueue.h"
+
+// input events read by inputEvent(), the dashboard controller table reads all of them
+#define INPUT_EVENT_MASK_DEFAULT (CONTROLLER_EVENT_BIT_click_menu | CONTROLLER_EVENT_BIT_click_trigger)
 
 class Application : public IApplication {
 public:
@@ -27,14 +36,21 @@ public:
     virtual void setGazeLocation(XrSpaceLocation& gazeLocation, std::vector<XrView>& views, float ipd, XrResult result = XR_SUCCESS) override;
     virtual void setHandJointLocation(XrHandJointLocationEXT* location) override;
     virtual void inputEvent(int leftright, const ApplicationEvent& event) override;
+    virtual uint32_t inputEventMask() const override;
+    virtual void update(const FrameState& frameState) override;
+    virtual bool panelLayer(PanelLayer& layer) override;
+    virtual uint32_t videoLayers(XrSpace space, XrCompositionLayerBaseHeader** layers) override;
     virtual void renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) override;
+    virtual void renderFrameMultiview(const XrPosef* pose, const glm::mat4* project, const glm::mat4* view) override;
 private:
     void layout();
-    void showDashboard(const glm::mat4& project, const glm::mat4& view);
+    void updateDashboard();
+    void showDashboardProfiler();
     void showDashboardController();
-    void showDeviceInformation(const glm::mat4& project, const glm::mat4& view);
-    void renderEyeTracking(const glm::mat4& project, const glm::mat4& view, int32_t eye);
-    void renderHandTracking(const glm::mat4& project, const glm::mat4& view);
+    void showDeviceInformation();
+    void renderEyeTracking(int32_t eye);
+    void renderHandTracking();
+    void writeLateLatch();
     void getAllVideoFiles(const std::string& path, std::vector<std::string>& files);
     void startPlayVideo(const std::string& file);
     void haptic(int leftright, float amplitude, float frequency, float duration/*seconds*/);
@@ -55,13 +71,15 @@ private:
     glm::mat4 mControllerModel;
     XrPosef mControllerPose[HAND_COUNT];
     std::shared_ptr<CubeRender> mCubeRender;
+    RenderQueue mRenderQueue;   // draws of the view being rendered
 
     //openxr
     XrInstance m_instance;          //Keep the same naming as openxr_program.cpp
     XrSession m_session;
     Extentions* m_extentions;
     XrSpaceLocation m_gazeLocation;
-    std::vector<XrView> m_views;
+    XrView m_views[EYE_COUNT];
+    uint32_t mViewCount = 0;
     float mIpd;
     XrHandJointLocationEXT m_jointLocations[HAND_COUNT][XR_HAND_JOINT_COUNT_EXT];
 
@@ -70,11 +88,14 @@ private:
     std::string mDeviceOS;
 
     bool mIsShowDashboard = true;
+    bool mGuiLayer = false;       //Options::GuiLayer, the runtime composites the dashboard
+    bool mPanelChanged = false;   //the dashboard texture was redrawn by this frame's update
 
     std::vector<std::string> mAllVideoFiles;
     int32_t mCount = 0;
 
     const ApplicationEvent *mControllerEvent[HAND_COUNT];
+    std::atomic<uint32_t> mInputEventMask{INPUT_EVENT_MASK_DEFAULT};
 
 };
 
@@ -84,13 +105,17 @@ std::shared_ptr<IApplication> createApplication(const std::shared_ptr<struct Opt
 
 Application::Application(const std::shared_ptr<struct Options>& options, const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin) {
     mGraphicsPlugin = graphicsPlugin;
+    mGuiLayer = options->GuiLayer;
     mController = std::make_shared<Controller>();
     mEyeTrackingRay = std::make_shared<Ray>();
     mPanel = std::make_shared<Gui>("dashboard");
-    mTextRender = std::make_shared<Text>();
+    mTextRender = std::make_shared<Text>(glyphMode_Sdf);
     mPlayer = std::make_shared<Player>();
     mHapticCallback = nullptr;
     mCubeRender = std::make_shared<CubeRender>();
+    for (auto hand = 0; hand < HAND_COUNT; hand++) {
+        mControllerPose[hand] = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+    }
 }
 
 Application::~Application() {
@@ -130,23 +155,34 @@ bool Application::initialize(const XrInstance instance, const XrSession session,
     m_extentions = extentions;
 
     // get device model
-    char buffer[64] = {0};
-    __system_property_get("sys.pxr.product.name", buffer);
-    mDeviceModel = buffer;
+    mDeviceModel = getSystemProperty("sys.pxr.product.name");
 
     //get OS version
-    __system_property_get("ro.build.id", buffer);
-    //__system_property_get("ro.system.build.id", buffer); // You can also call this function, the result is the same
-    mDeviceOS = buffer;
+    mDeviceOS = getSystemProperty("ro.build.id");
+    //getSystemProperty("ro.system.build.id"); // You can also call this function, the result is the same
+
+    // must be set before the renderers compile their shaders
+    Shader::setEyeViewCount(m_extentions->activeMultiview ? EYE_COUNT : 1);
+    LateLatch::instance().initialize();
 
     mController->initialize(mDeviceModel);
     mEyeTrackingRay->initialize();
     mPanel->initialize(600, 800);  //set resolution
+    mPanel->setDrawCursor(mGuiLayer);
     mTextRender->initialize();
     mCubeRender->initialize();
 
+#ifdef XR_USE_PLATFORM_ANDROID
     const XrGraphicsBindingOpenGLESAndroidKHR *binding = reinterpret_cast<const XrGraphicsBindingOpenGLESAndroidKHR*>(mGraphicsPlugin->GetGraphicsBinding());
+#else
+    const XrGraphicsBindingEGLMNDX *binding = reinterpret_cast<const XrGraphicsBindingEGLMNDX*>(mGraphicsPlugin->GetGraphicsBinding());
+#endif
     mPlayer->initialize(binding->display);
+#ifdef XR_USE_PLATFORM_ANDROID
+    if (m_extentions->activeVideoLayer) {
+        mPlayer->setSurfaceSwapchain(m_session, m_extentions->xrCreateSwapchainAndroidSurfaceKHR);
+    }
+#endif
 
     getAllVideoFiles("/sdcard", mAllVideoFiles);
 
@@ -177,7 +213,8 @@ void Application::setControllerPose(int leftright, const XrPosef& pose) {
 void Application::setGazeLocation(XrSpaceLocation& gazeLocation, std::vector<XrView>& views, float ipd, XrResult result) {
     mIpd = ipd;
     memcpy(&m_gazeLocation, &gazeLocation, sizeof(gazeLocation));
-    m_views = views;
+    mViewCount = std::min((uint32_t)views.size(), (uint32_t)EYE_COUNT);
+    std::copy(views.begin(), views.begin() + mViewCount, m_views);
 }
 
 void Application::setHandJointLocation(XrHandJointLocationEXT* location) {
@@ -208,6 +245,10 @@ void Application::inputEvent(int leftright, const ApplicationEvent& event) {
 
 }
 
+uint32_t Application::inputEventMask() const {
+    return mInputEventMask;
+}
+
 void Application::layout() {
     glm::mat4 model = glm::mat4(1.0f);
     float scale = 1.0f;
@@ -256,8 +297,10 @@ void Application::showDashboardController() {
                                                 ImGui::Text("true");\
                                             }  
 
-    //controller event
-    if (ImGui::CollapsingHeader("controller")) {
+    //controller event, the table shows every event, otherwise only menu and trigger clicks are needed
+    const bool showControllerEvent = ImGui::CollapsingHeader("controller");
+    mInputEventMask = showControllerEvent ? CONTROLLER_EVENT_BIT_all : INPUT_EVENT_MASK_DEFAULT;
+    if (showControllerEvent) {
         const float TEXT_BASE_WIDTH = ImGui::CalcTextSize("A").x;
         const float TEXT_BASE_HEIGHT = ImGui::GetTextLineHeightWithSpacing();
         static ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY;
@@ -305,12 +348,65 @@ void Application::showDashboardController() {
     }
 }
 
-void Application::showDashboard(const glm::mat4& project, const glm::mat4& view) {
+void Application::showDashboardProfiler() {
+    if (!ImGui::CollapsingHeader("profiler")) {
+        return;
+    }
+    Profiler& profiler = Profiler::instance();
+    const uint32_t offset = profiler.historyOffset();
+    ImGui::Text("display period: %.2f ms, missed frames: %u", profiler.displayPeriodMs(), profiler.missedFrames());
+    ImGui::Text("gl state calls: %u issued, %u skipped", GLState::instance().issuedCalls(), GLState::instance().skippedCalls());
+    ImGui::Text("culling: %u of %u bounds outside the view", mRenderQueue.culledBounds(), mRenderQueue.testedBounds());
+    const float* frameTime = profiler.frameHistory();
+    ImGui::PlotHistogram("frame", frameTime, PROFILE_HISTORY_FRAMES, offset, FrameFmt("%.2f ms", frameTime[(offset + PROFILE_HISTORY_FRAMES - 1) % PROFILE_HISTORY_FRAMES]),
+                         0.0f, profiler.displayPeriodMs() * 2.0f, ImVec2(0.0f, 60.0f));
+    for (uint32_t i = 0; i < profileMarker_Count; i++) {
+        const float* history = profiler.history(i);
+        float average = 0.0f;
+        for (uint32_t j = 0; j < PROFILE_HISTORY_FRAMES; j++) {
+            average += history[j];
+        }
+        average /= PROFILE_HISTORY_FRAMES;
+        ImGui::PlotLines(Profiler::markerName(i), history, PROFILE_HISTORY_FRAMES, offset, FrameFmt("avg %.2f ms", average), 0.0f, FLT_MAX, ImVec2(0.0f, 30.0f));
+    }
+
+    // GPU times of the renderers, per eye, and of multiview passes and the offscreen gui pass
+    const float TEXT_BASE_HEIGHT = ImGui::GetTextLineHeightWithSpacing();
+    static ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders;
+    if (ImGui::BeginTable("gpu time", 4, flags, ImVec2(0.0f, TEXT_BASE_HEIGHT * (gpuMarker_Count + 1)), 0.0f)) {
+        ImGui::TableSetupColumn("gpu (ms)",  ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthStretch, 0.0f);
+        ImGui::TableSetupColumn("left eye",  ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthFixed,   0.0f);
+        ImGui::TableSetupColumn("right eye", ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthFixed,   0.0f);
+        ImGui::TableSetupColumn("both",      ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthFixed,   0.0f);
+        ImGui::TableHeadersRow();
+        for (uint32_t i = 0; i < gpuMarker_Count; i++) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", Profiler::gpuMarkerName(i));
+            for (int32_t view = 0; view < PROFILE_GPU_VIEWS; view++) {
+                const float* history = profiler.gpuHistory(i, view);
+                float average = 0.0f;
+                for (uint32_t j = 0; j < PROFILE_HISTORY_FRAMES; j++) {
+                    average += history[j];
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", average / PROFILE_HISTORY_FRAMES);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("dump frame timeline")) {
+        profiler.requestDump("/sdcard/frame_timeline.csv");
+    }
+}
+
+void Application::updateDashboard() {
 
     // get refreshrate
     uint32_t count = 0;
     m_extentions->xrEnumerateDisplayRefreshRatesFB(m_session, 0, &count, nullptr);
-    std::vector<float> refreshRate(count);
+    FrameVector<float> refreshRate(count);
     m_extentions->xrEnumerateDisplayRefreshRatesFB(m_session, count, &count, refreshRate.data());
     float currentreFreshRate = 0;
     m_extentions->xrGetDisplayRefreshRateFB(m_session, &currentreFreshRate);
@@ -344,12 +440,18 @@ void Application::showDashboard(const glm::mat4& project, const glm::mat4& view)
         if (ImGui::BeginTable("split", 2)) {
             ImGui::TableNextColumn(); ImGui::Checkbox("XR_FB_passthrough", &m_extentions->activePassthrough);
             if (m_extentions->isSupportEyeTracking) {
-                ImGui::TableNextColumn(); ImGui::Checkbox("Eye Tracking", &m_extentions->activeEyeTracking);
+                bool activeEyeTracking = m_extentions->activeEyeTracking;
+                ImGui::TableNextColumn();
+                if (ImGui::Checkbox("Eye Tracking", &activeEyeTracking)) {
+                    m_extentions->activeEyeTracking = activeEyeTracking;
+                }
             }
             ImGui::EndTable();
         }
     }
 
+    showDashboardProfiler();
+
     int32_t selectFileIndex = -1;
     if (ImGui::CollapsingHeader("video player")) {
         ImGui::SeparatorText("play model");
@@ -373,7 +475,7 @@ void Application::showDashboard(const glm::mat4& project, const glm::mat4& view)
                 for (int32_t i = 0; i < mAllVideoFiles.size(); i++) {
                     ImGui::TableNextRow();
                     ImGui::TableNextColumn();
-                    if (ImGui::Selectable(Fmt("%02d", i).c_str(), true, ImGuiSelectableFlags_SpanAllColumns)) {
+                    if (ImGui::Selectable(FrameFmt("%02d", i), true, ImGuiSelectableFlags_SpanAllColumns)) {
                         selectFileIndex = i;
                     }
                     ImGui::TableNextColumn();
@@ -391,7 +493,7 @@ void Application::showDashboard(const glm::mat4& project, const glm::mat4& view)
     ImGui::Text("This is some useful text.");
 
     mPanel->end();
-    mPanel->render(project, view);
+    mPanelChanged = mPanel->update();
 
     mPlayer->setPlayStyle(playModel);
 
@@ -400,7 +502,7 @@ void Application::showDashboard(const glm::mat4& project, const glm::mat4& view)
     }
 }
 
-void Application::showDeviceInformation(const glm::mat4& project, const glm::mat4& view) {
+void Application::showDeviceInformation() {
     wchar_t text[1024] = {0};
     swprintf(text, 1024, L"model: %s, OS: %s", mDeviceModel.c_str(), mDeviceOS.c_str());
 
@@ -408,7 +510,7 @@ void Application::showDeviceInformation(const glm::mat4& project, const glm::mat
     model = glm::translate(model, glm::vec3(0.5f, -0.6f, -1.0f));
     model = glm::rotate(model, glm::radians(-30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     model = glm::scale(model, glm::vec3(0.5, 0.5, 1.0f));
-    mTextRender->render(project, view, model, text, wcslen(text), glm::vec3(1.0, 1.0, 1.0));
+    mTextRender->submit(mRenderQueue, model, text, wcslen(text), glm::vec3(1.0, 1.0, 1.0));
 }
 
 float Application::angleBetweenVectorAndPlane(const glm::vec3& vector, const glm::vec3& normal) {
@@ -425,9 +527,9 @@ float Application::angleBetweenVectorAndPlane(const glm::vec3& vector, const glm
     return PI/2 - angleRadians;
 }
 
-void Application::renderEyeTracking(const glm::mat4& project, const glm::mat4& view, int32_t eye) {
+void Application::renderEyeTracking(int32_t eye) {
     if (m_extentions->isSupportEyeTracking && m_extentions->activeEyeTracking) {
-        if (m_views.size() == 0) {
+        if (mViewCount == 0) {
             return;
         }
 
@@ -438,6 +540,10 @@ void Application::renderEyeTracking(const glm::mat4& project, const glm::mat4& v
         float halfIpd = mIpd / 2;
         if (eye == EYE_LEFT) {
             halfIpd = 0 - halfIpd;
+        } else if (eye == EYE_COUNT) {
+            // one ray for both eyes in a multiview pass, from the center of the eyes
+            halfIpd = 0;
+            eye = EYE_LEFT;
         }
         model = glm::translate(model, glm::vec3(halfIpd, 0.0f, -0.2f));
         model = glm::scale(model, glm::vec3(1.0, 1.0, 1.0f));
@@ -474,53 +580,170 @@ void Application::renderEyeTracking(const glm::mat4& project, const glm::mat4& v
 
         //infof("angleAndYOZ:%f, angleAndXOZ:%f", angleAndYOZ, angleAndXOZ);
 
-        mEyeTrackingRay->render(project, view, model);
+        mEyeTrackingRay->submit(mRenderQueue, model, -1, glm::vec3(model[3]));
 
         // show the coordinates
         wchar_t text[1024] = {0};
         swprintf(text, 1024, L"x:%0.2f, y:%0.2f", x, y);
         model = glm::translate(model, glm::vec3(-0.2f, 0.0f, -1.5f));
         model = glm::scale(model, glm::vec3(0.5, 0.5, 0.5f));
-        mTextRender->render(project, view, model, text, wcslen(text), glm::vec3(1.0, 1.0, 1.0));
+        mTextRender->submit(mRenderQueue, model, text, wcslen(text), glm::vec3(1.0, 1.0, 1.0));
     }
 }
 
-void Application::renderHandTracking(const glm::mat4& project, const glm::mat4& view) {
-    std::vector<CubeRender::Cube> cubes;
+void Application::renderHandTracking() {
+    // raw joint poses, the cube shader builds the transforms
+    const bool lateLatch = LateLatch::instance().isActive();
+    FrameVector<CubeRender::Cube> cubes;
+    cubes.reserve(HAND_COUNT * XR_HAND_JOINT_COUNT_EXT);
     for (auto hand = 0; hand < HAND_COUNT; hand++) {
         for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
             XrHandJointLocationEXT& jointLocation = m_jointLocations[hand][i];
             if (jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT && jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT) {
-
-                XrMatrix4x4f m{};
-                XrVector3f scale{1.0f, 1.0f, 1.0f};
-                XrMatrix4x4f_CreateTranslationRotationScale(&m, &jointLocation.pose.position, &jointLocation.pose.orientation, &scale);
-                glm::mat4 model = glm::make_mat4((float*)&m);
-
+                const XrPosef& pose = jointLocation.pose;
                 CubeRender::Cube cube;
-                cube.model = model;
+                cube.orientation = lateLatch ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w);
+                cube.position = lateLatch ? glm::vec3(0.0f) : glm::vec3(pose.position.x, pose.position.y, pose.position.z);
                 cube.scale = 0.01f;
+                cube.latchIndex = lateLatch ? LATE_LATCH_JOINT(hand, i) : -1;
                 cubes.push_back(cube);
             }
         }
     }
-    mCubeRender->render(project, view, cubes);
+    mCubeRender->submit(mRenderQueue, cubes.data(), cubes.size());
 }
 
-void Application::renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) {
+void Application::update(const FrameState& frameState) {
+    mRenderQueue.endFrame();
+    GlyphAtlas::instance().upload(GLYPH_ATLAS_UPLOAD_BUDGET_MS);
+    mPlayer->update();
     layout();
-    showDeviceInformation(project, view);
-
-    mPlayer->render(project, view, eye);
 
+    mPanelChanged = false;
     if (mIsShowDashboard) {
-        showDashboard(project, view);
+        mPanel->setDeltaTime(frameState.predictedDisplayPeriod * 1e-9f);
+        updateDashboard();
+    } else {
+        mInputEventMask = INPUT_EVENT_MASK_DEFAULT;
     }
+}
 
-    renderEyeTracking(project, view, eye);
-    
-    mController->render(project, view);
+bool Application::panelLayer(PanelLayer& layer) {
+    if (!mGuiLayer || !mIsShowDashboard) {
+        return false;
+    }
+    // the same model isIntersectWithLine tests against, the panel quad spans -1..1 in model space
+    layer.pose = quadLayerPose(mPanel->model(), 2.0f, layer.size);
 
-    renderHandTracking(project, view);
+    float width, height;
+    mPanel->getWidthHeight(width, height);
+    layer.width = (int32_t)width;
+    layer.height = (int32_t)height;
+    layer.texture = mPanel->texture();
+    layer.changed = mPanelChanged;
+    return true;
+}
+
+uint32_t Application::videoLayers(XrSpace space, XrCompositionLayerBaseHeader** layers) {
+    return mPlayer->layers(space, layers);
+}
 
+// Copies the latest controller and hand joint poses into a fresh LateLatch slot, right before the draws of a view
+void Application::writeLateLatch() {
+    LateLatch& lateLatch = LateLatch::instance();
+    if (!lateLatch.isActive()) {
+        return;
+    }
+    lateLatch.begin();
+    glm::mat4* poses = lateLatch.poses();
+    XrMatrix4x4f m{};
+    XrVector3f scale{1.0f, 1.0f, 1.0f};
+    for (auto hand = 0; hand < HAND_COUNT; hand++) {
+        XrMatrix4x4f_CreateTranslationRotationScale(&m, &mControllerPose[hand].position, &mControllerPose[hand].orientation, &scale);
+        poses[LATE_LATCH_AIM(hand)] = glm::make_mat4((float*)&m);
+        for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+            const XrPosef& joint = m_jointLocations[hand][i].pose;
+            XrMatrix4x4f_CreateTranslationRotationScale(&m, &joint.position, &joint.orientation, &scale);
+            poses[LATE_LATCH_JOINT(hand, i)] = glm::make_mat4((float*)&m);
+        }
+    }
+}
+
+void Application::renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) {
+    Profiler::instance().setGpuView(eye);
+    GPU_PROFILE_SCOPE(gpuMarker_View);
+    writeLateLatch();
+    mRenderQueue.begin(&project, &view, 1);
+
+    {
+        PROFILE_SCOPE(profileMarker_Text);
+        mRenderQueue.setMarker(profileMarker_Text);
+        showDeviceInformation();
+    }
+    {
+        PROFILE_SCOPE(profileMarker_Player);
+        mRenderQueue.setMarker(profileMarker_Player);
+        mPlayer->submit(mRenderQueue, eye);
+    }
+    if (mIsShowDashboard && !mGuiLayer) {
+        PROFILE_SCOPE(profileMarker_Gui);
+        mRenderQueue.setMarker(profileMarker_Gui);
+        mPanel->submit(mRenderQueue);
+    }
+    {
+        PROFILE_SCOPE(profileMarker_EyeTracking);
+        mRenderQueue.setMarker(profileMarker_EyeTracking);
+        renderEyeTracking(eye);
+    }
+    {
+        PROFILE_SCOPE(profileMarker_Controller);
+        mRenderQueue.setMarker(profileMarker_Controller);
+        mController->submit(mRenderQueue, LateLatch::instance().isActive());
+    }
+    {
+        PROFILE_SCOPE(profileMarker_Hand);
+        mRenderQueue.setMarker(profileMarker_Hand);
+        renderHandTracking();
+    }
+    mRenderQueue.execute();
+}
+
+void Application::renderFrameMultiview(const XrPosef* pose, const glm::mat4* project, const glm::mat4* view) {
+    // Every renderer reads project[0..EYE_COUNT) and view[0..EYE_COUNT) and draws both eyes at once.
+    Profiler::instance().setGpuView(EYE_COUNT);
+    GPU_PROFILE_SCOPE(gpuMarker_View);
+    writeLateLatch();
+    mRenderQueue.begin(project, view, EYE_COUNT);
+
+    {
+        PROFILE_SCOPE(profileMarker_Text);
+        mRenderQueue.setMarker(profileMarker_Text);
+        showDeviceInformation();
+    }
+    {
+        PROFILE_SCOPE(profileMarker_Player);
+        mRenderQueue.setMarker(profileMarker_Player);
+        mPlayer->submit(mRenderQueue, EYE_LEFT);
+    }
+    if (mIsShowDashboard && !mGuiLayer) {
+        PROFILE_SCOPE(profileMarker_Gui);
+        mRenderQueue.setMarker(profileMarker_Gui);
+        mPanel->submit(mRenderQueue);
+    }
+    {
+        PROFILE_SCOPE(profileMarker_EyeTracking);
+        mRenderQueue.setMarker(profileMarker_EyeTracking);
+        renderEyeTracking(EYE_COUNT);
+    }
+    {
+        PROFILE_SCOPE(profileMarker_Controller);
+        mRenderQueue.setMarker(profileMarker_Controller);
+        mController->submit(mRenderQueue, LateLatch::instance().isActive());
+    }
+    {
+        PROFILE_SCOPE(profileMarker_Hand);
+        mRenderQueue.setMarker(profileMarker_Hand);
+        renderHandTracking();
+    }
+    mRenderQueue.execute();
 }
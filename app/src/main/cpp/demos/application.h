@@ -1,5 +1,6 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #pragma once
+#include <atomic>
 #include <memory>
 #include "glm/glm.hpp"
 #include <openxr/openxr.h>
@@ -23,6 +24,7 @@
 #define CONTROLLER_EVENT_BIT_touch_b          0x00008000
 #define CONTROLLER_EVENT_BIT_touch_x          0x00010000
 #define CONTROLLER_EVENT_BIT_touch_y          0x00020000
+#define CONTROLLER_EVENT_BIT_all              0x0003fff7
 
 //system and shot button cannot be use in application
 typedef struct {
@@ -48,6 +50,24 @@ typedef struct {
     bool touch_y;          //true:touch false:none touch
 }ApplicationEvent;
 
+//timing of the frame being prepared, passed to IApplication::update once per frame
+typedef struct {
+    XrTime predictedDisplayTime;
+    XrDuration predictedDisplayPeriod;  //nanoseconds
+}FrameState;
+
+//dashboard submitted as a quad composition layer, filled by IApplication::panelLayer after update
+typedef struct {
+    XrPosef pose;          //center of the panel in the application space, facing +z
+    XrExtent2Df size;      //meters
+    int32_t width;         //pixels of texture
+    int32_t height;
+    uint32_t texture;      //GL_TEXTURE_2D holding the panel
+    bool changed;          //texture was redrawn by this frame's update
+}PanelLayer;
+
+#define APPLICATION_MAX_VIDEO_LAYERS 2   //one per eye for stereo video
+
 #define PFN_DECLARE(pfn) PFN_##pfn pfn = nullptr
 #define PFN_INITIALIZE(pfn) CHECK_XRCMD(xrGetInstanceProcAddr(m_instance, #pfn, (PFN_xrVoidFunction*)(&pfn)))
 
@@ -56,18 +76,30 @@ typedef struct Extentions_tag{
     PFN_DECLARE(xrEnumerateDisplayRefreshRatesFB);
     PFN_DECLARE(xrGetDisplayRefreshRateFB);
     PFN_DECLARE(xrRequestDisplayRefreshRateFB);
+#ifdef XR_USE_PLATFORM_ANDROID
+    //XR_KHR_android_surface_swapchain
+    PFN_DECLARE(xrCreateSwapchainAndroidSurfaceKHR);
+#endif
 
     bool activePassthrough;     //XR_FB_passthrough
     bool isSupportEyeTracking;  //eye tracking
-    bool activeEyeTracking;
+    std::atomic<bool> activeEyeTracking;   //toggled by the dashboard on the render thread, read by the simulation thread
+    bool activeMultiview;       //GL_OVR_multiview2, both eyes are rendered by renderFrameMultiview
+    bool activeVideoLayer;      //XR_KHR_android_surface_swapchain and XR_KHR_composition_layer_equirect2, see Options::VideoLayer
     
-    Extentions_tag(): activePassthrough(true), isSupportEyeTracking(false), activeEyeTracking(false) {}
+    Extentions_tag(): activePassthrough(true), isSupportEyeTracking(false), activeEyeTracking(false), activeMultiview(false), activeVideoLayer(false) {}
 
     void initialize(XrInstance m_instance) {
         //XR_FB_display_refresh_rate
         PFN_INITIALIZE(xrEnumerateDisplayRefreshRatesFB);
         PFN_INITIALIZE(xrGetDisplayRefreshRateFB);
         PFN_INITIALIZE(xrRequestDisplayRefreshRateFB);
+#ifdef XR_USE_PLATFORM_ANDROID
+        //XR_KHR_android_surface_swapchain
+        if (activeVideoLayer) {
+            PFN_INITIALIZE(xrCreateSwapchainAndroidSurfaceKHR);
+        }
+#endif
     }
 }Extentions;
 
@@ -83,7 +115,19 @@ public:
     virtual void setGazeLocation(XrSpaceLocation& gazeLocation, std::vector<XrView>& views, float ipd, XrResult result = XR_SUCCESS) = 0;
     virtual void setHandJointLocation(XrHandJointLocationEXT* location) = 0;
     virtual void inputEvent(int leftright, const ApplicationEvent& event) = 0;
+    // CONTROLLER_EVENT_BIT_* the application reads right now, the actions behind the other bits are not polled.
+    // May be called from the simulation thread.
+    virtual uint32_t inputEventMask() const = 0;
+    // runs once per frame before any eye is rendered, renderFrame/renderFrameMultiview only draw
+    virtual void update(const FrameState& frameState) = 0;
+    // false when no panel is shown this frame. Only with Options::GuiLayer, renderFrame then leaves the panel out.
+    virtual bool panelLayer(PanelLayer& layer) = 0;
+    // Composition layers presenting the video, drawn under the projection layer, at most APPLICATION_MAX_VIDEO_LAYERS.
+    // Only with Extentions::activeVideoLayer, returns their count, 0 while the video is drawn by renderFrame.
+    virtual uint32_t videoLayers(XrSpace space, XrCompositionLayerBaseHeader** layers) = 0;
     virtual void renderFrame(const XrPosef& pose, const glm::mat4& project, const glm::mat4& view, int32_t eye) = 0;
+    // single pass stereo, pose/project/view hold one element per eye
+    virtual void renderFrameMultiview(const XrPosef* pose, const glm::mat4* project, const glm::mat4* view) = 0;
 };
 
 struct Options;
@@ -0,0 +1,49 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include "cameraBuffer.h"
+
+CameraBuffer& CameraBuffer::instance() {
+    static CameraBuffer cameraBuffer;
+    return cameraBuffer;
+}
+
+CameraBuffer::CameraBuffer() : mBuffer(0), mSlotSize(0), mSlot(-1) {
+}
+
+CameraBuffer::~CameraBuffer() {
+    if (mBuffer) {
+        glDeleteBuffers(1, &mBuffer);
+    }
+}
+
+bool CameraBuffer::initialize() {
+    GLint alignment = 256;
+    GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    mSlotSize = (sizeof(CameraBlock) + alignment - 1) / alignment * alignment;
+
+    GL_CALL(glGenBuffers(1, &mBuffer));
+    GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, mBuffer));
+    GL_CALL(glBufferData(GL_UNIFORM_BUFFER, mSlotSize * CAMERA_SLOT_COUNT, nullptr, GL_DYNAMIC_DRAW));
+    GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    return mBuffer != 0;
+}
+
+void CameraBuffer::update(const glm::mat4* projection, const glm::mat4* view, uint32_t viewCount, int32_t firstEye) {
+    if (mBuffer == 0 && !initialize()) {
+        return;
+    }
+
+    CameraBlock block = {};
+    for (uint32_t i = 0; i < viewCount && i < EYE_COUNT; i++) {
+        block.view[i] = view[i];
+        block.projection[i] = projection[i];
+        block.viewProjection[i] = projection[i] * view[i];
+        block.position[i] = glm::inverse(view[i])[3];
+        block.eye[i] = glm::ivec4(firstEye + (int32_t)i, 0, 0, 0);
+    }
+
+    mSlot = (mSlot + 1) % CAMERA_SLOT_COUNT;
+    GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, mBuffer));
+    GL_CALL(glBufferSubData(GL_UNIFORM_BUFFER, mSlotSize * mSlot, sizeof(CameraBlock), &block));
+    GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    GL_CALL(glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, mBuffer, mSlotSize * mSlot, sizeof(CameraBlock)));
+}
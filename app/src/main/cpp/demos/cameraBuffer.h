@@ -0,0 +1,46 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stdint.h>
+#include "glm/glm.hpp"
+#include "common/gfxwrapper_opengl.h"
+#include "utils.h"
+
+// Uniform block with the cameras of the view being rendered, Shader::loadShader declares it in every vertex shader:
+//     layout(std140, binding = CAMERA_BINDING) uniform Camera {
+//         mat4 cameraView[EYE_COUNT];
+//         mat4 cameraProjection[EYE_COUNT];
+//         mat4 cameraViewProjection[EYE_COUNT];
+//         vec4 cameraPosition[EYE_COUNT];  // world space, w = 1
+//         ivec4 cameraEye[EYE_COUNT];      // x: EYE_LEFT or EYE_RIGHT
+//     };
+// Index it by VIEW_ID: entry 0 is the eye being rendered without multiview, entries 0 and 1 are the left and
+// right eye in a multiview pass.
+#define CAMERA_BINDING 0
+#define CAMERA_SLOT_COUNT 8
+
+typedef struct {
+    glm::mat4 view[EYE_COUNT];
+    glm::mat4 projection[EYE_COUNT];
+    glm::mat4 viewProjection[EYE_COUNT];
+    glm::vec4 position[EYE_COUNT];
+    glm::ivec4 eye[EYE_COUNT];
+}CameraBlock;
+
+// Ring of Camera blocks in one uniform buffer. Every view writes the next slot with glBufferSubData, so the
+// block a view's draws read is not overwritten by the next view's update. The ring is not fenced; the driver
+// orders each write after the draws that read the slot before.
+class CameraBuffer {
+public:
+    static CameraBuffer& instance();
+    ~CameraBuffer();
+    // Writes viewCount cameras, the first one for firstEye, into the next slot and binds it to CAMERA_BINDING.
+    // Called by the graphics plugin once per view before the renderers draw it.
+    void update(const glm::mat4* projection, const glm::mat4* view, uint32_t viewCount, int32_t firstEye);
+
+private:
+    CameraBuffer();
+    bool initialize();
+    GLuint mBuffer;
+    GLsizeiptr mSlotSize;
+    int32_t mSlot;
+};
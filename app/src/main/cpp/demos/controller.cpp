@@ -1,6 +1,7 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #include <memory>
 #include "controller.h"
+#include "lateLatch.h"
 
 
 ControllerBase::ControllerBase(std::string name) {
@@ -24,24 +25,19 @@ void ControllerBase::setModel(const glm::mat4& model) {
     mControllerModel = model;
     mRayModel = model;
 }
-bool ControllerBase::render(const glm::mat4& p, const glm::mat4& v) {
+bool ControllerBase::render(int32_t latchIndex) {
+    const glm::mat4 pose = latchIndex >= 0 ? glm::mat4(1.0f) : mControllerModel;
     glm::mat4 model = glm::mat4(1.0f);
-    model = glm::scale(mControllerModel, glm::vec3(mControllerDefaultScale, mControllerDefaultScale, mControllerDefaultScale));
-    mController->render(p, v, model);
+    model = glm::scale(pose, glm::vec3(mControllerDefaultScale, mControllerDefaultScale, mControllerDefaultScale));
+    mController->render(model, latchIndex);
 
     model = glm::mat4(1.0f);
-    model = glm::scale(mControllerModel, glm::vec3(mControllerRayDefaultScale, mControllerRayDefaultScale, mControllerRayDefaultScale));
-    mControllerRay->render(p, v, model);
+    model = glm::scale(pose, glm::vec3(mControllerRayDefaultScale, mControllerRayDefaultScale, mControllerRayDefaultScale));
+    mControllerRay->render(model, latchIndex);
     return true;
 }
 glm::vec3 ControllerBase::getRayDirection() {
-    std::vector<glm::vec3> raypoints = mControllerRay->getPoints();
-    if (raypoints.size() > 1) {
-        glm::vec4 p1 = mRayModel * glm::vec4(raypoints[0], 1.0f);
-        glm::vec4 p2 = mRayModel * glm::vec4(raypoints[1], 1.0f);
-        return glm::normalize(glm::vec3(p2 - p1));
-    }
-    return glm::vec3(0.0f, 0.0f, 0.0f);
+    return mControllerRay->getDirectionVector(mRayModel);
 }
 
 /// @brief /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -158,9 +154,30 @@ void Controller::setModel(int leftright, const glm::mat4& m) {
     }
 }
 
-void Controller::render(const glm::mat4& p, const glm::mat4& v) {
-    mLeftController->render(p, v);
-    mRightController->render(p, v);
+PoseInstance ControllerBase::submit(RenderQueue& queue, int32_t latchIndex) {
+    const glm::mat4 pose = latchIndex >= 0 ? glm::mat4(1.0f) : mControllerModel;
+    // a latched pose is only known to the GPU, the last one set culls and orders the draws
+    const glm::vec3 controllerScale = glm::vec3(mControllerDefaultScale, mControllerDefaultScale, mControllerDefaultScale);
+    glm::mat4 model = glm::scale(pose, controllerScale);
+    mController->submit(queue, model, latchIndex, glm::scale(mControllerModel, controllerScale));
+
+    model = glm::scale(pose, glm::vec3(mControllerRayDefaultScale, mControllerRayDefaultScale, mControllerRayDefaultScale));
+    return Ray::pose(model, latchIndex);
+}
+
+void Controller::render(bool lateLatch) {
+    mLeftController->render(lateLatch ? LATE_LATCH_AIM(HAND_LEFT) : -1);
+    mRightController->render(lateLatch ? LATE_LATCH_AIM(HAND_RIGHT) : -1);
+}
+
+void Controller::submit(RenderQueue& queue, bool lateLatch) {
+    // both rays in one instanced draw, ordered by the point between the controllers
+    PoseInstance rays[HAND_COUNT];
+    rays[HAND_LEFT] = mLeftController->submit(queue, lateLatch ? LATE_LATCH_AIM(HAND_LEFT) : -1);
+    rays[HAND_RIGHT] = mRightController->submit(queue, lateLatch ? LATE_LATCH_AIM(HAND_RIGHT) : -1);
+    const glm::vec3 colors[HAND_COUNT] = {glm::vec3(1.0f), glm::vec3(1.0f)};
+    const glm::vec3 position = (glm::vec3(mLeftController->mControllerModel[3]) + glm::vec3(mRightController->mControllerModel[3])) * 0.5f;
+    mLeftController->mControllerRay->submit(queue, rays, colors, HAND_COUNT, position);
 }
 
 glm::vec3 Controller::getRayDirection(int leftright) {
@@ -12,7 +12,10 @@ public:
     void setModelFile(const std::string& modelFile);
     bool loadModelFile();
     void setModel(const glm::mat4& model);
-    bool render(const glm::mat4& p, const glm::mat4& v);
+    // latchIndex >= 0 places the controller and its ray at that pose of the LateLatch block
+    bool render(int32_t latchIndex = -1);
+    // queues the controller model and returns the pose of its ray, Controller draws both rays at once
+    PoseInstance submit(RenderQueue& queue, int32_t latchIndex = -1);
     glm::vec3 getRayDirection();
     
 private:
@@ -44,7 +47,9 @@ public:
 	void setRightPowerValue(int power);
     void setLeftPowerValue(int power);
     void setModel(int leftright, const glm::mat4& m);
-    void render(const glm::mat4& p, const glm::mat4& v);
+    // lateLatch: read the controller poses from the LateLatch block instead of setModel()
+    void render(bool lateLatch = false);
+    void submit(RenderQueue& queue, bool lateLatch = false);
     glm::vec3 getRayDirection(int leftright);
 
 private:
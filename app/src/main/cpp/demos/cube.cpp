@@ -1,9 +1,15 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
 #include "cube.h"
 #include "utils.h"
+#include "profiler.h"
+#include "glState.h"
 #include "geometry.h"
 #include "glm/gtc/matrix_transform.hpp"
 
+#define CUBE_MAX_INSTANCES (HAND_COUNT * XR_HAND_JOINT_COUNT_EXT)
+#define CUBE_INSTANCE_LOCATION 2
+
 Shader CubeRender::mShader;
 CubeRender::CubeRender(): mFramebuffer(0), mVAO(0), mVBO(0) {
 }
@@ -21,13 +27,23 @@ bool CubeRender::initShader() {
             precision highp float;
             layout (location = 0) in vec3 position;
             layout (location = 1) in vec3 color;
+            // PoseInstance, see instanceBuffer.h
+            layout (location = 2) in vec4 instanceOrientation;
+            layout (location = 3) in vec4 instancePositionScale;
+            layout (location = 4) in int instanceLatchIndex;
             out vec3 fColor;
-            uniform mat4 model;
-            uniform mat4 view;
-            uniform mat4 projection;
+            layout(std140, binding = LATE_LATCH_BINDING) uniform LateLatch {
+                mat4 latchedPose[LATE_LATCH_POSE_COUNT];
+            };
+            vec3 rotate(vec4 q, vec3 v)
+            {
+                return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+            }
             void main()
             {
-                gl_Position = projection * view * model* vec4(position, 1.0);
+                vec4 local = vec4(rotate(instanceOrientation, position * instancePositionScale.w) + instancePositionScale.xyz, 1.0);
+                vec4 world = instanceLatchIndex >= 0 ? latchedPose[instanceLatchIndex] * local : local;
+                gl_Position = cameraViewProjection[VIEW_ID] * world;
                 fColor = color;
             }
         )_";
@@ -43,7 +59,7 @@ bool CubeRender::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, Shader::eyeViewCount()) == false) {
             return false;
         }
         init = true;
@@ -60,11 +76,11 @@ bool CubeRender::initialize() {
     //GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
 
     GL_CALL(glGenBuffers(1, &mCubeVertexBuffer));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer));
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer);
     GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices), Geometry::c_cubeVertices, GL_STATIC_DRAW));
 
     GL_CALL(glGenBuffers(1, &mCubeIndexBuffer));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer));
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer);
     GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), Geometry::c_cubeIndices, GL_STATIC_DRAW));
 
 
@@ -72,37 +88,52 @@ bool CubeRender::initialize() {
     GLint vertex_location_color = glGetAttribLocation(mShader.id(), "color");
 
     GL_CALL(glGenVertexArrays(1, &mVAO));
-    GL_CALL(glBindVertexArray(mVAO));
+    GLState::instance().bindVertexArray(mVAO);
     GL_CALL(glEnableVertexAttribArray(vertex_location_postion));
     GL_CALL(glEnableVertexAttribArray(vertex_location_color));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer));
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mCubeVertexBuffer);
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCubeIndexBuffer);
     GL_CALL(glVertexAttribPointer(vertex_location_postion, sizeof(XrVector3f) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr));
     GL_CALL(glVertexAttribPointer(vertex_location_color,   sizeof(XrVector3f) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), reinterpret_cast<const void*>(sizeof(XrVector3f))));
 
-    return true;
+    return mInstances.initialize(CUBE_INSTANCE_LOCATION, CUBE_MAX_INSTANCES);
 }
 
-void CubeRender::render(const glm::mat4& p, const glm::mat4& v, std::vector<Cube> &cubes) {
+void CubeRender::render(const Cube* cubes, size_t count) {
+    GPU_PROFILE_SCOPE(gpuMarker_Cube);
     mShader.use(); 
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    glEnable(GL_DEPTH_TEST);
-    glFrontFace(GL_CW);
-    glCullFace(GL_BACK);
-    GL_CALL(glBindVertexArray(mVAO));
-    for (const Cube& cube : cubes) {
-        // Compute the model-view-projection transform and set it..
-        //XrMatrix4x4f model;
-        //XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-        //XrMatrix4x4f mvp;
-        //XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-        //glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
-        glm::mat4 model = glm::scale(cube.model, glm::vec3(cube.scale, cube.scale, cube.scale));
-        mShader.setUniformMat4("model", model);
-
-        // Draw the cube.
-        GL_CALL(glDrawElements(GL_TRIANGLES, sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]), GL_UNSIGNED_SHORT, nullptr));
+    GLState::instance().enable(GL_DEPTH_TEST);
+    GLState::instance().frontFace(GL_CW);
+    GLState::instance().cullFace(GL_BACK);
+    GLState::instance().bindVertexArray(mVAO);
+    for (size_t first = 0; first < count;) {
+        const uint32_t instanceCount = mInstances.upload(cubes + first, (uint32_t)(count - first));
+        GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]), GL_UNSIGNED_SHORT, nullptr, instanceCount));
+        first += instanceCount;
+    }
+}
+
+typedef struct {
+    size_t count;
+    CubeRender::Cube cubes[1];
+}CubeParams;
+
+void CubeRender::submit(RenderQueue& queue, const Cube* cubes, size_t count) {
+    if (count == 0) {
+        return;
     }
-    GL_CALL(glBindVertexArray(0));
+    DrawPacket packet = {};
+    packet.pass = renderPass_Opaque;
+    packet.program = mShader.id();
+    packet.vertexArray = mVAO;
+    packet.draw = drawPacket;
+    packet.object = this;
+    CubeParams* params = (CubeParams*)queue.submit(packet, glm::vec3(0.0f), offsetof(CubeParams, cubes) + count * sizeof(Cube));
+    params->count = count;
+    memcpy(params->cubes, cubes, count * sizeof(Cube));
+}
+
+void CubeRender::drawPacket(const RenderQueue& queue, const DrawPacket& packet) {
+    const CubeParams* params = (const CubeParams*)packet.params;
+    ((CubeRender*)packet.object)->render(params->cubes, params->count);
 }
@@ -5,19 +5,22 @@
 #include <openxr/openxr.h>
 #include "common/gfxwrapper_opengl.h"
 #include "shader.h"
+#include "renderQueue.h"
+#include "instanceBuffer.h"
 
 class CubeRender {
 public:
     CubeRender();
     ~CubeRender();
     bool initialize();
-    struct Cube {
-        glm::mat4 model;
-        float scale;
-    };
-    void render(const glm::mat4& p, const glm::mat4& v, std::vector<Cube> &cubes);
+    // the cube is drawn as a unit cube scaled by Cube::scale, all cubes of a call as instances
+    typedef PoseInstance Cube;
+    void render(const Cube* cubes, size_t count);
+    // queued render, the cubes are copied
+    void submit(RenderQueue& queue, const Cube* cubes, size_t count);
 private:
     bool initShader();
+    static void drawPacket(const RenderQueue& queue, const DrawPacket& packet);
 private:
     static Shader mShader;
     GLuint mFramebuffer;
@@ -25,4 +28,5 @@ private:
     GLuint mCubeIndexBuffer;
     GLuint mVAO;
     GLuint mVBO;
+    InstanceBuffer mInstances;
 };
\ No newline at end of file
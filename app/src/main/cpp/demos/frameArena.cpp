@@ -0,0 +1,134 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include "frameArena.h"
+#include "utils.h"
+
+#define FRAME_ARENA_DEFAULT_CAPACITY (256 * 1024)
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena& FrameArena::instance() {
+    static FrameArena frameArena;
+    return frameArena;
+}
+
+FrameArena::FrameArena() : mCapacity(FRAME_ARENA_DEFAULT_CAPACITY), mOffset(0), mOverflowSize(0), mOverflow(nullptr) {
+    mBlock = (uint8_t*)malloc(mCapacity);
+}
+
+FrameArena::~FrameArena() {
+    reset();
+    free(mBlock);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    size_t offset = alignUp(mOffset, alignment);
+    if (offset + size <= mCapacity) {
+        mOffset = offset + size;
+        return mBlock + offset;
+    }
+    // Does not fit, fall back to the heap for this frame. The header links the block for reset().
+    size_t header = alignUp(sizeof(void*), alignment);
+    uint8_t* block = (uint8_t*)malloc(header + size);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *(void**)block = mOverflow;
+    mOverflow = block;
+    mOverflowSize += size + alignment;
+    return block + header;
+}
+
+void FrameArena::reset() {
+    while (mOverflow != nullptr) {
+        void* next = *(void**)mOverflow;
+        free(mOverflow);
+        mOverflow = next;
+    }
+    if (mOverflowSize > 0) {
+        size_t capacity = mCapacity;
+        while (capacity < mOffset + mOverflowSize) {
+            capacity *= 2;
+        }
+        infof("frame arena grows from %zu to %zu bytes", mCapacity, capacity);
+        free(mBlock);
+        mBlock = (uint8_t*)malloc(capacity);
+        mCapacity = capacity;
+        mOverflowSize = 0;
+    }
+    mOffset = 0;
+}
+
+size_t FrameArena::used() const {
+    return mOffset + mOverflowSize;
+}
+
+size_t FrameArena::capacity() const {
+    return mCapacity;
+}
+
+const char* FrameFmt(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int size = vsnprintf(nullptr, 0, fmt, argsCopy);
+    va_end(argsCopy);
+    if (size < 0) {
+        va_end(args);
+        return "";
+    }
+    char* text = (char*)FrameArena::instance().allocate(size + 1, 1);
+    vsnprintf(text, size + 1, fmt, args);
+    va_end(args);
+    return text;
+}
+
+#ifdef FRAME_ALLOCATION_COUNTER
+static thread_local bool sCountAllocations = false;
+static thread_local uint32_t sAllocationCount = 0;
+
+void AllocationCounter::begin() {
+    sAllocationCount = 0;
+    sCountAllocations = true;
+}
+
+uint32_t AllocationCounter::end() {
+    sCountAllocations = false;
+    return sAllocationCount;
+}
+
+// Replaces the global operator new so that allocations can be counted, the array and nothrow forms
+// of libc++ forward to this one.
+void* operator new(size_t size) {
+    if (sCountAllocations) {
+        sAllocationCount++;
+    }
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+// the sized form is picked by -fsized-deallocation, it has to free what the operator new above allocated
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+#else
+void AllocationCounter::begin() {
+}
+
+uint32_t AllocationCounter::end() {
+    return 0;
+}
+#endif
@@ -0,0 +1,64 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Linear allocator for data that only lives until the end of the current frame. Memory is handed out by
+// bumping an offset and released all at once by reset(), which the frame loop calls right after xrBeginFrame.
+// Only the thread that submits frames may use it.
+class FrameArena {
+public:
+    static FrameArena& instance();
+    ~FrameArena();
+    void* allocate(size_t size, size_t alignment = alignof(max_align_t));
+    // Releases everything allocated since the last reset. If the last frame did not fit, the block is
+    // grown here so the following frames stay inside one block.
+    void reset();
+    size_t used() const;
+    size_t capacity() const;
+
+private:
+    FrameArena();
+    uint8_t* mBlock;
+    size_t mCapacity;
+    size_t mOffset;
+    size_t mOverflowSize;
+    void* mOverflow;   // singly linked list of allocations that did not fit into mBlock
+};
+
+// std allocator on top of FrameArena, deallocate is a no-op. Containers using it must not outlive the frame
+// and should reserve() up front, since a grown buffer is only reclaimed by the next reset.
+template <typename T>
+struct FrameAllocator {
+    typedef T value_type;
+    FrameAllocator() = default;
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>&) {}
+    T* allocate(size_t n) {
+        return static_cast<T*>(FrameArena::instance().allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {}
+};
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) { return false; }
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// printf into frame memory, for labels that are only needed until the end of the frame
+const char* FrameFmt(const char* fmt, ...);
+
+// Debug counter of the global operator new calls made by the calling thread between begin() and end().
+// The frame loop uses it to report heap allocations between xrBeginFrame and xrEndFrame. Compiled in
+// for debug builds only, end() always returns 0 otherwise.
+#if !defined(NDEBUG)
+#define FRAME_ALLOCATION_COUNTER 1
+#endif
+class AllocationCounter {
+public:
+    static void begin();
+    static uint32_t end();
+};
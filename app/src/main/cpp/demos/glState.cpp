@@ -0,0 +1,294 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
+#include "glState.h"
+#include "utils.h"
+
+GLState& GLState::instance() {
+    static GLState state;
+    return state;
+}
+
+void GLState::initialize() {
+    GL_CALL(glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&mState.program));
+    GL_CALL(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&mState.vertexArray));
+    GL_CALL(glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&mState.arrayBuffer));
+    GL_CALL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, (GLint*)&mState.framebuffer));
+    GL_CALL(glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&mState.activeTexture));
+    for (uint32_t i = 0; i < GL_STATE_TEXTURE_UNITS; i++) {
+        GL_CALL(glActiveTexture(GL_TEXTURE0 + i));
+        GL_CALL(glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&mState.texture2D[i]));
+    }
+    GL_CALL(glActiveTexture(mState.activeTexture));
+    mState.blend = glIsEnabled(GL_BLEND);
+    mState.cullFace = glIsEnabled(GL_CULL_FACE);
+    mState.depthTest = glIsEnabled(GL_DEPTH_TEST);
+    mState.stencilTest = glIsEnabled(GL_STENCIL_TEST);
+    mState.scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    GL_CALL(glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&mState.blendSrcRgb));
+    GL_CALL(glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&mState.blendDstRgb));
+    GL_CALL(glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&mState.blendSrcAlpha));
+    GL_CALL(glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&mState.blendDstAlpha));
+    GL_CALL(glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&mState.blendEquationRgb));
+    GL_CALL(glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&mState.blendEquationAlpha));
+    GL_CALL(glGetIntegerv(GL_FRONT_FACE, (GLint*)&mState.frontFace));
+    GL_CALL(glGetIntegerv(GL_CULL_FACE_MODE, (GLint*)&mState.cullFaceMode));
+    GL_CALL(glGetBooleanv(GL_DEPTH_WRITEMASK, &mState.depthMask));
+    GL_CALL(glGetIntegerv(GL_VIEWPORT, mState.viewport));
+    GL_CALL(glGetIntegerv(GL_SCISSOR_BOX, mState.scissor));
+}
+
+bool GLState::changed(bool same) {
+    if (same) {
+        mSkipped++;
+        return false;
+    }
+    mIssued++;
+    return true;
+}
+
+bool* GLState::capability(GLenum cap) {
+    switch (cap) {
+        case GL_BLEND:        return &mState.blend;
+        case GL_CULL_FACE:    return &mState.cullFace;
+        case GL_DEPTH_TEST:   return &mState.depthTest;
+        case GL_STENCIL_TEST: return &mState.stencilTest;
+        case GL_SCISSOR_TEST: return &mState.scissorTest;
+        default:              return nullptr;
+    }
+}
+
+void GLState::setEnabled(GLenum cap, bool enabled) {
+    bool* state = capability(cap);
+    if (state != nullptr && !changed(*state == enabled)) {
+        return;
+    }
+    if (state != nullptr) {
+        *state = enabled;
+    }
+    if (enabled) {
+        GL_CALL(glEnable(cap));
+    } else {
+        GL_CALL(glDisable(cap));
+    }
+}
+
+void GLState::enable(GLenum cap) {
+    setEnabled(cap, true);
+}
+
+void GLState::disable(GLenum cap) {
+    setEnabled(cap, false);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst) {
+    blendFuncSeparate(src, dst, src, dst);
+}
+
+void GLState::blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    if (!changed(mState.blendSrcRgb == srcRgb && mState.blendDstRgb == dstRgb && mState.blendSrcAlpha == srcAlpha && mState.blendDstAlpha == dstAlpha)) {
+        return;
+    }
+    mState.blendSrcRgb = srcRgb;
+    mState.blendDstRgb = dstRgb;
+    mState.blendSrcAlpha = srcAlpha;
+    mState.blendDstAlpha = dstAlpha;
+    GL_CALL(glBlendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha));
+}
+
+void GLState::blendEquation(GLenum mode) {
+    blendEquationSeparate(mode, mode);
+}
+
+void GLState::blendEquationSeparate(GLenum modeRgb, GLenum modeAlpha) {
+    if (!changed(mState.blendEquationRgb == modeRgb && mState.blendEquationAlpha == modeAlpha)) {
+        return;
+    }
+    mState.blendEquationRgb = modeRgb;
+    mState.blendEquationAlpha = modeAlpha;
+    GL_CALL(glBlendEquationSeparate(modeRgb, modeAlpha));
+}
+
+void GLState::frontFace(GLenum mode) {
+    if (!changed(mState.frontFace == mode)) {
+        return;
+    }
+    mState.frontFace = mode;
+    GL_CALL(glFrontFace(mode));
+}
+
+void GLState::cullFace(GLenum mode) {
+    if (!changed(mState.cullFaceMode == mode)) {
+        return;
+    }
+    mState.cullFaceMode = mode;
+    GL_CALL(glCullFace(mode));
+}
+
+void GLState::depthMask(GLboolean flag) {
+    if (!changed(mState.depthMask == flag)) {
+        return;
+    }
+    mState.depthMask = flag;
+    GL_CALL(glDepthMask(flag));
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const GLint viewport[4] = {x, y, width, height};
+    if (!changed(memcmp(mState.viewport, viewport, sizeof(viewport)) == 0)) {
+        return;
+    }
+    memcpy(mState.viewport, viewport, sizeof(viewport));
+    GL_CALL(glViewport(x, y, width, height));
+}
+
+void GLState::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    const GLint scissor[4] = {x, y, width, height};
+    if (!changed(memcmp(mState.scissor, scissor, sizeof(scissor)) == 0)) {
+        return;
+    }
+    memcpy(mState.scissor, scissor, sizeof(scissor));
+    GL_CALL(glScissor(x, y, width, height));
+}
+
+void GLState::useProgram(GLuint program) {
+    if (!changed(mState.program == program)) {
+        return;
+    }
+    mState.program = program;
+    GL_CALL(glUseProgram(program));
+}
+
+void GLState::bindVertexArray(GLuint vertexArray) {
+    if (!changed(mState.vertexArray == vertexArray)) {
+        return;
+    }
+    mState.vertexArray = vertexArray;
+    GL_CALL(glBindVertexArray(vertexArray));
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    if (target == GL_ARRAY_BUFFER) {
+        if (!changed(mState.arrayBuffer == buffer)) {
+            return;
+        }
+        mState.arrayBuffer = buffer;
+    } else {
+        mIssued++;
+    }
+    GL_CALL(glBindBuffer(target, buffer));
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+    if (!changed(mState.framebuffer == framebuffer)) {
+        return;
+    }
+    mState.framebuffer = framebuffer;
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+}
+
+void GLState::activeTexture(GLenum unit) {
+    if (!changed(mState.activeTexture == unit)) {
+        return;
+    }
+    mState.activeTexture = unit;
+    GL_CALL(glActiveTexture(unit));
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    const uint32_t unit = mState.activeTexture - GL_TEXTURE0;
+    if (target == GL_TEXTURE_2D && unit < GL_STATE_TEXTURE_UNITS) {
+        if (!changed(mState.texture2D[unit] == texture)) {
+            return;
+        }
+        mState.texture2D[unit] = texture;
+    } else {
+        mIssued++;
+    }
+    GL_CALL(glBindTexture(target, texture));
+}
+
+void GLState::deleteProgram(GLuint program) {
+    // a deleted program stays current until another one is used, and its name may be handed out again
+    if (mState.program == program) {
+        useProgram(0);
+    }
+    GL_CALL(glDeleteProgram(program));
+}
+
+void GLState::deleteVertexArrays(GLsizei n, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (mState.vertexArray == vertexArrays[i]) {
+            mState.vertexArray = 0;
+        }
+    }
+    GL_CALL(glDeleteVertexArrays(n, vertexArrays));
+}
+
+void GLState::deleteBuffers(GLsizei n, const GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (mState.arrayBuffer == buffers[i]) {
+            mState.arrayBuffer = 0;
+        }
+    }
+    GL_CALL(glDeleteBuffers(n, buffers));
+}
+
+void GLState::deleteTextures(GLsizei n, const GLuint* textures) {
+    for (GLsizei i = 0; i < n; i++) {
+        for (uint32_t unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) {
+            if (mState.texture2D[unit] == textures[i]) {
+                mState.texture2D[unit] = 0;
+            }
+        }
+    }
+    GL_CALL(glDeleteTextures(n, textures));
+}
+
+GLStateValues GLState::save() const {
+    return mState;
+}
+
+void GLState::restore(const GLStateValues& state) {
+    useProgram(state.program);
+    bindVertexArray(state.vertexArray);
+    bindBuffer(GL_ARRAY_BUFFER, state.arrayBuffer);
+    bindFramebuffer(state.framebuffer);
+    for (uint32_t i = 0; i < GL_STATE_TEXTURE_UNITS; i++) {
+        if (mState.texture2D[i] != state.texture2D[i]) {
+            activeTexture(GL_TEXTURE0 + i);
+            bindTexture(GL_TEXTURE_2D, state.texture2D[i]);
+        }
+    }
+    activeTexture(state.activeTexture);
+    setEnabled(GL_BLEND, state.blend);
+    setEnabled(GL_CULL_FACE, state.cullFace);
+    setEnabled(GL_DEPTH_TEST, state.depthTest);
+    setEnabled(GL_STENCIL_TEST, state.stencilTest);
+    setEnabled(GL_SCISSOR_TEST, state.scissorTest);
+    blendFuncSeparate(state.blendSrcRgb, state.blendDstRgb, state.blendSrcAlpha, state.blendDstAlpha);
+    blendEquationSeparate(state.blendEquationRgb, state.blendEquationAlpha);
+    frontFace(state.frontFace);
+    cullFace(state.cullFaceMode);
+    depthMask(state.depthMask);
+    viewport(state.viewport[0], state.viewport[1], state.viewport[2], state.viewport[3]);
+    scissor(state.scissor[0], state.scissor[1], state.scissor[2], state.scissor[3]);
+}
+
+GLuint GLState::framebuffer() const {
+    return mState.framebuffer;
+}
+
+void GLState::endFrame() {
+    mLastIssued = mIssued;
+    mLastSkipped = mSkipped;
+    mIssued = 0;
+    mSkipped = 0;
+}
+
+uint32_t GLState::issuedCalls() const {
+    return mLastIssued;
+}
+
+uint32_t GLState::skippedCalls() const {
+    return mLastSkipped;
+}
@@ -0,0 +1,92 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stdint.h>
+#include "common/gfxwrapper_opengl.h"
+
+#define GL_STATE_TEXTURE_UNITS 8
+
+typedef struct {
+    GLuint program;
+    GLuint vertexArray;
+    GLuint arrayBuffer;
+    GLuint framebuffer;
+    GLenum activeTexture;
+    GLuint texture2D[GL_STATE_TEXTURE_UNITS];
+    bool blend;
+    bool cullFace;
+    bool depthTest;
+    bool stencilTest;
+    bool scissorTest;
+    GLenum blendSrcRgb;
+    GLenum blendDstRgb;
+    GLenum blendSrcAlpha;
+    GLenum blendDstAlpha;
+    GLenum blendEquationRgb;
+    GLenum blendEquationAlpha;
+    GLenum frontFace;
+    GLenum cullFaceMode;
+    GLboolean depthMask;
+    GLint viewport[4];
+    GLint scissor[4];
+}GLStateValues;
+
+// Shadow copy of the GL state the demos change, render thread only. A call that would leave the state as it is
+// never reaches GL. The shadow does not see raw GL calls, so all demo code binds, enables and sets the fixed
+// function state through here; initialize() reads the real state once, after the context is made current.
+class GLState {
+public:
+    static GLState& instance();
+    void initialize();
+
+    // GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_STENCIL_TEST and GL_SCISSOR_TEST are shadowed, others are forwarded
+    void enable(GLenum cap);
+    void disable(GLenum cap);
+    void blendFunc(GLenum src, GLenum dst);
+    void blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha);
+    void blendEquation(GLenum mode);
+    void blendEquationSeparate(GLenum modeRgb, GLenum modeAlpha);
+    void frontFace(GLenum mode);
+    void cullFace(GLenum mode);
+    void depthMask(GLboolean flag);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    // GL_ARRAY_BUFFER is shadowed; GL_ELEMENT_ARRAY_BUFFER is part of the bound vertex array and is forwarded
+    // like every other target
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindFramebuffer(GLuint framebuffer);
+    void activeTexture(GLenum unit);
+    // GL_TEXTURE_2D of the first GL_STATE_TEXTURE_UNITS units is shadowed, other targets and units are forwarded
+    void bindTexture(GLenum target, GLuint texture);
+
+    // GL unbinds an object deleted while bound, these keep the shadow in step
+    void deleteProgram(GLuint program);
+    void deleteVertexArrays(GLsizei n, const GLuint* vertexArrays);
+    void deleteBuffers(GLsizei n, const GLuint* buffers);
+    void deleteTextures(GLsizei n, const GLuint* textures);
+
+    // Backup of the tracked state without querying GL; restore only issues what differs.
+    GLStateValues save() const;
+    void restore(const GLStateValues& state);
+    GLuint framebuffer() const;
+
+    // render thread, after xrEndFrame of the frame
+    void endFrame();
+    // calls forwarded to GL and calls dropped as redundant during the previous frame
+    uint32_t issuedCalls() const;
+    uint32_t skippedCalls() const;
+
+private:
+    GLState() = default;
+    bool* capability(GLenum cap);
+    void setEnabled(GLenum cap, bool enabled);
+    bool changed(bool same);
+
+    GLStateValues mState = {};
+    uint32_t mIssued = 0;
+    uint32_t mSkipped = 0;
+    uint32_t mLastIssued = 0;
+    uint32_t mLastSkipped = 0;
+};
@@ -0,0 +1,352 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "glyphAtlas.h"
+#include "freetype/ftmodapi.h"
+#include "glState.h"
+#include "utils.h"
+
+GlyphAtlas& GlyphAtlas::instance() {
+    static GlyphAtlas atlas;
+    return atlas;
+}
+
+GlyphAtlas::GlyphAtlas() : mLibrary(nullptr), mManager(nullptr), mCMapCache(nullptr), mSBitCache(nullptr), mStop(false), mClock(0), mEvicted(0) {
+    memset(mPlaceholder, 0, sizeof(mPlaceholder));
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    if (mThreadRasterize.joinable()) {
+        mThreadRasterize.join();
+    }
+    // the pages go with the GL context
+    if (mManager != nullptr) {
+        FTC_Manager_Done(mManager);
+    }
+    if (mLibrary != nullptr) {
+        FT_Done_FreeType(mLibrary);
+    }
+}
+
+// the only face id is the atlas, passed as requestData as well
+FT_Error GlyphAtlas::requestFace(FTC_FaceID, FT_Library library, FT_Pointer requestData, FT_Face* face) {
+    GlyphAtlas* atlas = (GlyphAtlas*)requestData;
+    FT_Error error = FT_New_Memory_Face(library, (FT_Byte*)atlas->mFontData.data(), atlas->mFontData.size(), 0, face);
+    if (error) {
+        errorf("FT_New_Memory_Face error %d", error);
+        return error;
+    }
+    return FT_Select_Charmap(*face, ft_encoding_unicode);
+}
+
+bool GlyphAtlas::initialize() {
+    if (mManager != nullptr) {
+        return true;
+    }
+    if (FT_Init_FreeType(&mLibrary)) {
+        errorf("initialize freetype error");
+        mLibrary = nullptr;
+        return false;
+    }
+    FT_Int spread = GLYPH_ATLAS_SDF_SPREAD;
+    FT_Property_Set(mLibrary, "sdf", "spread", &spread);
+    mFontData = readFileFromAssets("font/Alibaba-PuHuiTi-Regular.ttf");
+    // one face in a size per mode, the default cache size holds the bitmaps of a few dozen glyphs
+    if (FTC_Manager_New(mLibrary, 1, glyphMode_Count, 0, requestFace, this, &mManager) ||
+        FTC_CMapCache_New(mManager, &mCMapCache) ||
+        FTC_SBitCache_New(mManager, &mSBitCache)) {
+        errorf("initialize freetype cache error");
+        return false;
+    }
+
+    // an outlined box per mode, pinned to its shelf. Its hard edge passes for a distance field as well.
+    for (uint32_t mode = 0; mode < glyphMode_Count; mode++) {
+        const uint16_t size = (uint16_t)pixelSize((GlyphMode)mode);
+        const uint16_t width = size / 2;
+        const uint16_t rows = size * 3 / 4;
+        const uint16_t border = std::max(size / 24, 1);
+        std::vector<uint8_t> box((size_t)width * rows, 0);
+        for (uint16_t y = 0; y < rows; y++) {
+            for (uint16_t x = 0; x < width; x++) {
+                if (x < border || y < border || x >= width - border || y >= rows - border) {
+                    box[y * width + x] = 0xff;
+                }
+            }
+        }
+        AtlasGlyph& placeholder = mPlaceholder[mode];
+        placeholder.width = width;
+        placeholder.rows = rows;
+        placeholder.left = border;
+        placeholder.top = rows;
+        placeholder.advance = width + 2 * border;
+        if (!place(placeholder, box.data(), width)) {
+            return false;
+        }
+        mPages[placeholder.page].shelves[placeholder.shelf].lastUsed = UINT64_MAX;
+    }
+
+    mThreadRasterize = std::thread(&GlyphAtlas::threadRasterize, this);
+    return true;
+}
+
+void GlyphAtlas::find(const wchar_t* text, int32_t length, GlyphMode mode, const AtlasGlyph** glyphs) {
+    mClock++;
+    bool requested = false;
+    for (int32_t i = 0; i < length; i++) {
+        const uint32_t key = ((uint32_t)text[i] & 0xffffff) | ((uint32_t)mode << 24);
+        auto it = mGlyphs.find(key);
+        if (it != mGlyphs.end()) {
+            if (it->second.page == GLYPH_ATLAS_NO_PAGE) {
+                glyphs[i] = nullptr;
+                continue;
+            }
+            if (it->second.width > 0) {
+                // the shelf of the placeholder stays pinned
+                Shelf& shelf = mPages[it->second.page].shelves[it->second.shelf];
+                shelf.lastUsed = std::max(shelf.lastUsed, mClock);
+            }
+            glyphs[i] = &it->second;
+            continue;
+        }
+        if (mManager == nullptr) {
+            glyphs[i] = nullptr;
+            continue;
+        }
+        if (mPending.insert(key).second) {
+            std::lock_guard<std::mutex> guard(mMutex);
+            mRequests.push_back(key);
+            requested = true;
+        }
+        glyphs[i] = &mPlaceholder[mode];
+    }
+    if (requested) {
+        mCondition.notify_one();
+    }
+}
+
+void GlyphAtlas::upload(float budgetMs) {
+    mClock++;
+    const auto start = std::chrono::steady_clock::now();
+    uint32_t uploaded = 0;
+    mEvicted = 0;
+    RasterizedGlyph result;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            if (mResults.empty()) {
+                break;
+            }
+            result = std::move(mResults.front());
+            mResults.pop_front();
+        }
+        mPending.erase(result.key);
+        AtlasGlyph glyph = result.glyph;
+        if (glyph.width == 0 || place(glyph, result.pixels.data(), glyph.width)) {
+            mGlyphs[result.key] = glyph;
+            if (glyph.width > 0) {
+                mPages[glyph.page].shelves[glyph.shelf].glyphs.push_back(result.key);
+                uploaded++;
+            }
+        } else {
+            // kept without pixels, so it is neither requested nor logged again until an eviction makes room
+            errorf("GlyphAtlas: no room for glyph 0x%x", result.key);
+            glyph.width = 0;
+            glyph.page = GLYPH_ATLAS_NO_PAGE;
+            mGlyphs[result.key] = glyph;
+            mFailed.push_back(result.key);
+        }
+        if (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs) {
+            break;
+        }
+    }
+    // one line per upload that had to make room, not one per glyph
+    if (mEvicted > 0) {
+        debugf("GlyphAtlas: uploaded %u glyphs, evicted %u", uploaded, mEvicted);
+    }
+}
+
+GLuint GlyphAtlas::texture(uint32_t page) const {
+    return mPages[page].texture;
+}
+
+uint32_t GlyphAtlas::pageCount() const {
+    return (uint32_t)mPages.size();
+}
+
+uint32_t GlyphAtlas::pixelSize(GlyphMode mode) {
+    return mode == glyphMode_Sdf ? GLYPH_ATLAS_SDF_PIXEL_SIZE : GLYPH_ATLAS_PIXEL_SIZE;
+}
+
+void GlyphAtlas::threadRasterize() {
+    infof("threadRasterize+++");
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStop) {
+        if (mRequests.empty()) {
+            mCondition.wait(lock);
+            continue;
+        }
+        RasterizedGlyph result;
+        result.key = mRequests.front();
+        mRequests.pop_front();
+        lock.unlock();
+        rasterize(result);
+        lock.lock();
+        mResults.push_back(std::move(result));
+    }
+    infof("threadRasterize---");
+}
+
+void GlyphAtlas::rasterize(RasterizedGlyph& result) {
+    // a glyph that fails keeps no pixels, so it is not requested again
+    result.glyph = {};
+    const uint32_t ch = result.key & 0xffffff;
+    const GlyphMode mode = (GlyphMode)(result.key >> 24);
+    const FTC_FaceID faceId = (FTC_FaceID)this;
+    const FT_UInt index = FTC_CMapCache_Lookup(mCMapCache, faceId, -1, ch);
+    FTC_ImageTypeRec type = {};
+    type.face_id = faceId;
+    type.width = pixelSize(mode);
+    type.height = pixelSize(mode);
+    // the sdf renderer writes the distances into an 8 bit bitmap, FT_LOAD_RENDER picks it by the target
+    type.flags = FT_LOAD_RENDER | (mode == glyphMode_Sdf ? FT_LOAD_TARGET_(FT_RENDER_MODE_SDF) : FT_LOAD_TARGET_NORMAL);
+    FTC_SBit sbit = nullptr;
+    if (FTC_SBitCache_Lookup(mSBitCache, &type, index, &sbit, nullptr) || sbit == nullptr) {
+        errorf("GlyphAtlas: failed to load glyph 0x%x", ch);
+        return;
+    }
+    result.glyph.left = sbit->left;
+    result.glyph.top = sbit->top;
+    result.glyph.advance = sbit->xadvance;
+    if (sbit->buffer == nullptr || sbit->width == 0 || sbit->height == 0) {
+        return;
+    }
+    result.glyph.width = sbit->width;
+    result.glyph.rows = sbit->height;
+    result.pixels.resize((size_t)sbit->width * sbit->height);
+    for (uint32_t row = 0; row < sbit->height; row++) {
+        memcpy(&result.pixels[row * sbit->width], sbit->buffer + row * sbit->pitch, sbit->width);
+    }
+}
+
+bool GlyphAtlas::place(AtlasGlyph& glyph, const uint8_t* pixels, int32_t pitch) {
+    const uint16_t width = glyph.width + 2 * GLYPH_ATLAS_PADDING;
+    const uint16_t height = glyph.rows + 2 * GLYPH_ATLAS_PADDING;
+    uint16_t x = 0;
+    if (!allocate(width, height, glyph.page, glyph.shelf, x)) {
+        return false;
+    }
+    const Shelf& shelf = mPages[glyph.page].shelves[glyph.shelf];
+    glyph.x = x + GLYPH_ATLAS_PADDING;
+    glyph.y = shelf.y + GLYPH_ATLAS_PADDING;
+
+    // the padding is uploaded with the glyph, it overwrites whatever an evicted glyph left there
+    mStaging.assign((size_t)width * height, 0);
+    for (uint32_t row = 0; row < glyph.rows; row++) {
+        memcpy(&mStaging[(row + GLYPH_ATLAS_PADDING) * width + GLYPH_ATLAS_PADDING], pixels + row * pitch, glyph.width);
+    }
+    GLState::instance().bindTexture(GL_TEXTURE_2D, mPages[glyph.page].texture);
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, x, shelf.y, width, height, GL_RED, GL_UNSIGNED_BYTE, mStaging.data()));
+    return true;
+}
+
+bool GlyphAtlas::allocate(uint16_t width, uint16_t height, uint16_t& page, uint16_t& shelf, uint16_t& x) {
+    // the flattest shelf with room
+    int32_t bestPage = -1;
+    int32_t bestShelf = -1;
+    for (uint32_t p = 0; p < mPages.size(); p++) {
+        for (uint32_t s = 0; s < mPages[p].shelves.size(); s++) {
+            const Shelf& candidate = mPages[p].shelves[s];
+            if (candidate.height >= height && candidate.x + width <= GLYPH_ATLAS_PAGE_SIZE &&
+                (bestPage < 0 || candidate.height < mPages[bestPage].shelves[bestShelf].height)) {
+                bestPage = p;
+                bestShelf = s;
+            }
+        }
+    }
+
+    if (bestPage < 0) {
+        // a new shelf, on a new page when the last one is full
+        if (mPages.empty() || mPages.back().y + height > GLYPH_ATLAS_PAGE_SIZE) {
+            if (!addPage()) {
+                if (!evict(width, height, page, shelf)) {
+                    return false;
+                }
+                bestPage = page;
+                bestShelf = shelf;
+            }
+        }
+        if (bestPage < 0) {
+            Page& last = mPages.back();
+            Shelf newShelf = {};
+            newShelf.y = last.y;
+            newShelf.height = height;
+            last.y += height;
+            last.shelves.push_back(newShelf);
+            bestPage = (int32_t)mPages.size() - 1;
+            bestShelf = (int32_t)last.shelves.size() - 1;
+        }
+    }
+
+    Shelf& target = mPages[bestPage].shelves[bestShelf];
+    page = (uint16_t)bestPage;
+    shelf = (uint16_t)bestShelf;
+    x = target.x;
+    target.x += width;
+    // the glyph is placed for a find of this clock, the shelf is not cold anymore
+    target.lastUsed = std::max(target.lastUsed, mClock);
+    return true;
+}
+
+bool GlyphAtlas::addPage() {
+    if (mPages.size() >= GLYPH_ATLAS_MAX_PAGES) {
+        return false;
+    }
+    Page page = {};
+    GL_CALL(glGenTextures(1, &page.texture));
+    GLState::instance().bindTexture(GL_TEXTURE_2D, page.texture);
+    GL_CALL(glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_SIZE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    mPages.push_back(page);
+    infof("GlyphAtlas: page %u, %u glyphs", (uint32_t)mPages.size() - 1, (uint32_t)mGlyphs.size());
+    return true;
+}
+
+bool GlyphAtlas::evict(uint16_t width, uint16_t height, uint16_t& page, uint16_t& shelf) {
+    // the least recently used shelf high enough, not touched by the current find
+    Shelf* coldest = nullptr;
+    for (uint32_t p = 0; p < mPages.size(); p++) {
+        for (uint32_t s = 0; s < mPages[p].shelves.size(); s++) {
+            Shelf& candidate = mPages[p].shelves[s];
+            if (candidate.height >= height && candidate.lastUsed < mClock && (coldest == nullptr || candidate.lastUsed < coldest->lastUsed)) {
+                coldest = &candidate;
+                page = p;
+                shelf = s;
+            }
+        }
+    }
+    if (coldest == nullptr || width > GLYPH_ATLAS_PAGE_SIZE) {
+        return false;
+    }
+    mEvicted += (uint32_t)coldest->glyphs.size();
+    for (uint32_t key : coldest->glyphs) {
+        mGlyphs.erase(key);
+    }
+    coldest->glyphs.clear();
+    for (uint32_t key : mFailed) {
+        mGlyphs.erase(key);
+    }
+    mFailed.clear();
+    coldest->x = 0;
+    coldest->lastUsed = mClock;
+    return true;
+}
@@ -0,0 +1,116 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "common/gfxwrapper_opengl.h"
+#include "ft2build.h"
+#include "freetype/freetype.h"
+#include "freetype/ftcache.h"
+
+#define GLYPH_ATLAS_PAGE_SIZE   1024   // texels, square GL_R8 pages
+#define GLYPH_ATLAS_MAX_PAGES   4
+#define GLYPH_ATLAS_PIXEL_SIZE  96     // coverage glyphs
+#define GLYPH_ATLAS_SDF_PIXEL_SIZE 32  // distance glyphs, sharp at any scale
+#define GLYPH_ATLAS_SDF_SPREAD  4      // texels of distance around the outline
+#define GLYPH_ATLAS_PADDING     1      // empty texels around a glyph, keeps linear filtering off its neighbours
+#define GLYPH_ATLAS_UPLOAD_BUDGET_MS 0.5f
+#define GLYPH_ATLAS_NO_PAGE     0xffff // page of a glyph that found no room
+
+typedef enum {
+    glyphMode_Bitmap = 0,   // coverage, blurry when magnified
+    glyphMode_Sdf,          // signed distance to the outline, 0.5 on the edge
+    glyphMode_Count,
+}GlyphMode;
+
+typedef struct {
+    uint16_t page;       // GLYPH_ATLAS_NO_PAGE when it found no room
+    uint16_t shelf;
+    uint16_t x;          // texel origin in the page
+    uint16_t y;
+    uint16_t width;      // bitmap size, 0 for a glyph without pixels
+    uint16_t rows;
+    int16_t left;        // bitmap offsets and advance of FreeType, pixels
+    int16_t top;
+    int32_t advance;
+}AtlasGlyph;
+
+// Rasterized glyphs of the bundled font, shelf packed into a few texture pages shared by all Text renderers.
+// When every page is full the least recently used shelf that fits is emptied and reused. Missing glyphs are
+// rasterized by a worker thread through the FreeType cache and uploaded by upload(), until then find()
+// hands out a placeholder box. Everything but the worker is render thread only.
+class GlyphAtlas {
+public:
+    static GlyphAtlas& instance();
+    ~GlyphAtlas();
+    // opens the font and starts the worker, once the GL context is current
+    bool initialize();
+    // Resolves the glyphs of a string in one mode, queueing the missing ones for the worker. glyphs[i] is the
+    // placeholder for a character not rasterized yet and nullptr for one without room in the atlas. The glyphs
+    // of one call stay valid until the next call or upload().
+    void find(const wchar_t* text, int32_t length, GlyphMode mode, const AtlasGlyph** glyphs);
+    // Once per frame, before the views: moves the glyphs the worker finished into the pages until budgetMs
+    // is spent, the rest waits for the next frame.
+    void upload(float budgetMs);
+    GLuint texture(uint32_t page) const;
+    uint32_t pageCount() const;
+    // size the glyphs of a mode are rasterized at, pixels per em
+    static uint32_t pixelSize(GlyphMode mode);
+
+private:
+    typedef struct {
+        uint16_t y;
+        uint16_t height;
+        uint16_t x;                   // next free texel of the shelf
+        uint64_t lastUsed;
+        std::vector<uint32_t> glyphs;
+    }Shelf;
+    typedef struct {
+        GLuint texture;
+        uint16_t y;                   // next free texel row of the page
+        std::vector<Shelf> shelves;
+    }Page;
+    typedef struct {
+        uint32_t key;                 // character | mode << 24
+        AtlasGlyph glyph;             // metrics only
+        std::vector<uint8_t> pixels;  // rows of width bytes
+    }RasterizedGlyph;
+
+    GlyphAtlas();
+    static FT_Error requestFace(FTC_FaceID faceId, FT_Library library, FT_Pointer requestData, FT_Face* face);
+    void threadRasterize();
+    void rasterize(RasterizedGlyph& result);
+    bool place(AtlasGlyph& glyph, const uint8_t* pixels, int32_t pitch);
+    bool allocate(uint16_t width, uint16_t height, uint16_t& page, uint16_t& shelf, uint16_t& x);
+    bool addPage();
+    bool evict(uint16_t width, uint16_t height, uint16_t& page, uint16_t& shelf);
+
+    // worker thread, after initialize
+    FT_Library mLibrary;
+    FTC_Manager mManager;
+    FTC_CMapCache mCMapCache;
+    FTC_SBitCache mSBitCache;
+    std::vector<char> mFontData;     // the face is read from it while mManager lives
+
+    std::thread mThreadRasterize;
+    std::mutex mMutex;               // guards the queues and mStop
+    std::condition_variable mCondition;
+    std::deque<uint32_t> mRequests;
+    std::deque<RasterizedGlyph> mResults;
+    bool mStop;
+
+    // render thread
+    std::vector<Page> mPages;
+    std::unordered_map<uint32_t, AtlasGlyph> mGlyphs;   // by key
+    std::unordered_set<uint32_t> mPending;   // keys requested from the worker, not uploaded yet
+    std::vector<uint32_t> mFailed;   // keys that found no room, requested again once a shelf is evicted
+    AtlasGlyph mPlaceholder[glyphMode_Count];
+    std::vector<uint8_t> mStaging;   // padded bitmap of the glyph being uploaded
+    uint64_t mClock;                 // counts find and upload calls
+    uint32_t mEvicted;               // glyphs evicted by the current upload
+};
@@ -1,11 +1,19 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
+#include <float.h>
+#include <algorithm>
 #include "gui.h"
 #include "utils.h"
+#include "profiler.h"
+#include "glState.h"
 #include "glm/geometric.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
 Shader Gui::mShader;
-Gui::Gui(std::string name): mName(name), mFramebuffer(0), mTextureColorbuffer(0), mVAO(0), mVBO(0) {
+UniformHandle Gui::mModelUniform;
+UniformHandle Gui::mIntersectionPointUniform;
+Gui::Gui(std::string name): mName(name), mFramebuffer(0), mTextureColorbuffer(0), mVAO(0), mVBO(0), mDeltaTime(1.0f / 72.0f), mHasContent(false), mDrawCursor(false) {
+    memset(mBandHash, 0, sizeof(mBandHash));
 }
 
 Gui::~Gui() {
@@ -24,14 +32,12 @@ bool Gui::initShader() {
             layout (location = 1) in vec2 aTexCoords;
             out vec2 TexCoords;
             out vec3 FragPos;
-            uniform mat4 projection;
-            uniform mat4 view;
             uniform mat4 model;
             void main()
             {
                 FragPos = vec3(model * vec4(aPos, 1.0));
                 TexCoords = aTexCoords;
-                gl_Position = projection * view * vec4(FragPos, 1.0);
+                gl_Position = cameraViewProjection[VIEW_ID] * vec4(FragPos, 1.0);
             }
         )_";
 
@@ -54,9 +60,11 @@ bool Gui::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, Shader::eyeViewCount()) == false) {
             return false;
         }
+        mModelUniform = mShader.uniform("model");
+        mIntersectionPointUniform = mShader.uniform("intersectionPoint");
         init = true;
     }
     return true;
@@ -76,17 +84,17 @@ bool Gui::initialize(int32_t width, int32_t height) {
     }
 
     GL_CALL(glGenFramebuffers(1, &mFramebuffer));
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
+    GLState::instance().bindFramebuffer(mFramebuffer);
 
-    GL_CALL(glActiveTexture(GL_TEXTURE0));
+    GLState::instance().activeTexture(GL_TEXTURE0);
     GL_CALL(glGenTextures(1, &mTextureColorbuffer));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, mTextureColorbuffer));
+    GLState::instance().bindTexture(GL_TEXTURE_2D, mTextureColorbuffer);
     GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
     GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
     GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
     GL_CALL(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
     GL_CALL(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    GLState::instance().bindTexture(GL_TEXTURE_2D, 0);
 
     GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureColorbuffer, 0));
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
@@ -107,8 +115,8 @@ bool Gui::initialize(int32_t width, int32_t height) {
 
     GL_CALL(glGenVertexArrays(1, &mVAO));
     GL_CALL(glGenBuffers(1, &mVBO));
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
+    GLState::instance().bindVertexArray(mVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO);
     GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW));
     GL_CALL(glEnableVertexAttribArray(0));
     GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0));
@@ -118,37 +126,144 @@ bool Gui::initialize(int32_t width, int32_t height) {
     return true;
 }
 
-void Gui::render(const glm::mat4& p, const glm::mat4& v) {
+static inline uint64_t hashMix(uint64_t hash, uint32_t value) {
+    return (hash ^ value) * 0x100000001b3ull;
+}
+
+// Every triangle drawn is mixed into the hash of each band its bounding box overlaps, in draw order, together
+// with the clip rectangle and texture of its command. A triangle that changes changes every band it covers.
+void Gui::hashBands(uint64_t* bandHash) const {
+    for (uint32_t i = 0; i < GUI_DIRTY_BANDS; i++) {
+        bandHash[i] = 0xcbf29ce484222325ull;
+    }
+    const ImDrawData* drawData = ImGui::GetDrawData();
+    if (drawData == nullptr) {
+        return;
+    }
+    const float bandScale = (float)GUI_DIRTY_BANDS / mHeight;
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* cmdList = drawData->CmdLists[n];
+        for (const ImDrawCmd& cmd : cmdList->CmdBuffer) {
+            if (cmd.UserCallback != nullptr) {
+                continue;
+            }
+            uint32_t state[6];
+            memcpy(state, &cmd.ClipRect, sizeof(float) * 4);
+            state[4] = (uint32_t)(uintptr_t)cmd.TextureId;
+            state[5] = cmd.ElemCount;
+            for (uint32_t i = 0; i + 3 <= cmd.ElemCount; i += 3) {
+                // the triangle and the state of its command hashed once, then mixed into the bands it covers
+                uint64_t triangleHash = 0xcbf29ce484222325ull;
+                float minY = FLT_MAX;
+                float maxY = -FLT_MAX;
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    const ImDrawVert& vertex = cmdList->VtxBuffer[cmd.VtxOffset + cmdList->IdxBuffer[cmd.IdxOffset + i + corner]];
+                    minY = std::min(minY, vertex.pos.y);
+                    maxY = std::max(maxY, vertex.pos.y);
+                    uint32_t words[5];
+                    memcpy(words, &vertex, sizeof(words));
+                    for (uint32_t word : words) {
+                        triangleHash = hashMix(triangleHash, word);
+                    }
+                }
+                for (uint32_t word : state) {
+                    triangleHash = hashMix(triangleHash, word);
+                }
+                const int32_t firstBand = std::min(std::max((int32_t)(minY * bandScale), 0), GUI_DIRTY_BANDS - 1);
+                const int32_t lastBand = std::min(std::max((int32_t)(maxY * bandScale), 0), GUI_DIRTY_BANDS - 1);
+                for (int32_t band = firstBand; band <= lastBand; band++) {
+                    bandHash[band] = hashMix(hashMix(bandHash[band], (uint32_t)triangleHash), (uint32_t)(triangleHash >> 32));
+                }
+            }
+        }
+    }
+}
+
+bool Gui::update() {
+    PROFILE_SCOPE(profileMarker_GuiOffscreen);
+    uint64_t bandHash[GUI_DIRTY_BANDS];
+    hashBands(bandHash);
+    int32_t firstDirty = mHasContent ? GUI_DIRTY_BANDS : 0;
+    int32_t lastDirty = mHasContent ? -1 : GUI_DIRTY_BANDS - 1;
+    for (int32_t i = 0; i < GUI_DIRTY_BANDS; i++) {
+        if (bandHash[i] != mBandHash[i]) {
+            firstDirty = std::min(firstDirty, i);
+            lastDirty = std::max(lastDirty, i);
+        }
+    }
+    if (lastDirty < firstDirty) {
+        // the texture still holds this frame
+        return false;
+    }
+    memcpy(mBandHash, bandHash, sizeof(mBandHash));
+    mHasContent = true;
 
-    GLenum last_framebuffer = 0; GL_CALL(glGetIntegerv(GL_FRAMEBUFFER_BINDING, (GLint*)&last_framebuffer));
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
+    GPU_PROFILE_SCOPE(gpuMarker_GuiOffscreen);
+    GLuint last_framebuffer = GLState::instance().framebuffer();
+    GLState::instance().bindFramebuffer(mFramebuffer);
     GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureColorbuffer, 0));
+
+    // rows of the dirty bands, the clear and every command are scissored to them
+    const float bandHeight = (float)mHeight / GUI_DIRTY_BANDS;
+    const ImVec4 clip(0.0f, firstDirty * bandHeight, (float)mWidth, (lastDirty + 1) * bandHeight);
+    GLState::instance().enable(GL_SCISSOR_TEST);
+    GLState::instance().scissor(0, (GLint)(mHeight - clip.w), mWidth, (GLint)(clip.w - clip.y));
     GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
     GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
     active();
-    GuiBase::instance().render();
+    GuiBase::instance().render(&clip);
 
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, last_framebuffer));
+    GLState::instance().disable(GL_SCISSOR_TEST);
+    GLState::instance().bindFramebuffer(last_framebuffer);
+    return true;
+}
 
+void Gui::render() {
+    GPU_PROFILE_SCOPE(gpuMarker_GuiComposite);
     mShader.use(); 
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", mModel);
-    mShader.setUniformVec3("intersectionPoint", mIntersectionPoint);
-
-    GL_CALL(glDisable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, mTextureColorbuffer));
+    mShader.setUniformMat4(mModelUniform, mModel);
+    mShader.setUniformVec3(mIntersectionPointUniform, mIntersectionPoint);
+
+    GLState::instance().disable(GL_CULL_FACE);
+    GLState::instance().enable(GL_BLEND);
+    GLState::instance().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::instance().bindVertexArray(mVAO);
+    GLState::instance().bindTexture(GL_TEXTURE_2D, mTextureColorbuffer);
     GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 6));
 }
 
+void Gui::submit(RenderQueue& queue) {
+    DrawPacket packet = {};
+    packet.pass = renderPass_Transparent;
+    packet.program = mShader.id();
+    packet.vertexArray = mVAO;
+    packet.texture = mTextureColorbuffer;
+    packet.draw = drawPacket;
+    packet.object = this;
+    queue.submit(packet, glm::vec3(mModel[3]), 0);
+}
+
+void Gui::drawPacket(const RenderQueue& queue, const DrawPacket& packet) {
+    ((Gui*)packet.object)->render();
+}
+
 void Gui::setModel(const glm::mat4& m) {
     mModel = m;
 }
 
+const glm::mat4& Gui::model() const {
+    return mModel;
+}
+
+GLuint Gui::texture() const {
+    return mTextureColorbuffer;
+}
+
+void Gui::setDrawCursor(bool draw) {
+    mDrawCursor = draw;
+}
+
 bool Gui::isIntersectWithLine(const glm::vec3& linePoint, const glm::vec3& lineDirection) {
 
     glm::vec3 planePoint = glm::vec3(mModel * glm::vec4(-1.0f, 1.0f, 0.0f, 1.0f));
@@ -212,6 +327,12 @@ void Gui::triggerEvent(bool down) {
     io.AddMouseButtonEvent(0/*left button*/, down);
 }
 
+void Gui::setDeltaTime(float seconds) {
+    if (seconds > 0.0f) {
+        mDeltaTime = seconds;
+    }
+}
+
 void Gui::getWidthHeight(float& width, float& height) {
     width = float(mWidth);
     height = float(mHeight);
@@ -221,7 +342,8 @@ void Gui::active() {
     auto& io = ImGui::GetIO();
     io.DisplaySize.x = float(mWidth);
     io.DisplaySize.y = float(mHeight);
-    io.DeltaTime = 1.0f / 72.0f;
+    io.DeltaTime = mDeltaTime;
+    io.MouseDrawCursor = mDrawCursor;
 }
 
 void Gui::begin() {
@@ -1,14 +1,28 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #pragma once
 #include "guiBase.h"
+#include "renderQueue.h"
+
+#define GUI_DIRTY_BANDS 16   // horizontal bands the panel is compared in
 
 class Gui {
 public:
     Gui(std::string name);
     ~Gui();
     bool initialize(int32_t width, int32_t height);
-    void render(const glm::mat4& p, const glm::mat4& v);
+    // draw the ImGui frame built by begin()/end() into the panel texture, once per frame. Only the rows of
+    // bands whose geometry changed since the last frame are drawn again, nothing when the panel is unchanged.
+    // Returns true when the texture was drawn to.
+    bool update();
+    // draw the panel texture into the current eye buffer
+    void render();
+    void submit(RenderQueue& queue);
+    void setDeltaTime(float seconds);
     void setModel(const glm::mat4& m);
+    const glm::mat4& model() const;
+    GLuint texture() const;
+    // let ImGui draw the mouse cursor into the panel, for a panel shown without the intersection point of render()
+    void setDrawCursor(bool draw);
     void getWidthHeight(float& width, float& height);
     bool isIntersectWithLine(const glm::vec3& linePoint, const glm::vec3& lineDirection);
     void active();
@@ -19,9 +33,13 @@ public:
 private:
     bool initShader();
     void updateMousePosition(float x, float y);
+    void hashBands(uint64_t* bandHash) const;
+    static void drawPacket(const RenderQueue& queue, const DrawPacket& packet);
 
 private:
     static Shader mShader;
+    static UniformHandle mModelUniform;
+    static UniformHandle mIntersectionPointUniform;
     std::string mName;
 
     GLuint mFramebuffer;
@@ -34,4 +52,8 @@ private:
 
     glm::mat4 mModel;
     glm::vec3 mIntersectionPoint;
+    float mDeltaTime;
+    uint64_t mBandHash[GUI_DIRTY_BANDS];   // of the draw data in the panel texture
+    bool mHasContent;
+    bool mDrawCursor;
 };
\ No newline at end of file
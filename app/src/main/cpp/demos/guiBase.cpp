@@ -1,13 +1,18 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
+#include <algorithm>
 #include "guiBase.h"
 #include "utils.h"
+#include "glState.h"
 
 GuiBase& GuiBase::instance() {
     static GuiBase guiBase;
     return guiBase;
 }
 
-GuiBase::GuiBase() : mImguiContext(nullptr), mShaderHandle(0), mUseBufferSubData(true), mFontTexture(0) {
+GuiBase::GuiBase() : mImguiContext(nullptr), mFontTexture(0), mShaderHandle(0), mVboHandle(0), mElementsHandle(0), mVertexArray(0),
+    mSegmentVertices(0), mSegmentIndices(0), mSegment(0), mPersistent(false), mMappedVertices(nullptr), mMappedIndices(nullptr) {
+    memset(mSegmentFences, 0, sizeof(mSegmentFences));
     mImguiContext = ImGui::CreateContext();
     ImGui::SetCurrentContext(mImguiContext);
 }
@@ -73,17 +78,26 @@ bool GuiBase::initialize() {
         int32_t width, height;
         io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
 
-        GL_CALL(glGenBuffers(1, &mVboHandle));
-        GL_CALL(glGenBuffers(1, &mElementsHandle));
-        GL_CALL(glActiveTexture(GL_TEXTURE0));
+        // one vertex array for the life of the backend, the attributes read the vertex ring from offset 0
+        // and draws pick their segment by base vertex
+        mPersistent = glBufferStorage != nullptr && hasGLExtension("GL_EXT_buffer_storage");
+        GL_CALL(glGenVertexArrays(1, &mVertexArray));
+        GLState::instance().bindVertexArray(mVertexArray);
+        GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxPos));
+        GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxUV));
+        GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxColor));
+        reserveRing(8192, 16384);
+        GLState::instance().bindVertexArray(0);
+
+        GLState::instance().activeTexture(GL_TEXTURE0);
         GL_CALL(glGenTextures(1, &mFontTexture));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, mFontTexture));
+        GLState::instance().bindTexture(GL_TEXTURE_2D, mFontTexture);
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+        GLState::instance().bindTexture(GL_TEXTURE_2D, 0);
     } else {
         unsigned char* pixels;
         io.Fonts->GetTexDataAsRGBA32(&pixels, nullptr, nullptr);
@@ -95,15 +109,15 @@ bool GuiBase::initialize() {
 #define IMGUI_IMPL_OPENGL_USE_VERTEX_ARRAY
 #define GL_CLIP_ORIGIN
 
-void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height, GLuint vertex_array_object) {
+void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height) {
     // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, polygon fill
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendEquation(GL_FUNC_ADD));
-    GL_CALL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glDisable(GL_CULL_FACE));
-    GL_CALL(glDisable(GL_DEPTH_TEST));
-    GL_CALL(glDisable(GL_STENCIL_TEST));
-    GL_CALL(glEnable(GL_SCISSOR_TEST));
+    GLState::instance().enable(GL_BLEND);
+    GLState::instance().blendEquation(GL_FUNC_ADD);
+    GLState::instance().blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::instance().disable(GL_CULL_FACE);
+    GLState::instance().disable(GL_DEPTH_TEST);
+    GLState::instance().disable(GL_STENCIL_TEST);
+    GLState::instance().enable(GL_SCISSOR_TEST);
 
     //GL_CALL(glDisable(GL_PRIMITIVE_RESTART));
 
@@ -114,7 +128,7 @@ void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_heigh
 
     // Setup viewport, orthographic projection matrix
     // Our visible imgui space lies from draw_data->DisplayPos (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
-    GL_CALL(glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height));
+    GLState::instance().viewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
     float L = draw_data->DisplayPos.x;
     float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
     float T = draw_data->DisplayPos.y;
@@ -130,25 +144,132 @@ void GuiBase::setupRenderState(ImDrawData* draw_data, int fb_width, int fb_heigh
         { (R+L)/(L-R),  (T+B)/(B-T),  0.0f,   1.0f },
     };
 
-    GL_CALL(glUseProgram(mShaderHandle));
+    GLState::instance().useProgram(mShaderHandle);
     GL_CALL(glUniform1i(mAttribLocationTex, 0));
     GL_CALL(glUniformMatrix4fv(mAttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0])); 
 
-    glBindSampler(0, 0);
-    glBindVertexArray(vertex_array_object);
+    GLState::instance().bindVertexArray(mVertexArray);
+}
 
-    // Bind vertex/index buffers and setup attributes for ImDrawVert
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVboHandle));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementsHandle));
-    GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxPos));
-    GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxUV));
-    GL_CALL(glEnableVertexAttribArray(mAttribLocationVtxColor));
+void GuiBase::reserveRing(uint32_t vertices, uint32_t indices) {
+    if (vertices <= mSegmentVertices && indices <= mSegmentIndices) {
+        return;
+    }
+    // with headroom, so a panel that grows slowly does not reallocate every frame
+    mSegmentVertices = std::max(mSegmentVertices, vertices + vertices / 2);
+    mSegmentIndices = std::max(mSegmentIndices, indices + indices / 2);
+    infof("gui ring: %u vertices, %u indices per segment%s", mSegmentVertices, mSegmentIndices, mPersistent ? ", persistently mapped" : "");
+    // new storage, the draws still reading the old one keep it alive
+    for (uint32_t i = 0; i < GUI_RING_SEGMENTS; i++) {
+        if (mSegmentFences[i] != 0) {
+            glDeleteSync(mSegmentFences[i]);
+            mSegmentFences[i] = 0;
+        }
+    }
+    mSegment = 0;
+    const GLsizeiptr vertexBytes = (GLsizeiptr)mSegmentVertices * GUI_RING_SEGMENTS * sizeof(ImDrawVert);
+    const GLsizeiptr indexBytes = (GLsizeiptr)mSegmentIndices * GUI_RING_SEGMENTS * sizeof(ImDrawIdx);
+    // the element buffer binding belongs to the vertex array
+    GLState::instance().bindVertexArray(mVertexArray);
+    if (mPersistent) {
+        // immutable storage cannot grow, the buffers are replaced and the vertex array pointed at the new ones
+        if (mVboHandle != 0) {
+            GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVboHandle);
+            GL_CALL(glUnmapBuffer(GL_ARRAY_BUFFER));
+            GL_CALL(glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER));
+            GLState::instance().deleteBuffers(1, &mVboHandle);
+            GLState::instance().deleteBuffers(1, &mElementsHandle);
+        }
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GL_CALL(glGenBuffers(1, &mVboHandle));
+        GL_CALL(glGenBuffers(1, &mElementsHandle));
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVboHandle);
+        GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementsHandle);
+        GL_CALL(glBufferStorage(GL_ARRAY_BUFFER, vertexBytes, nullptr, flags));
+        GL_CALL(glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, flags));
+        mMappedVertices = (ImDrawVert*)glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes, flags);
+        mMappedIndices = (ImDrawIdx*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, flags);
+        if (mMappedVertices == nullptr || mMappedIndices == nullptr) {
+            errorf("gui ring could not be mapped persistently, GL error %d", glGetError());
+        }
+    } else {
+        if (mVboHandle == 0) {
+            GL_CALL(glGenBuffers(1, &mVboHandle));
+            GL_CALL(glGenBuffers(1, &mElementsHandle));
+        }
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVboHandle);
+        GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementsHandle);
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STREAM_DRAW));
+        GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STREAM_DRAW));
+    }
     GL_CALL(glVertexAttribPointer(mAttribLocationVtxPos,   2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, pos)));
     GL_CALL(glVertexAttribPointer(mAttribLocationVtxUV,    2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, uv)));
     GL_CALL(glVertexAttribPointer(mAttribLocationVtxColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, col)));
 }
 
-bool GuiBase::renderDrawData(ImDrawData* draw_data) {
+// Blocks until the GPU finished the draws that read the segment, it is overwritten without synchronization next.
+void GuiBase::waitSegment(uint32_t segment) {
+    if (mSegmentFences[segment] == 0) {
+        return;
+    }
+    GLenum result = glClientWaitSync(mSegmentFences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, GUI_RING_FENCE_TIMEOUT);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        warnf("gui ring segment %u still in use by the GPU after %llu ns", segment, GUI_RING_FENCE_TIMEOUT);
+        result = glClientWaitSync(mSegmentFences[segment], 0, GUI_RING_FENCE_TIMEOUT);
+    }
+    if (result == GL_WAIT_FAILED) {
+        errorf("gui ring segment %u: fence wait failed, finishing the GPU work", segment);
+        GL_CALL(glFinish());
+    }
+    glDeleteSync(mSegmentFences[segment]);
+    mSegmentFences[segment] = 0;
+}
+
+bool GuiBase::uploadRing(ImDrawData* draw_data, uint32_t& firstVertex, uint32_t& firstIndex) {
+    reserveRing((uint32_t)draw_data->TotalVtxCount, (uint32_t)draw_data->TotalIdxCount);
+    mSegment = (mSegment + 1) % GUI_RING_SEGMENTS;
+    waitSegment(mSegment);
+    firstVertex = mSegment * mSegmentVertices;
+    firstIndex = mSegment * mSegmentIndices;
+
+    ImDrawVert* vertices = nullptr;
+    ImDrawIdx* indices = nullptr;
+    if (mPersistent) {
+        // coherent mapping, the writes are visible to the draws issued after them
+        if (mMappedVertices != nullptr && mMappedIndices != nullptr) {
+            vertices = mMappedVertices + firstVertex;
+            indices = mMappedIndices + firstIndex;
+        }
+    } else {
+        // the fence above is the synchronization, the driver need not track the range
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVboHandle);
+        vertices = (ImDrawVert*)glMapBufferRange(GL_ARRAY_BUFFER, firstVertex * sizeof(ImDrawVert), mSegmentVertices * sizeof(ImDrawVert), access);
+        indices = (ImDrawIdx*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(ImDrawIdx), mSegmentIndices * sizeof(ImDrawIdx), access);
+    }
+    const bool mapped = vertices != nullptr && indices != nullptr;
+    if (mapped) {
+        for (int n = 0; n < draw_data->CmdListsCount; n++) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            memcpy(vertices, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            memcpy(indices, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            vertices += cmd_list->VtxBuffer.Size;
+            indices += cmd_list->IdxBuffer.Size;
+        }
+    }
+    if (!mPersistent && vertices != nullptr) {
+        GL_CALL(glUnmapBuffer(GL_ARRAY_BUFFER));
+    }
+    if (!mPersistent && indices != nullptr) {
+        GL_CALL(glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER));
+    }
+    if (!mapped) {
+        errorf("gui ring: map segment %u failed", mSegment);
+    }
+    return mapped;
+}
+
+bool GuiBase::renderDrawData(ImDrawData* draw_data, const ImVec4* clip) {
     ImGuiIO& io = ImGui::GetIO();
     int fb_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
     int fb_height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
@@ -158,77 +279,53 @@ bool GuiBase::renderDrawData(ImDrawData* draw_data) {
     draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
 
-    // Backup GL state
-    GLenum last_active_texture = 0; GL_CALL(glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture));
-    glActiveTexture(GL_TEXTURE0);
-    GLuint last_program = 0; glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
-    GLuint last_texture = 0; glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
-    GLuint last_sampler = 0; glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler);
-    GLuint last_array_buffer = 0; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
-    GLuint last_vertex_array_object = 0; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
-    //GLint last_polygon_mode[2]; glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
-    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
-    GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    GLenum last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
-    GLenum last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
-    GLenum last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
-    GLenum last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
-    GLenum last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
-    GLenum last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
-    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
-    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-    GLboolean last_enable_stencil_test = glIsEnabled(GL_STENCIL_TEST);
-    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
-    //GLboolean last_enable_primitive_restart = glIsEnabled(GL_PRIMITIVE_RESTART);
-
-
-    GLuint vertex_array_object = 0;
-    GL_CALL(glGenVertexArrays(1, &vertex_array_object));
-
-    setupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
+    // Backup GL state, from the shadow of GLState rather than glGet queries
+    const GLStateValues last_state = GLState::instance().save();
+    GLState::instance().activeTexture(GL_TEXTURE0);
+
+    setupRenderState(draw_data, fb_width, fb_height);
+    uint32_t firstVertex = 0;
+    uint32_t firstIndex = 0;
+    if (!uploadRing(draw_data, firstVertex, firstIndex)) {
+        GLState::instance().restore(last_state);
+        return false;
+    }
 
     ImVec2 clip_off = draw_data->DisplayPos;         // (0,0) unless using multi-viewports
     ImVec2 clip_scale = draw_data->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
 
+    // Consecutive commands with the same scissor, texture and base vertex and adjoining indices are drawn as one.
+    // After clipping to clip, commands ImGui kept apart for their clip rectangles often end up with the same scissor.
+    const GLenum index_type = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    GLint batch_scissor[4] = {};
+    ImTextureID batch_texture = nullptr;
+    GLint batch_base_vertex = 0;
+    uint32_t batch_first = 0;
+    uint32_t batch_count = 0;
+    auto flush = [&]() {
+        if (batch_count == 0) {
+            return;
+        }
+        GLState::instance().scissor(batch_scissor[0], batch_scissor[1], batch_scissor[2], batch_scissor[3]);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)batch_texture);
+        GL_CALL(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)batch_count, index_type, (void*)(intptr_t)(batch_first * sizeof(ImDrawIdx)), batch_base_vertex));
+        batch_count = 0;
+    };
+
     // Render command lists
+    uint32_t list_vertex = firstVertex;
+    uint32_t list_index = firstIndex;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
-
-        // Upload vertex/index buffers
-        // - OpenGL drivers are in a very sorry state nowadays....
-        //   During 2021 we attempted to switch from glBufferData() to orphaning+glBufferSubData() following reports
-        //   of leaks on Intel GPU when using multi-viewports on Windows.
-        // - After this we kept hearing of various display corruptions issues. We started disabling on non-Intel GPU, but issues still got reported on Intel.
-        // - We are now back to using exclusively glBufferData(). So bd->UseBufferSubData IS ALWAYS FALSE in this code.
-        //   We are keeping the old code path for a while in case people finding new issues may want to test the bd->UseBufferSubData path.
-        // - See https://github.com/ocornut/imgui/issues/4468 and please report any corruption issues.
-        const GLsizeiptr vtx_buffer_size = (GLsizeiptr)cmd_list->VtxBuffer.Size * (int)sizeof(ImDrawVert);
-        const GLsizeiptr idx_buffer_size = (GLsizeiptr)cmd_list->IdxBuffer.Size * (int)sizeof(ImDrawIdx);
-        if (mUseBufferSubData) {
-            if (mVertexBufferSize < vtx_buffer_size) {
-                mVertexBufferSize = vtx_buffer_size;
-                GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertexBufferSize, nullptr, GL_STREAM_DRAW));
-            }
-            if (mIndexBufferSize < idx_buffer_size) {
-                mIndexBufferSize = idx_buffer_size;
-                GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndexBufferSize, nullptr, GL_STREAM_DRAW));
-            }
-            GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data));
-            GL_CALL(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, idx_buffer_size, (const GLvoid*)cmd_list->IdxBuffer.Data));
-        } else {
-            GL_CALL(glBufferData(GL_ARRAY_BUFFER, vtx_buffer_size, (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW));
-            GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_buffer_size, (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW));
-        }
-
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
             const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
             if (pcmd->UserCallback != nullptr) {
+                flush();
                 // User callback, registered via ImDrawList::AddCallback()
                 // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState) {
-                    setupRenderState(draw_data, fb_width, fb_height, vertex_array_object);
+                    setupRenderState(draw_data, fb_width, fb_height);
                 }
                 else {
                     pcmd->UserCallback(cmd_list, pcmd);
@@ -237,41 +334,41 @@ bool GuiBase::renderDrawData(ImDrawData* draw_data) {
                 // Project scissor/clipping rectangles into framebuffer space
                 ImVec2 clip_min((pcmd->ClipRect.x - clip_off.x) * clip_scale.x, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
                 ImVec2 clip_max((pcmd->ClipRect.z - clip_off.x) * clip_scale.x, (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+                if (clip != nullptr) {
+                    clip_min = ImVec2(std::max(clip_min.x, clip->x), std::max(clip_min.y, clip->y));
+                    clip_max = ImVec2(std::min(clip_max.x, clip->z), std::min(clip_max.y, clip->w));
+                }
                 if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y) {
                     continue;
                 }
-                // Apply scissor/clipping rectangle (Y is inverted in OpenGL)
-                GL_CALL(glScissor((int)clip_min.x, (int)((float)fb_height - clip_max.y), (int)(clip_max.x - clip_min.x), (int)(clip_max.y - clip_min.y)));
-                // Bind texture, Draw
-                GL_CALL(glBindTexture(GL_TEXTURE_2D, mFontTexture));
-                GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(pcmd->IdxOffset * sizeof(ImDrawIdx))));
+                // Scissor/clipping rectangle (Y is inverted in OpenGL)
+                const GLint scissor[4] = {(GLint)clip_min.x, (GLint)((float)fb_height - clip_max.y), (GLint)(clip_max.x - clip_min.x), (GLint)(clip_max.y - clip_min.y)};
+                const ImTextureID texture = pcmd->TextureId != nullptr ? pcmd->TextureId : (ImTextureID)(intptr_t)mFontTexture;
+                const GLint base_vertex = (GLint)(list_vertex + pcmd->VtxOffset);
+                const uint32_t first = list_index + pcmd->IdxOffset;
+                if (batch_count == 0 || memcmp(scissor, batch_scissor, sizeof(scissor)) != 0 || texture != batch_texture ||
+                    base_vertex != batch_base_vertex || first != batch_first + batch_count) {
+                    flush();
+                    memcpy(batch_scissor, scissor, sizeof(scissor));
+                    batch_texture = texture;
+                    batch_base_vertex = base_vertex;
+                    batch_first = first;
+                }
+                batch_count += pcmd->ElemCount;
             }
         }
+        flush();
+        list_vertex += cmd_list->VtxBuffer.Size;
+        list_index += cmd_list->IdxBuffer.Size;
     }
+    mSegmentFences[mSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
-    // Destroy the temporary VAO
-    GL_CALL(glDeleteVertexArrays(1, &vertex_array_object));
-    if (last_program == 0 || glIsProgram(last_program)) glUseProgram(last_program);
-    glBindTexture(GL_TEXTURE_2D, last_texture);
-    glBindSampler(0, last_sampler);
-    glActiveTexture(last_active_texture);
-    glBindVertexArray(last_vertex_array_object);
-    glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
-    glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
-    glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
-    if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
-    if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
-    if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
-    if (last_enable_stencil_test) glEnable(GL_STENCIL_TEST); else glDisable(GL_STENCIL_TEST);
-    if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
-    //if (last_enable_primitive_restart) glEnable(GL_PRIMITIVE_RESTART); else glDisable(GL_PRIMITIVE_RESTART);
-    glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
-    glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
+    GLState::instance().restore(last_state);
 
     return true;
 }
 
-void GuiBase::render() {
-    GuiBase::renderDrawData(ImGui::GetDrawData());
+void GuiBase::render(const ImVec4* clip) {
+    GuiBase::renderDrawData(ImGui::GetDrawData(), clip);
 }
 
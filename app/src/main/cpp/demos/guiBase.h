@@ -6,17 +6,24 @@
 #include "common/gfxwrapper_opengl.h"
 #include "shader.h"
 
+#define GUI_RING_SEGMENTS 3                     // renders of vertices and indices in flight
+#define GUI_RING_FENCE_TIMEOUT 100000000ull    // 100ms
+
 class GuiBase {
 public:
     static GuiBase& instance();
     ~GuiBase();
     bool initialize();
-    void render();
+    // clip: optional rectangle in framebuffer pixels (x0, y0, x1, y1, top left origin), commands are clipped to it
+    void render(const ImVec4* clip = nullptr);
 private:
     GuiBase();
     void initShader();
-    void setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height, GLuint vertex_array_object);
-    bool renderDrawData(ImDrawData* draw_data);
+    void setupRenderState(ImDrawData* draw_data, int fb_width, int fb_height);
+    bool renderDrawData(ImDrawData* draw_data, const ImVec4* clip);
+    void reserveRing(uint32_t vertices, uint32_t indices);
+    void waitSegment(uint32_t segment);
+    bool uploadRing(ImDrawData* draw_data, uint32_t& firstVertex, uint32_t& firstIndex);
 private:
     ImGuiContext* mImguiContext;
     GLuint mFontTexture;
@@ -27,9 +34,16 @@ private:
     GLuint mAttribLocationVtxUV;
     GLuint mAttribLocationVtxColor;
     uint32_t mVboHandle, mElementsHandle;
-    GLsizeiptr mVertexBufferSize;
-    GLsizeiptr mIndexBufferSize;
-    bool mHasClipOrigin;
-    bool mUseBufferSubData;
+    GLuint mVertexArray;
+    // Both buffers are rings of GUI_RING_SEGMENTS segments, one per render, each fenced until the GPU read it.
+    // A segment holds the vertices and indices of the largest frame so far. With GL_EXT_buffer_storage both are
+    // mapped persistently for their lifetime, otherwise each render maps its segment unsynchronized.
+    uint32_t mSegmentVertices;
+    uint32_t mSegmentIndices;
+    uint32_t mSegment;
+    GLsync mSegmentFences[GUI_RING_SEGMENTS];
+    bool mPersistent;
+    ImDrawVert* mMappedVertices;   // whole ring, persistent mapping only
+    ImDrawIdx* mMappedIndices;
     std::shared_ptr<Shader> mShader;
 };
@@ -18,10 +18,10 @@ bool HandBase::loadModelFile() {
 void HandBase::setModel(const glm::mat4& model) {
     mModel = model;
 }
-bool HandBase::render(const glm::mat4& p, const glm::mat4& v) {
+bool HandBase::render() {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::scale(mModel, glm::vec3(mDefaultScale, mDefaultScale, mDefaultScale));
-    mHand->render(p, v, model);
+    mHand->render(model);
     return true;
 }
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,13 +62,13 @@ void Hand::setModel(int leftright, const glm::mat4& m) {
     }
 }
 
-void Hand::render(const glm::mat4& p, const glm::mat4& v) {
-    mLeftHand->render(p, v);
-    mRightHand->render(p, v);
+void Hand::render() {
+    mLeftHand->render();
+    mRightHand->render();
 }
 
-void Hand::render(int leftright, const glm::mat4& p, const glm::mat4& v) {
-    leftright == HAND_RIGHT ? mRightHand->render(p, v) : mLeftHand->render(p, v);
+void Hand::render(int leftright) {
+    leftright == HAND_RIGHT ? mRightHand->render() : mLeftHand->render();
 }
 
 void Hand::setBoneNodeMatrices(int leftright, const std::string& bone, const glm::mat4& m) {
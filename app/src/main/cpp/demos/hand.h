@@ -12,7 +12,7 @@ public:
     void setModelFile(const std::string& modelFile);
     bool loadModelFile();
     void setModel(const glm::mat4& model);
-    bool render(const glm::mat4& p, const glm::mat4& v);
+    bool render();
 private:
     friend class Hand;
     std::shared_ptr<Model> mHand;
@@ -30,8 +30,8 @@ public:
 
     bool initialize();
     void setModel(int leftright, const glm::mat4& m);
-    void render(const glm::mat4& p, const glm::mat4& v);
-    void render(int leftright, const glm::mat4& p, const glm::mat4& v);
+    void render();
+    void render(int leftright);
     void setBoneNodeMatrices(int leftright, const std::string& bone, const glm::mat4& m);
 private:    
     glm::mat4 mModel[HAND_COUNT];
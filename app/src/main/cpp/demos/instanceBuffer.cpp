@@ -0,0 +1,43 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <stddef.h>
+#include <algorithm>
+#include "instanceBuffer.h"
+#include "utils.h"
+#include "glState.h"
+
+// instancePositionScale reads both as one vec4
+static_assert(offsetof(PoseInstance, scale) == offsetof(PoseInstance, position) + sizeof(glm::vec3), "PoseInstance layout");
+
+InstanceBuffer::InstanceBuffer() : mBuffer(0), mLocation(0), mMaxInstances(0), mSlot(-1) {
+}
+
+InstanceBuffer::~InstanceBuffer() {
+    if (mBuffer) {
+        GLState::instance().deleteBuffers(1, &mBuffer);
+    }
+}
+
+bool InstanceBuffer::initialize(GLuint location, uint32_t maxInstances) {
+    mLocation = location;
+    mMaxInstances = maxInstances;
+    GL_CALL(glGenBuffers(1, &mBuffer));
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(PoseInstance) * mMaxInstances * INSTANCE_SLOT_COUNT, nullptr, GL_DYNAMIC_DRAW));
+    for (GLuint i = 0; i < 3; i++) {
+        GL_CALL(glEnableVertexAttribArray(mLocation + i));
+        GL_CALL(glVertexAttribDivisor(mLocation + i, 1));
+    }
+    return mBuffer != 0;
+}
+
+uint32_t InstanceBuffer::upload(const PoseInstance* instances, uint32_t count) {
+    count = std::min(count, mMaxInstances);
+    mSlot = (mSlot + 1) % INSTANCE_SLOT_COUNT;
+    const size_t offset = sizeof(PoseInstance) * mMaxInstances * mSlot;
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(PoseInstance) * count, instances));
+    GL_CALL(glVertexAttribPointer(mLocation + 0, 4, GL_FLOAT, GL_FALSE, sizeof(PoseInstance), (const void*)(offset + offsetof(PoseInstance, orientation))));
+    GL_CALL(glVertexAttribPointer(mLocation + 1, 4, GL_FLOAT, GL_FALSE, sizeof(PoseInstance), (const void*)(offset + offsetof(PoseInstance, position))));
+    GL_CALL(glVertexAttribIPointer(mLocation + 2, 1, GL_INT, sizeof(PoseInstance), (const void*)(offset + offsetof(PoseInstance, latchIndex))));
+    return count;
+}
@@ -0,0 +1,43 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stdint.h>
+#include "glm/glm.hpp"
+#include "common/gfxwrapper_opengl.h"
+
+// Pose of one instance of a repeated primitive. The vertex shader reads it as three per instance attributes
+// starting at the location passed to InstanceBuffer::initialize and builds the transform itself:
+//     layout (location = L + 0) in vec4 instanceOrientation;     // quaternion x, y, z, w
+//     layout (location = L + 1) in vec4 instancePositionScale;   // xyz: position, w: uniform scale
+//     layout (location = L + 2) in int instanceLatchIndex;       // >= 0: relative to latchedPose[instanceLatchIndex]
+//     vec3 rotate(vec4 q, vec3 v) { return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v); }
+//     vec4 local = vec4(rotate(instanceOrientation, position * instancePositionScale.w) + instancePositionScale.xyz, 1.0);
+//     vec4 world = instanceLatchIndex >= 0 ? latchedPose[instanceLatchIndex] * local : local;
+typedef struct {
+    glm::vec4 orientation;
+    glm::vec3 position;
+    float scale;
+    int32_t latchIndex;
+}PoseInstance;
+
+#define INSTANCE_SLOT_COUNT 8
+
+// Ring of PoseInstance arrays in one vertex buffer. Every draw writes the next slot with glBufferSubData and points
+// the instance attributes of the bound vertex array at it. The ring is not fenced: the driver still orders the
+// write after earlier draws that read the slot, cycling through the slots only keeps those draws further back.
+class InstanceBuffer {
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+    // With the vertex array of the primitive bound: enables the three instance attributes at location and
+    // sets their divisor. maxInstances is the most instances one upload takes.
+    bool initialize(GLuint location, uint32_t maxInstances);
+    // Returns how many of the instances were uploaded, at most maxInstances; the caller draws that many
+    // instances and uploads the rest next.
+    uint32_t upload(const PoseInstance* instances, uint32_t count);
+
+private:
+    GLuint mBuffer;
+    GLuint mLocation;
+    uint32_t mMaxInstances;
+    int32_t mSlot;
+};
@@ -0,0 +1,88 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include "lateLatch.h"
+
+#define LATE_LATCH_FENCE_TIMEOUT 1000000000  // nanoseconds
+
+LateLatch& LateLatch::instance() {
+    static LateLatch lateLatch;
+    return lateLatch;
+}
+
+LateLatch::LateLatch() : mBuffer(0), mMapped(nullptr), mSlotSize(0), mSlot(-1), mFences{} {
+}
+
+LateLatch::~LateLatch() {
+    for (int32_t i = 0; i < LATE_LATCH_SLOT_COUNT; i++) {
+        if (mFences[i] != 0) {
+            glDeleteSync(mFences[i]);
+        }
+    }
+    if (mBuffer) {
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glDeleteBuffers(1, &mBuffer);
+    }
+}
+
+bool LateLatch::initialize() {
+    if (mMapped != nullptr) {
+        return true;
+    }
+    if (glBufferStorage == nullptr || !hasGLExtension("GL_EXT_buffer_storage")) {
+        infof("GL_EXT_buffer_storage not supported, controller and hand poses are not late latched");
+        return false;
+    }
+
+    GLint alignment = 256;
+    GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    mSlotSize = (sizeof(glm::mat4) * LATE_LATCH_POSE_COUNT + alignment - 1) / alignment * alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GL_CALL(glGenBuffers(1, &mBuffer));
+    GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, mBuffer));
+    GL_CALL(glBufferStorage(GL_UNIFORM_BUFFER, mSlotSize * LATE_LATCH_SLOT_COUNT, nullptr, flags));
+    mMapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, mSlotSize * LATE_LATCH_SLOT_COUNT, flags);
+    GL_CALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    if (mMapped == nullptr) {
+        errorf("late latch buffer could not be mapped, GL error %d", glGetError());
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+        return false;
+    }
+    for (int32_t i = 0; i < LATE_LATCH_SLOT_COUNT; i++) {
+        glm::mat4* slot = (glm::mat4*)(mMapped + mSlotSize * i);
+        for (int32_t j = 0; j < LATE_LATCH_POSE_COUNT; j++) {
+            slot[j] = glm::mat4(1.0f);
+        }
+    }
+    return true;
+}
+
+bool LateLatch::isActive() const {
+    return mMapped != nullptr;
+}
+
+void LateLatch::begin() {
+    if (mMapped == nullptr) {
+        return;
+    }
+    // fence the draws that read the previous slot
+    if (mSlot >= 0) {
+        mFences[mSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    mSlot = (mSlot + 1) % LATE_LATCH_SLOT_COUNT;
+    if (mFences[mSlot] != 0) {
+        GLenum result = glClientWaitSync(mFences[mSlot], GL_SYNC_FLUSH_COMMANDS_BIT, LATE_LATCH_FENCE_TIMEOUT);
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+            warnf("late latch slot %d still in use by the GPU, result 0x%x", mSlot, result);
+        }
+        glDeleteSync(mFences[mSlot]);
+        mFences[mSlot] = 0;
+    }
+    GL_CALL(glBindBufferRange(GL_UNIFORM_BUFFER, LATE_LATCH_BINDING, mBuffer, mSlotSize * mSlot, sizeof(glm::mat4) * LATE_LATCH_POSE_COUNT));
+}
+
+glm::mat4* LateLatch::poses() {
+    return (glm::mat4*)(mMapped + mSlotSize * (mSlot < 0 ? 0 : mSlot));
+}
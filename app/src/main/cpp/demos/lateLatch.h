@@ -0,0 +1,40 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stdint.h>
+#include "glm/glm.hpp"
+#include <openxr/openxr.h>
+#include "common/gfxwrapper_opengl.h"
+#include "utils.h"
+
+// Uniform block the controller, ray and hand joint shaders read their poses from:
+//     layout(std140, binding = LATE_LATCH_BINDING) uniform LateLatch { mat4 latchedPose[LATE_LATCH_POSE_COUNT]; };
+// Shader::loadShader defines LATE_LATCH_BINDING and LATE_LATCH_POSE_COUNT for every vertex shader.
+#define LATE_LATCH_BINDING 1
+#define LATE_LATCH_AIM(hand) (hand)
+#define LATE_LATCH_JOINT(hand, joint) (HAND_COUNT + (hand) * XR_HAND_JOINT_COUNT_EXT + (joint))
+#define LATE_LATCH_POSE_COUNT (HAND_COUNT + HAND_COUNT * XR_HAND_JOINT_COUNT_EXT)
+#define LATE_LATCH_SLOT_COUNT 8
+
+// Ring of LateLatch blocks in one persistently mapped, coherent uniform buffer (GL_EXT_buffer_storage).
+// Every view takes the next slot, so the poses can be written right before its draws without waiting for
+// the GPU to finish the previous ones; a fence per slot only blocks if the ring wraps around.
+class LateLatch {
+public:
+    static LateLatch& instance();
+    ~LateLatch();
+    // false if GL_EXT_buffer_storage is missing, the renderers then keep their model matrices
+    bool initialize();
+    bool isActive() const;
+    // Moves to the next slot and binds it to LATE_LATCH_BINDING. Call once per view before its draws.
+    void begin();
+    // LATE_LATCH_POSE_COUNT matrices of the current slot, written straight into the mapped buffer
+    glm::mat4* poses();
+
+private:
+    LateLatch();
+    GLuint mBuffer;
+    uint8_t* mMapped;
+    GLsizeiptr mSlotSize;
+    int32_t mSlot;
+    GLsync mFences[LATE_LATCH_SLOT_COUNT];
+};
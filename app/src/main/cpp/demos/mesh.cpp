@@ -1,13 +1,27 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #include"mesh.h"
 #include <stddef.h>
+#include <float.h>
 #include "common/gfxwrapper_opengl.h"
+#include "glState.h"
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) 
-    : mVertices(vertices), mIndices(indices), mTextures(textures) {
+    : mVertices(vertices), mIndices(indices), mTextures(textures), mMins(FLT_MAX), mMaxs(-FLT_MAX) {
+    for (const Vertex& vertex : mVertices) {
+        mMins = glm::min(mMins, vertex.Position);
+        mMaxs = glm::max(mMaxs, vertex.Position);
+    }
     setupMesh();
 }
 
+const glm::vec3& Mesh::mins() const {
+    return mMins;
+}
+
+const glm::vec3& Mesh::maxs() const {
+    return mMaxs;
+}
+
 void Mesh::setupMesh() {
     // create buffers/arrays
     //glGenFramebuffers(1, &mFramebuffer);
@@ -16,15 +30,15 @@ void Mesh::setupMesh() {
     glGenBuffers(1, &mVBO);
     glGenBuffers(1, &mEBO);
 
-    glBindVertexArray(mVAO);
+    GLState::instance().bindVertexArray(mVAO);
     // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO);
     // A great thing about structs is that their memory layout is sequential for all its items.
     // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
     // again translates to 3/2 floats which translates to a byte array.
     glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), &mVertices[0], GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int), &mIndices[0], GL_STATIC_DRAW);
 
     // set the vertex attribute pointers
@@ -49,7 +63,7 @@ void Mesh::setupMesh() {
     // weights
     glEnableVertexAttribArray(6);
     glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Weights));
-    glBindVertexArray(0);
+    GLState::instance().bindVertexArray(0);
 }
 
 bool Mesh::activeTexture(const std::string& textureName) {
@@ -60,24 +74,23 @@ bool Mesh::activeTexture(const std::string& textureName) {
             it.active = false;
         }
     }
+    mSamplerShader = nullptr;
     return true;
 }
 
-void Mesh::draw(Shader& shader) {
-    // bind appropriate textures
+void Mesh::resolveSamplers(const Shader& shader) {
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
     unsigned int normalNr = 1;
     unsigned int heightNr = 1;
+    mSamplers.assign(mTextures.size(), UniformHandle());
     for (unsigned int i = 0; i < mTextures.size(); i++) {
         if (mTextures[i].active == false) {
             continue;
         }
-
-        glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
         // retrieve texture number (the N in diffuse_textureN)
         std::string number;
-        std::string name = mTextures[i].type;
+        const std::string& name = mTextures[i].type;
         if (name == "texture_diffuse") {
             number = std::to_string(diffuseNr++);
         }
@@ -90,18 +103,32 @@ void Mesh::draw(Shader& shader) {
         else if (name == "texture_height") {
             number = std::to_string(heightNr++); // transfer unsigned int to string
         }
+        mSamplers[i] = shader.uniform(name + number);
+    }
+    mSamplerShader = &shader;
+}
+
+void Mesh::draw(Shader& shader) {
+    if (mSamplerShader != &shader) {
+        resolveSamplers(shader);
+    }
+    // bind appropriate textures
+    for (unsigned int i = 0; i < mTextures.size(); i++) {
+        if (mTextures[i].active == false) {
+            continue;
+        }
 
+        GLState::instance().activeTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
         // now set the sampler to the correct texture unit
-        glUniform1i(glGetUniformLocation(shader.id(), (name + number).c_str()), i);
+        shader.setUniformInt(mSamplers[i], i);
         // and finally bind the texture
-        glBindTexture(GL_TEXTURE_2D, mTextures[i].id);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, mTextures[i].id);
     }
 
     // draw mesh
-    glBindVertexArray(mVAO);
+    GLState::instance().bindVertexArray(mVAO);
     glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(mIndices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 
     // always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0);
+    GLState::instance().activeTexture(GL_TEXTURE0);
 }
\ No newline at end of file
@@ -37,8 +37,13 @@ public:
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
     void draw(Shader& shader);
     bool activeTexture(const std::string &textureName);
+    // model space bounds of the vertices, in their bind pose
+    const glm::vec3& mins() const;
+    const glm::vec3& maxs() const;
 private:
     void setupMesh();
+    // sampler of each texture, resolved by name (texture_diffuse1, ...) once per shader and set of active textures
+    void resolveSamplers(const Shader& shader);
 private:
     std::vector<Vertex>       mVertices;
     std::vector<unsigned int> mIndices;
@@ -47,4 +52,8 @@ private:
     unsigned int mVAO;
     unsigned int mVBO;
     unsigned int mEBO;
+    glm::vec3 mMins;
+    glm::vec3 mMaxs;
+    std::vector<UniformHandle> mSamplers;    // one per texture, invalid for the inactive ones
+    const Shader* mSamplerShader = nullptr;  // mSamplers belong to it, nullptr: resolve again
 };
\ No newline at end of file
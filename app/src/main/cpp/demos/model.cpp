@@ -1,9 +1,14 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <float.h>
 #include "model.h"
 #include "utils.h"
+#include "profiler.h"
 #include "logger.h"
+#include "glState.h"
 
 Shader Model::mShader;
+UniformHandle Model::mModelUniform;
+UniformHandle Model::mLatchIndexUniform;
 void Model::initShader() {
     static bool init = false;
     if (init) {
@@ -20,8 +25,10 @@ void Model::initShader() {
             layout(location = 6) in vec4 weights;
             
             uniform mat4 model;
-            uniform mat4 view;
-            uniform mat4 projection;
+            uniform int latchIndex;  // -1: model alone, else model is local to latchedPose[latchIndex]
+            layout(std140, binding = LATE_LATCH_BINDING) uniform LateLatch {
+                mat4 latchedPose[LATE_LATCH_POSE_COUNT];
+            };
 
             const int MAX_BONE_NODES = 100;
             const int MAX_BONE_INFLUENCE = 4;
@@ -48,7 +55,8 @@ void Model::initShader() {
                 if (has_bone == false) {
                     total_position = vec4(aPos, 1.0f);
                 }
-                gl_Position = projection * view * model * total_position;
+                mat4 world = latchIndex >= 0 ? latchedPose[latchIndex] * model : model;
+                gl_Position = cameraViewProjection[VIEW_ID] * world * total_position;
                 TexCoords = aTexCoords;
             }
         )_";
@@ -64,12 +72,14 @@ void Model::initShader() {
                 FragColor = texture(texture_diffuse1, TexCoords);
             }
         )_";
-        mShader.loadShader(vertexShaderCode, fragmentShaderCode);
+        mShader.loadShader(vertexShaderCode, fragmentShaderCode, Shader::eyeViewCount());
+        mModelUniform = mShader.uniform("model");
+        mLatchIndexUniform = mShader.uniform("latchIndex");
         init = true;
     }
 }
 
-Model::Model(const std::string& name, bool hasBoneInfo) : mName(name), mHasBoneInfo(hasBoneInfo) {
+Model::Model(const std::string& name, bool hasBoneInfo) : mName(name), mMins(FLT_MAX), mMaxs(-FLT_MAX), mHasBoneInfo(hasBoneInfo) {
     mBoneInfoMap.clear();
 }
 
@@ -102,6 +112,7 @@ bool Model::activeMeshTexture(const std::string& meshName, const std::string& te
 
 std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName) {
     std::vector<Texture> textures;
+#ifndef DEMOS_NO_ASSIMP
     for (uint32_t i = 0; i < mat->GetTextureCount(type); i++) {
         aiString str;
         mat->GetTexture(type, i, &str);
@@ -124,6 +135,7 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
             mTexturesLoaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
         }
     }
+#endif
     return textures;
 }
 
@@ -287,6 +299,10 @@ void Model::processNode(aiNode* node, const aiScene* scene) {
 
 bool Model::loadModel(const std::string& modelFileName) {
     initShader();
+#ifdef DEMOS_NO_ASSIMP
+    errorf("built without assimp, model %s is not loaded", modelFileName.c_str());
+    return false;
+#else
     std::vector<char> fileData = readFileFromAssets(modelFileName.c_str());
     Assimp::Importer importer;
     //const aiScene* scene = importer.ReadFile(modelFileName, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
@@ -301,38 +317,87 @@ bool Model::loadModel(const std::string& modelFileName) {
     infof("model:%s, scene:%s, mNumMeshes:%d, mNumMaterials:%d, mNumAnimations:%d, mNumTextures:%d", modelFileName.c_str(), 
         scene->mName.C_Str(), scene->mNumMeshes, scene->mNumMaterials, scene->mNumAnimations, scene->mNumTextures);
     processNode(scene->mRootNode, scene);
+    for (auto &it : mMeshes) {
+        mMins = glm::min(mMins, it.second.mins());
+        mMaxs = glm::max(mMaxs, it.second.maxs());
+    }
     initializeBoneNode();
     return true;
+#endif
 }
 
-void Model::draw() {
-    GL_CALL(glFrontFace(GL_CCW));
-    GL_CALL(glCullFace(GL_BACK));
-    GL_CALL(glEnable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_DEPTH_TEST));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+void Model::draw(uint64_t visibleMeshes) {
+    GLState::instance().frontFace(GL_CCW);
+    GLState::instance().cullFace(GL_BACK);
+    GLState::instance().enable(GL_CULL_FACE);
+    GLState::instance().enable(GL_DEPTH_TEST);
+    GLState::instance().enable(GL_BLEND);
+    GLState::instance().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    uint32_t index = 0;
     for (auto &it : mMeshes) {
-        it.second.draw(mShader);
+        if (index >= 64 || (visibleMeshes & (1ull << index)) != 0) {
+            it.second.draw(mShader);
+        }
+        index++;
     }
 }
 
-bool Model::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m) {
+bool Model::render(const glm::mat4& m, int32_t latchIndex, uint64_t visibleMeshes) {
+    GPU_PROFILE_SCOPE(gpuMarker_Model);
     mShader.use();
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-    draw();
-    glUseProgram(0);
+    mShader.setUniformMat4(mModelUniform, m);
+    mShader.setUniformInt(mLatchIndexUniform, latchIndex);
+    draw(visibleMeshes);
     return true;
 }
 
+typedef struct {
+    glm::mat4 model;
+    int32_t latchIndex;
+    uint64_t visibleMeshes;
+}ModelParams;
+
+void Model::submit(RenderQueue& queue, const glm::mat4& m, int32_t latchIndex, const glm::mat4& world) {
+    // skinning moves the vertices away from their bind pose bounds, only rigid models are culled
+    uint64_t visibleMeshes = MODEL_ALL_MESHES;
+    if (!mHasBoneInfo) {
+        if (!queue.isVisible(world, mMins, mMaxs)) {
+            return;
+        }
+        uint32_t index = 0;
+        for (auto &it : mMeshes) {
+            if (index < 64 && !queue.isVisible(world, it.second.mins(), it.second.maxs())) {
+                visibleMeshes &= ~(1ull << index);
+            }
+            index++;
+        }
+        if (visibleMeshes == 0) {
+            return;
+        }
+    }
+
+    DrawPacket packet = {};
+    packet.pass = renderPass_Opaque;
+    packet.program = mShader.id();
+    packet.draw = drawPacket;
+    packet.object = this;
+    ModelParams* params = (ModelParams*)queue.submit(packet, glm::vec3(world[3]), sizeof(ModelParams));
+    params->model = m;
+    params->latchIndex = latchIndex;
+    params->visibleMeshes = visibleMeshes;
+}
+
+void Model::drawPacket(const RenderQueue& queue, const DrawPacket& packet) {
+    const ModelParams* params = (const ModelParams*)packet.params;
+    ((Model*)packet.object)->render(params->model, params->latchIndex, params->visibleMeshes);
+}
+
 void Model::initializeBoneNode() {
     mShader.use();
     glm::mat4 m = glm::mat4(1.0f);
     for (auto it : mBoneInfoMap) {
-        std::string name = "finalBoneNodesMatrices[" + std::to_string(it.second->id) +  "]";
-        mShader.setUniformMat4(name, m);
+        it.second->matrix = mShader.uniform("finalBoneNodesMatrices", it.second->id);
+        mShader.setUniformMat4(it.second->matrix, m);
     }
 }
 
@@ -346,11 +411,11 @@ int Model::getBoneNodeIndexByName(const std::string& name) const {
 }
 
 void Model::setBoneNodeMatrices(const std::string& bone, const glm::mat4& m) {
-    int index = getBoneNodeIndexByName(bone);
-    if (index < 0) {
+    auto it = mBoneInfoMap.find(bone);
+    if (it == mBoneInfoMap.end()) {
+        errorf("not found bone %s", bone.c_str());
         return;
     }
-    std::string name = "finalBoneNodesMatrices[" + std::to_string(index) +  "]";
     mShader.use();
-    mShader.setUniformMat4(name, m);
+    mShader.setUniformMat4(it->second->matrix, m);
 }
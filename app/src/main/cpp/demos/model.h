@@ -5,12 +5,15 @@
 #include <vector>
 #include <memory>
 #include "mesh.h"
+#include "renderQueue.h"
 #include "shader.h"
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
 #include "shader.h"
 
+#define MODEL_ALL_MESHES (~0ull)
+
 class Model {
 public:
     Model() = delete;
@@ -26,7 +29,12 @@ public:
     bool bindMeshTexture(const std::string& meshName, const std::string& textureName);
     bool activeMeshTexture(const std::string& meshName, const std::string& textureName);
 
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m);
+    // latchIndex >= 0: m is relative to that pose of the LateLatch block
+    // visibleMeshes: bit i draws the i-th mesh by name, meshes past the 64th are always drawn
+    bool render(const glm::mat4& m, int32_t latchIndex = -1, uint64_t visibleMeshes = MODEL_ALL_MESHES);
+    // queued render, culled against the frustums of the queue. world is m in world space (for a latched draw the
+    // last pose set on the CPU), it culls the model and its meshes and orders it among the opaque draws.
+    void submit(RenderQueue& queue, const glm::mat4& m, int32_t latchIndex, const glm::mat4& world);
 
     int getBoneNodeIndexByName(const std::string& name) const;
 
@@ -34,21 +42,25 @@ public:
 
 private:
     void initShader();
+    static void drawPacket(const RenderQueue& queue, const DrawPacket& packet);
     std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
     std::vector<Texture> loadMaterialTextures_force(aiMaterial* mat, aiTextureType type, std::string typeName, std::string file);
     void processNode(aiNode* node, const aiScene* scene);
     Mesh processMesh(aiMesh* mesh, const aiScene* scene);
     void processMeshBone(aiMesh* mesh, std::vector<Vertex>& vertices);
     void initializeBoneNode();
-    void draw();
+    void draw(uint64_t visibleMeshes);
 
 private:
     std::string mName;
     std::map<std::string, Mesh> mMeshes;
+    glm::vec3 mMins;   // bounds of all meshes
+    glm::vec3 mMaxs;
     bool mHasBoneInfo;
     
     struct boneInfo {
         int id;
+        UniformHandle matrix;  // finalBoneNodesMatrices[id]
         boneInfo(int count) : id(count) {};
     };
     std::map<std::string, std::shared_ptr<boneInfo>> mBoneInfoMap;
@@ -61,4 +73,6 @@ private:
     std::map<std::string, std::vector<std::string>> mMeshTexturesMap;
 
     static Shader mShader;
+    static UniformHandle mModelUniform;
+    static UniformHandle mLatchIndexUniform;
 };
\ No newline at end of file
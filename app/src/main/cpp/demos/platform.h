@@ -0,0 +1,22 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <string>
+#include <vector>
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <jni.h>
+#endif
+
+// What the demos take from the operating system. platform_android.cpp implements it with system properties,
+// the AAssetManager and JNI, platform_linux.cpp for the headless host build.
+
+// "" when the property is not set. The host reads debug.xr.multiview from the environment as DEBUG_XR_MULTIVIEW.
+std::string getSystemProperty(const char* name);
+// Whole file of the application assets, empty when it is missing.
+std::vector<char> readFileFromAssets(const char* file);
+// Let the media scanner pick up a file written under path.
+void refreshMedia(const std::string& path);
+
+#ifdef XR_USE_PLATFORM_ANDROID
+void setJNIEnv(JNIEnv *env);
+JNIEnv* getJNIEnv();   //of the render thread
+#endif
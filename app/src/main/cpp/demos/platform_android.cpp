@@ -0,0 +1,61 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include "platform.h"
+#include "utils.h"
+
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <string.h>
+#include <sys/system_properties.h>
+#include <jni.h>
+#include <android/asset_manager_jni.h>
+#include <android/asset_manager.h>
+static AAssetManager *s_nativeasset = nullptr;
+static JNIEnv *s_env = nullptr;
+static jobject s_jobj;
+static jmethodID s_mid;
+//called by java
+extern "C" JNIEXPORT 
+void JNICALL Java_com_picovr_openxr_MainActivity_setNativeAssetManager(JNIEnv *env, jobject instance, jobject assetManager) {
+    //s_env = env;
+    s_nativeasset = AAssetManager_fromJava(env, assetManager);
+    if (s_nativeasset == nullptr) {
+        errorf("s_nativeasset is nullptr!");
+    }
+
+    jclass cls = env->GetObjectClass(instance);
+    s_jobj = env->NewGlobalRef(instance);
+    s_mid = env->GetMethodID(cls, "scanFile", "(Ljava/lang/String;)V");
+    //env->CallVoidMethod(s_jobj, s_mid, env->NewStringUTF("/sdcard"));
+}
+
+void setJNIEnv(JNIEnv *env) {
+    s_env = env;
+}
+
+JNIEnv* getJNIEnv() {
+    return s_env;
+}
+
+std::string getSystemProperty(const char* name) {
+    char value[PROP_VALUE_MAX] = {0};
+    __system_property_get(name, value);
+    return value;
+}
+
+std::vector<char> readFileFromAssets(const char* filename) {
+    AAsset *pathAsset = AAssetManager_open(s_nativeasset, filename, AASSET_MODE_UNKNOWN);
+    if (pathAsset == nullptr) {
+        errorf("asset %s not found", filename);
+        return {};
+    }
+    off_t assetLength = AAsset_getLength(pathAsset);
+    unsigned char *fileData = (unsigned char *) AAsset_getBuffer(pathAsset);
+    std::vector<char> buffer(assetLength);
+    memcpy(buffer.data(), fileData, assetLength);
+    AAsset_close(pathAsset);
+    return buffer;
+}
+
+void refreshMedia(const std::string& path) {
+    s_env->CallVoidMethod(s_jobj, s_mid, s_env->NewStringUTF(path.c_str()));
+}
+#endif
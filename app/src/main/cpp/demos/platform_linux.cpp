@@ -0,0 +1,38 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include "platform.h"
+#include "utils.h"
+
+#ifndef XR_USE_PLATFORM_ANDROID
+#include <stdlib.h>
+#include <ctype.h>
+#include <fstream>
+#include <iterator>
+
+// Assets are read from the app/src/main/assets directory of the source tree unless DEMOS_ASSETS points elsewhere.
+#ifndef DEMOS_ASSETS_DIR
+#define DEMOS_ASSETS_DIR "assets"
+#endif
+
+std::string getSystemProperty(const char* name) {
+    std::string variable(name);
+    for (char& c : variable) {
+        c = (c == '.') ? '_' : (char)toupper(c);
+    }
+    const char* value = getenv(variable.c_str());
+    return value != nullptr ? value : "";
+}
+
+std::vector<char> readFileFromAssets(const char* filename) {
+    const char* directory = getenv("DEMOS_ASSETS");
+    std::string path = std::string(directory != nullptr ? directory : DEMOS_ASSETS_DIR) + '/' + filename;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        errorf("asset %s not found", path.c_str());
+        return {};
+    }
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void refreshMedia(const std::string& /*path*/) {
+}
+#endif
@@ -6,19 +6,30 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <chrono>
 #include <aaudio/AAudio.h>
+#include <android/native_window_jni.h>
 #include <stddef.h>
 #include "player.h"
 #include "utils.h"
+#include "profiler.h"
+#include "glState.h"
 
 Shader Player::mShader;
+UniformHandle Player::mModelUniform;
 Player::Player() : mExtractor(nullptr), mFd(-1), mStarted(false) {
     mVideoTrackIndex = -1;
     mAudioTrackIndex = -1;
     mDecodeRunning = mPlayAudioRunning = false;
     mVAO = mVBO= mEBO = 0;
     mPlayModel = playModel_None;
+    mSession = XR_NULL_HANDLE;
+    mCreateSurfaceSwapchain = nullptr;
+    mSurfaceSwapchain = XR_NULL_HANDLE;
+    mSurfaceWindow = nullptr;
+    mSurfaceWidth = mSurfaceHeight = 0;
+    mFrameTexture = 0;
 }
 
 Player::~Player() {
@@ -31,7 +42,10 @@ Player::~Player() {
         mFd = -1;
     }
     if (mVAO != 0) {
-        glDeleteVertexArrays(1, &mVAO);
+        GLState::instance().deleteVertexArrays(1, &mVAO);
+    }
+    if (mSurfaceWindow != nullptr) {
+        ANativeWindow_release(mSurfaceWindow);
     }
 }
 
@@ -46,14 +60,14 @@ bool Player::initShader() {
             precision highp float;
             layout(location = 0) in vec3 aPosition;
             layout(location = 1) in vec2 aTexCoord;
-            uniform mat4 projection;
-            uniform mat4 view;
+            layout(location = 2) in vec2 aTexCoord1;
             uniform mat4 model;
             out vec2 vTexCoord;
             void main()
             {
-                vTexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
-                gl_Position = projection * view * model * vec4(aPosition, 1.0);
+                vec2 texCoord = (VIEW_ID == 0) ? aTexCoord : aTexCoord1;
+                vTexCoord = vec2(texCoord.x, 1.0 - texCoord.y);
+                gl_Position = cameraViewProjection[VIEW_ID] * model * vec4(aPosition, 1.0);
             }
         )_";
 
@@ -70,9 +84,10 @@ bool Player::initShader() {
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, Shader::eyeViewCount()) == false) {
             return false;
         }
+        mModelUniform = mShader.uniform("model");
         init = true;
     }
     return true;
@@ -95,6 +110,16 @@ void Player::InitializePfn() {
     if (m_glEGLImageTargetTexture2DOES == nullptr) {
         errorf("glEGLImageTargetTexture2DOES is nullptr ");
     }
+    m_eglCreateSyncKHR = (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+    m_eglWaitSyncKHR = (PFNEGLWAITSYNCKHRPROC)eglGetProcAddress("eglWaitSyncKHR");
+    m_eglDestroySyncKHR = (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+    if (m_eglCreateSyncKHR == nullptr || m_eglWaitSyncKHR == nullptr || m_eglDestroySyncKHR == nullptr) {
+        warnf("EGL_KHR_wait_sync is not supported, decoded frames are waited for on the cpu");
+    }
+    m_eglDupNativeFenceFDANDROID = (PFNEGLDUPNATIVEFENCEFDANDROIDPROC)eglGetProcAddress("eglDupNativeFenceFDANDROID");
+    if (m_eglDupNativeFenceFDANDROID == nullptr) {
+        warnf("EGL_ANDROID_native_fence_sync is not supported, shown frames are given back without a fence");
+    }
 }
 
 bool Player::initialize(EGLDisplay display) {
@@ -121,9 +146,9 @@ void Player::setPlayStyle(PlayModel model) {
     GLuint aPosition = mShader.getAttribLocation("aPosition");
     GLuint aTexCoord = mShader.getAttribLocation("aTexCoord");
 
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO));
+    GLState::instance().bindVertexArray(mVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO);
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
 
     GL_CALL(glEnableVertexAttribArray(aPosition));
     GL_CALL(glEnableVertexAttribArray(aTexCoord));
@@ -132,15 +157,21 @@ void Player::setPlayStyle(PlayModel model) {
         GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertexCoordinates2D.size() * sizeof(SampleVertex2D), mVertexCoordinates2D.data(), GL_STATIC_DRAW));
         GL_CALL(glVertexAttribPointer(aPosition, sizeof(Position) / sizeof(float),   GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, position)));
         GL_CALL(glVertexAttribPointer(aTexCoord, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, texCoords)));
+        if (Shader::eyeViewCount() > 1) {
+            // 2D content shows the same coordinates to both views
+            GLuint aTexCoord1 = mShader.getAttribLocation("aTexCoord1");
+            GL_CALL(glEnableVertexAttribArray(aTexCoord1));
+            GL_CALL(glVertexAttribPointer(aTexCoord1, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex2D), (const void*)offsetof(SampleVertex2D, texCoords)));
+        }
     } else {
         GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertexCoordinates3D.size() * sizeof(SampleVertex3D), mVertexCoordinates3D.data(), GL_STATIC_DRAW));
         GL_CALL(glVertexAttribPointer(aPosition, sizeof(Position) / sizeof(float),   GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, position)));
     }
     GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(), GL_STATIC_DRAW));
 
-    GL_CALL(glBindVertexArray(GL_NONE));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, GL_NONE));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE));
+    GLState::instance().bindVertexArray(GL_NONE);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_NONE);
 }
 
 PlayModel Player::getPlayStyle() const {
@@ -231,60 +262,164 @@ void Player::createVertexAndIndiceData(const PlayModel model) {
     }
 }
 
-bool Player::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, int32_t eye) {
+bool Player::render(const glm::mat4& m, int32_t eye) {
+    GPU_PROFILE_SCOPE(gpuMarker_Player);
 
-    std::shared_ptr<MediaFrame> frame = getVideoFrame();
-    if (frame.get() == nullptr) {
-        return false;
-    }
-
-    AImage* image = reinterpret_cast<AImage*>(frame->image);
-    AHardwareBuffer* hwBuff = nullptr;
-    if (AImage_getHardwareBuffer(image, &hwBuff) != AMEDIA_OK) {
-        errorf("AImage_getHardwareBuffer error ");
-        return false;
-    }
-    EGLClientBuffer clientBuffer = m_eglGetNativeClientBufferANDROID(hwBuff);
-    EGLint eglImageAttributes[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
-    EGLImageKHR imagekhr = m_eglCreateImageKHR(mEglDisplay, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID, clientBuffer, eglImageAttributes);
-    if (imagekhr == nullptr) {
-        errorf("imagekhr is nullptr ");
+    if (mFrameTexture == 0) {
         return false;
     }
 
     mShader.use(); 
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-
-    GL_CALL(glFrontFace(GL_CCW));
-    GL_CALL(glCullFace(GL_BACK));
-    GL_CALL(glEnable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
+    mShader.setUniformMat4(mModelUniform, m);
+
+    GLState::instance().frontFace(GL_CCW);
+    GLState::instance().cullFace(GL_BACK);
+    GLState::instance().enable(GL_CULL_FACE);
+    GLState::instance().enable(GL_BLEND);
+    GLState::instance().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::instance().bindVertexArray(mVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO);
 
     if (mPlayModel >= playModel_3D_SBS) {
         GLuint aTexCoord = mShader.getAttribLocation("aTexCoord");
         GL_CALL(glEnableVertexAttribArray(aTexCoord));
-        if (eye == EYE_LEFT) {
+        if (Shader::eyeViewCount() > 1) {
+            // both eyes in one pass, the vertex shader picks the coordinates by view id
+            GLuint aTexCoord1 = mShader.getAttribLocation("aTexCoord1");
+            GL_CALL(glEnableVertexAttribArray(aTexCoord1));
+            GL_CALL(glVertexAttribPointer(aTexCoord,  sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords0)));
+            GL_CALL(glVertexAttribPointer(aTexCoord1, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords1)));
+        } else if (eye == EYE_LEFT) {
             GL_CALL(glVertexAttribPointer(aTexCoord, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords0)));
         } else {
             GL_CALL(glVertexAttribPointer(aTexCoord, sizeof(Coordinate) / sizeof(float), GL_FLOAT, GL_FALSE, sizeof(SampleVertex3D), (const void*)offsetof(SampleVertex3D, texCoords1)));
         }
     }
 
-    m_glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, imagekhr);
+    GLState::instance().activeTexture(GL_TEXTURE0);
+    GLState::instance().bindTexture(GL_TEXTURE_EXTERNAL_OES, mFrameTexture);
 
     GL_CALL(glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, (const void*)0));
 
-    m_eglDestroyImageKHR(mEglDisplay, imagekhr);
-    releaseVideoFrame(frame);
-
     return true;
 }
 
+void Player::update() {
+    // the frame of the previous update is given back once its successor is due
+    if (mCurrentFrame.get() != nullptr) {
+        releaseVideoFrame(mCurrentFrame);
+        mCurrentFrame = nullptr;
+    }
+    releaseImportedBuffers(false);
+    mFrameTexture = 0;
+
+    std::shared_ptr<MediaFrame> frame = getVideoFrame();
+    if (frame.get() == nullptr) {
+        return;
+    }
+    AHardwareBuffer* buffer = nullptr;
+    if (AImage_getHardwareBuffer(reinterpret_cast<AImage*>(frame->image), &buffer) != AMEDIA_OK) {
+        errorf("AImage_getHardwareBuffer error ");
+        return;
+    }
+    mFrameTexture = importBuffer(buffer);
+    if (frame->fenceFd >= 0) {
+        waitFence(frame->fenceFd);
+        frame->fenceFd = -1;
+    }
+    mCurrentFrame = frame;
+}
+
+GLuint Player::importBuffer(AHardwareBuffer* buffer) {
+    auto it = mImportedBuffers.find(buffer);
+    if (it != mImportedBuffers.end()) {
+        return it->second.texture;
+    }
+
+    EGLClientBuffer clientBuffer = m_eglGetNativeClientBufferANDROID(buffer);
+    EGLint eglImageAttributes[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+    EGLImageKHR imagekhr = m_eglCreateImageKHR(mEglDisplay, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID, clientBuffer, eglImageAttributes);
+    if (imagekhr == EGL_NO_IMAGE_KHR) {
+        errorf("imagekhr is nullptr ");
+        return 0;
+    }
+    ImportedBuffer imported;
+    imported.image = imagekhr;
+    GL_CALL(glGenTextures(1, &imported.texture));
+    GLState::instance().activeTexture(GL_TEXTURE0);
+    GLState::instance().bindTexture(GL_TEXTURE_EXTERNAL_OES, imported.texture);
+    GL_CALL(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    m_glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, imagekhr);
+
+    // keeps the address from being handed to another buffer while it is a key
+    AHardwareBuffer_acquire(buffer);
+    mImportedBuffers[buffer] = imported;
+    debugf("imported buffer %p, %zu buffers", buffer, mImportedBuffers.size());
+    return imported.texture;
+}
+
+// all: every imported buffer, the reader is gone. Otherwise the buffers the reader removed from its pool.
+void Player::releaseImportedBuffers(bool all) {
+    std::vector<AHardwareBuffer*> removed;
+    {
+        std::lock_guard<std::mutex> guard(mRemovedBuffersMutex);
+        removed.swap(mRemovedBuffers);
+    }
+    if (all) {
+        removed.clear();
+        for (auto& imported : mImportedBuffers) {
+            removed.push_back(imported.first);
+        }
+    }
+    for (AHardwareBuffer* buffer : removed) {
+        auto it = mImportedBuffers.find(buffer);
+        if (it == mImportedBuffers.end()) {
+            continue;
+        }
+        GLState::instance().deleteTextures(1, &it->second.texture);
+        m_eglDestroyImageKHR(mEglDisplay, it->second.image);
+        AHardwareBuffer_release(buffer);
+        mImportedBuffers.erase(it);
+    }
+}
+
+// A native fence signaled when the GPU finished the commands issued so far, -1 when there is none.
+int32_t Player::createReleaseFence() {
+    if (m_eglCreateSyncKHR == nullptr || m_eglDestroySyncKHR == nullptr || m_eglDupNativeFenceFDANDROID == nullptr) {
+        return -1;
+    }
+    const EGLint attributes[] = {EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID, EGL_NONE};
+    EGLSyncKHR sync = m_eglCreateSyncKHR(mEglDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, attributes);
+    if (sync == EGL_NO_SYNC_KHR) {
+        warnf("eglCreateSyncKHR error 0x%x", eglGetError());
+        return -1;
+    }
+    // the fd exists once the fence command reached the driver
+    GL_CALL(glFlush());
+    const int32_t fenceFd = m_eglDupNativeFenceFDANDROID(mEglDisplay, sync);
+    m_eglDestroySyncKHR(mEglDisplay, sync);
+    return fenceFd == EGL_NO_NATIVE_FENCE_FD_ANDROID ? -1 : fenceFd;
+}
+
+// Makes the GPU wait for the decoder before it samples the frame, the CPU only waits without EGL_KHR_wait_sync.
+void Player::waitFence(int32_t fenceFd) {
+    if (m_eglCreateSyncKHR != nullptr && m_eglWaitSyncKHR != nullptr && m_eglDestroySyncKHR != nullptr) {
+        const EGLint attributes[] = {EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fenceFd, EGL_NONE};
+        EGLSyncKHR sync = m_eglCreateSyncKHR(mEglDisplay, EGL_SYNC_NATIVE_FENCE_ANDROID, attributes);
+        if (sync != EGL_NO_SYNC_KHR) {
+            // the sync owns the fd now
+            m_eglWaitSyncKHR(mEglDisplay, sync, 0);
+            m_eglDestroySyncKHR(mEglDisplay, sync);
+            return;
+        }
+        warnf("eglCreateSyncKHR error 0x%x", eglGetError());
+    }
+    struct pollfd pollFd = {fenceFd, POLLIN, 0};
+    poll(&pollFd, 1, -1);
+    close(fenceFd);
+}
+
 bool Player::start(const std::string& file) {
     if (mFileName == file) {
         return true;
@@ -321,6 +456,9 @@ bool Player::start(const std::string& file) {
     }
     mTrackCount = AMediaExtractor_getTrackCount(mExtractor);
     if (mTrackCount > 0) {
+        if (mCreateSurfaceSwapchain != nullptr && !createSurfaceSwapchain()) {
+            warnf("no surface swapchain for %s, drawing the video", file.c_str());
+        }
         mThreadDecode = std::thread(&Player::threadDecode, this);
     } else {
         AMediaExtractor_delete(mExtractor);
@@ -351,8 +489,17 @@ bool Player::stop() {
     }
 
     mDecodedVideoFrameListMutex.lock();
+    for (auto& frame : mDecodedVideoFrameList) {
+        if (frame->fenceFd >= 0) {
+            close(frame->fenceFd);
+        }
+    }
     mDecodedVideoFrameList.clear();
     mDecodedVideoFrameListMutex.unlock();
+    mCurrentFrame = nullptr;
+    mFrameTexture = 0;
+    // the next video decodes into a new reader with buffers of its own
+    releaseImportedBuffers(true);
 
     mDecodedAudioFrameListMutex.lock();
     mDecodedAudioFrameList.clear();
@@ -366,15 +513,147 @@ bool Player::stop() {
     return true;
 }
 
-bool Player::render(const glm::mat4& p, const glm::mat4& v, int32_t eye) {
-    return render(p, v, mModel, eye);
+bool Player::render(int32_t eye) {
+    return render(mModel, eye);
+}
+
+void Player::submit(RenderQueue& queue, int32_t eye) {
+    if (mSurfaceWindow != nullptr) {
+        // presented by layers()
+        return;
+    }
+    DrawPacket packet = {};
+    packet.pass = renderPass_Transparent;
+    packet.program = mShader.id();
+    packet.vertexArray = mVAO;
+    packet.draw = drawPacket;
+    packet.object = this;
+    int32_t* params = (int32_t*)queue.submit(packet, glm::vec3(mModel[3]), sizeof(int32_t));
+    *params = eye;
+}
+
+void Player::drawPacket(const RenderQueue& queue, const DrawPacket& packet) {
+    ((Player*)packet.object)->render(*(const int32_t*)packet.params);
+}
+
+void Player::setSurfaceSwapchain(XrSession session, PFN_xrCreateSwapchainAndroidSurfaceKHR createSurfaceSwapchain) {
+    mSession = session;
+    mCreateSurfaceSwapchain = createSurfaceSwapchain;
+}
+
+// Sized to the video track of mExtractor, the swapchain of the previous video is kept when its size matches.
+bool Player::createSurfaceSwapchain() {
+    int32_t width = 0, height = 0;
+    for (auto i = 0; i < mTrackCount; i++) {
+        const char *mime = nullptr;
+        AMediaFormat *format = AMediaExtractor_getTrackFormat(mExtractor, i);
+        AMediaFormat_getString(format, "mime", &mime);
+        if (strstr(mime, "video")) {
+            AMediaFormat_getInt32(format, "width", &width);
+            AMediaFormat_getInt32(format, "height", &height);
+        }
+        AMediaFormat_delete(format);
+    }
+    if (width <= 0 || height <= 0) {
+        errorf("no video size");
+        return false;
+    }
+    if (mSurfaceWindow != nullptr && width == mSurfaceWidth && height == mSurfaceHeight) {
+        return true;
+    }
+    if (mSurfaceWindow != nullptr) {
+        ANativeWindow_release(mSurfaceWindow);
+        mSurfaceWindow = nullptr;
+        xrDestroySwapchain(mSurfaceSwapchain);
+        mSurfaceSwapchain = XR_NULL_HANDLE;
+    }
+
+    XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+    swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+    swapchainCreateInfo.width = width;
+    swapchainCreateInfo.height = height;
+    swapchainCreateInfo.sampleCount = 1;
+    swapchainCreateInfo.faceCount = 1;
+    swapchainCreateInfo.arraySize = 1;
+    swapchainCreateInfo.mipCount = 1;
+    jobject surface = nullptr;
+    XrResult result = mCreateSurfaceSwapchain(mSession, &swapchainCreateInfo, &mSurfaceSwapchain, &surface);
+    if (XR_FAILED(result) || surface == nullptr) {
+        errorf("xrCreateSwapchainAndroidSurfaceKHR error %d", result);
+        mSurfaceSwapchain = XR_NULL_HANDLE;
+        return false;
+    }
+    mSurfaceWindow = ANativeWindow_fromSurface(getJNIEnv(), surface);
+    if (mSurfaceWindow == nullptr) {
+        errorf("ANativeWindow_fromSurface error");
+        xrDestroySwapchain(mSurfaceSwapchain);
+        mSurfaceSwapchain = XR_NULL_HANDLE;
+        return false;
+    }
+    mSurfaceWidth = width;
+    mSurfaceHeight = height;
+    infof("surface swapchain %dx%d", width, height);
+    return true;
+}
+
+uint32_t Player::layers(XrSpace space, XrCompositionLayerBaseHeader** layers) {
+    if (mSurfaceWindow == nullptr || mFileName.empty() || mPlayModel == playModel_None) {
+        return 0;
+    }
+    const bool stereo = mPlayModel >= playModel_3D_SBS;
+    const bool sideBySide = mPlayModel == playModel_3D_SBS || mPlayModel == playModel_3D_SBS_360;
+    const bool sphere = mPlayModel == playModel_2D_180 || mPlayModel == playModel_2D_360 || mPlayModel == playModel_3D_SBS_360 || mPlayModel == playModel_3D_OU_360;
+
+    // the same model the drawn quad or sphere is placed with, the quad spans -0.5..0.5 in model space
+    XrExtent2Df size;
+    const XrPosef pose = quadLayerPose(mModel, 1.0f, size);
+
+    const uint32_t count = stereo ? 2 : 1;
+    for (uint32_t i = 0; i < count; i++) {
+        XrSwapchainSubImage subImage{};
+        subImage.swapchain = mSurfaceSwapchain;
+        subImage.imageRect = {{0, 0}, {mSurfaceWidth, mSurfaceHeight}};
+        if (stereo && sideBySide) {
+            subImage.imageRect = {{(int32_t)i * mSurfaceWidth / 2, 0}, {mSurfaceWidth / 2, mSurfaceHeight}};
+        } else if (stereo) {
+            // the left eye is the upper half, image rows count from the bottom
+            subImage.imageRect = {{0, (int32_t)(1 - i) * mSurfaceHeight / 2}, {mSurfaceWidth, mSurfaceHeight / 2}};
+        }
+        const XrEyeVisibility eyeVisibility = !stereo ? XR_EYE_VISIBILITY_BOTH : (i == EYE_LEFT ? XR_EYE_VISIBILITY_LEFT : XR_EYE_VISIBILITY_RIGHT);
+
+        if (sphere) {
+            XrCompositionLayerEquirect2KHR& layer = mEquirectLayers[i];
+            layer = {XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR};
+            layer.space = space;
+            layer.eyeVisibility = eyeVisibility;
+            layer.subImage = subImage;
+            layer.pose = pose;
+            layer.radius = 0.0f;   // infinite
+            layer.centralHorizontalAngle = mPlayModel == playModel_2D_180 ? (float)PI : 2.0f * (float)PI;
+            layer.upperVerticalAngle = (float)PI / 2.0f;
+            layer.lowerVerticalAngle = -(float)PI / 2.0f;
+            layers[i] = reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer);
+        } else {
+            XrCompositionLayerQuad& layer = mQuadLayers[i];
+            layer = {XR_TYPE_COMPOSITION_LAYER_QUAD};
+            layer.space = space;
+            layer.eyeVisibility = eyeVisibility;
+            layer.subImage = subImage;
+            layer.pose = pose;
+            layer.size = size;
+            layers[i] = reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer);
+        }
+    }
+    return count;
 }
 
 void AImageReaderImageCallback(void* context, AImageReader* reader) {
     Player* thiz = (Player*)context;
     AImage* image = nullptr;
-    if (AImageReader_acquireLatestImage(reader, &image) != AMEDIA_OK) {
-        errorf("AImageReader_acquireLatestImage");
+    int fenceFd = -1;
+    // the decoder may still be writing the image, update() makes the GPU wait for the fence instead of this thread
+    if (AImageReader_acquireNextImageAsync(reader, &image, &fenceFd) != AMEDIA_OK) {
+        errorf("AImageReader_acquireNextImageAsync");
         return;
     }
     std::int64_t presentationTimeMs = 0;
@@ -393,6 +672,7 @@ void AImageReaderImageCallback(void* context, AImageReader* reader) {
     frame->size = 0;
     frame->bufferIndex = -1;
     frame->image = (void*)image;
+    frame->fenceFd = fenceFd;
 
     thiz->mDecodedVideoFrameListMutex.lock();
     thiz->mDecodedVideoFrameList.push_back(frame);
@@ -400,6 +680,12 @@ void AImageReaderImageCallback(void* context, AImageReader* reader) {
     thiz->mDecodedVideoFrameListMutex.unlock();
 }
 
+void AImageReaderBufferRemovedCallback(void* context, AImageReader* reader, AHardwareBuffer* buffer) {
+    Player* thiz = (Player*)context;
+    std::lock_guard<std::mutex> guard(thiz->mRemovedBuffersMutex);
+    thiz->mRemovedBuffers.push_back(buffer);
+}
+
 void Player::threadDecode() {
     infof("threadDecode+++");
     //create surface
@@ -410,18 +696,30 @@ void Player::threadDecode() {
     AImageReader_ImageListener imageListener;
     imageListener.context = this;
     imageListener.onImageAvailable = &AImageReaderImageCallback;
+    AImageReader_BufferRemovedListener bufferRemovedListener;
+    bufferRemovedListener.context = this;
+    bufferRemovedListener.onBufferRemoved = &AImageReaderBufferRemovedCallback;
 
-    if (AImageReader_newWithUsage(1, 1, AIMAGE_FORMAT_PRIVATE, imageReaderFlags, maxImageCount, &imageReader) != AMEDIA_OK) {
-        errorf("AImageReader_newWithUsage error");
-        return;
-    }
-    if (AImageReader_setImageListener(imageReader, &imageListener) != AMEDIA_OK) {
-        errorf("AImageReader_setImageListener error");
-        return;
-    }
-    if (AImageReader_getWindow(imageReader, &surface) != AMEDIA_OK) {
-        errorf("AImageReader_getWindow error");
-        return;
+    if (mSurfaceWindow != nullptr) {
+        // the compositor samples the frames, they never reach mDecodedVideoFrameList
+        surface = mSurfaceWindow;
+    } else {
+        if (AImageReader_newWithUsage(1, 1, AIMAGE_FORMAT_PRIVATE, imageReaderFlags, maxImageCount, &imageReader) != AMEDIA_OK) {
+            errorf("AImageReader_newWithUsage error");
+            return;
+        }
+        if (AImageReader_setImageListener(imageReader, &imageListener) != AMEDIA_OK) {
+            errorf("AImageReader_setImageListener error");
+            return;
+        }
+        if (AImageReader_setBufferRemovedListener(imageReader, &bufferRemovedListener) != AMEDIA_OK) {
+            errorf("AImageReader_setBufferRemovedListener error");
+            return;
+        }
+        if (AImageReader_getWindow(imageReader, &surface) != AMEDIA_OK) {
+            errorf("AImageReader_getWindow error");
+            return;
+        }
     }
 
     AMediaCodec* videoCodec = nullptr;
@@ -476,9 +774,21 @@ void Player::threadDecode() {
 
     mVideoPtsOffset = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
+    // A surface swapchain shows a frame as soon as it is released, so it is held until its presentation time.
+    ssize_t pendingVideoBuffer = -1;
+    uint64_t pendingVideoPts = 0;
+
     mDecodeRunning = true;
     while (mDecodeRunning) {
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (pendingVideoBuffer >= 0) {
+            uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();  //in millisecond
+            if (now < pendingVideoPts) {
+                continue;
+            }
+            AMediaCodec_releaseOutputBuffer(videoCodec, pendingVideoBuffer, true);
+            pendingVideoBuffer = -1;
+        }
         mDecodedVideoFrameListMutex.lock();
         int32_t videoFrameListSize = mDecodedVideoFrameList.size();
         mDecodedVideoFrameListMutex.unlock();
@@ -523,7 +833,12 @@ void Player::threadDecode() {
             if (codec == videoCodec) {
                 if (bufferIndex != AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED && bufferIndex != AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED && bufferIndex != AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
                     //infof("to AMediaCodec_releaseOutputBuffer");
-                    AMediaCodec_releaseOutputBuffer(codec, bufferIndex, true);
+                    if (mSurfaceWindow != nullptr) {
+                        pendingVideoBuffer = bufferIndex;
+                        pendingVideoPts = outputBufferInfo.presentationTimeUs / 1000 + mVideoPtsOffset;
+                    } else {
+                        AMediaCodec_releaseOutputBuffer(codec, bufferIndex, true);
+                    }
                 }
             } else {
                 uint8_t *outputBuffer = AMediaCodec_getOutputBuffer(codec, bufferIndex, nullptr);
@@ -543,6 +858,14 @@ void Player::threadDecode() {
             }
         }
     }
+    if (mSurfaceWindow != nullptr && videoCodec != nullptr) {
+        // a window takes frames from one producer at a time, the codec of the next video connects to it again
+        if (pendingVideoBuffer >= 0) {
+            AMediaCodec_releaseOutputBuffer(videoCodec, pendingVideoBuffer, false);
+        }
+        AMediaCodec_stop(videoCodec);
+        AMediaCodec_delete(videoCodec);
+    }
     infof("threadDecode---");
 }
 
@@ -626,8 +949,14 @@ bool Player::releaseVideoFrame(std::shared_ptr<MediaFrame> &frame) {
         return false;
     }
     auto &it = mDecodedVideoFrameList.front();
+    if (frame->fenceFd >= 0) {
+        close(frame->fenceFd);
+        frame->fenceFd = -1;
+    }
     if (frame->image) {
-        AImage_delete((AImage*)frame->image);
+        // the eyes of the previous frame sampled the image, the reader may hand it to the decoder again once the
+        // GPU is done with those draws; deleteAsync owns the fence
+        AImage_deleteAsync((AImage*)frame->image, createReleaseFence());
     }
     mDecodedVideoFrameList.pop_front();
     //infof("pop mDecodedVideoFrameList size:%d", mDecodedVideoFrameList.size());
@@ -4,10 +4,20 @@
 #include <list>
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <unordered_map>
+#ifdef XR_USE_PLATFORM_ANDROID
 #include <media/NdkImage.h>
 #include <media/NdkImageReader.h>
 #include <media/NdkMediaExtractor.h>
+#include <jni.h>
+#endif
 #include "shader.h"
+#include "renderQueue.h"
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
+
+#define PLAYER_MAX_LAYERS 2   // one per eye for stereo video
 
 typedef struct {
     float x;
@@ -47,7 +57,7 @@ typedef enum {
 }PlayModel;
 
 typedef struct MediaFrame_tag {
-    MediaFrame_tag() : type(mediaTypeVideo), pts(0), data(nullptr), size(0) {};
+    MediaFrame_tag() : type(mediaTypeVideo), pts(0), data(nullptr), size(0), fenceFd(-1) {};
     mediaType type;
     uint64_t pts;
     int32_t width;
@@ -56,8 +66,11 @@ typedef struct MediaFrame_tag {
     uint32_t size;
     ssize_t bufferIndex;
     void* image;
+    int32_t fenceFd;   // signaled when the decoder finished writing image, -1: ready
 }MediaFrame;
 
+// Video player of the demos. player.cpp decodes with AMediaCodec on Android, player_linux.cpp is the headless host
+// build, which has no decoder: start() fails and nothing is drawn.
 class Player {
 
 public:
@@ -67,14 +80,30 @@ public:
     bool initialize(EGLDisplay display);
     bool start(const std::string& file);
     bool stop();
+    // Once per frame before the views: picks the decoded frame every eye of this frame shows.
+    void update();
     void setModel(const glm::mat4& m);
-    bool render(const glm::mat4& p, const glm::mat4& v, int32_t eye);
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, int32_t eye);
+    bool render(int32_t eye);
+    bool render(const glm::mat4& m, int32_t eye);
+    void submit(RenderQueue& queue, int32_t eye);
     void setPlayStyle(const PlayModel model);
     PlayModel getPlayStyle() const;
+#ifdef XR_USE_PLATFORM_ANDROID
+    // Decode into a surface swapchain the runtime samples instead of drawing the frames, from the next start().
+    // Needs XR_KHR_android_surface_swapchain and XR_KHR_composition_layer_equirect2.
+    void setSurfaceSwapchain(XrSession session, PFN_xrCreateSwapchainAndroidSurfaceKHR createSurfaceSwapchain);
+#endif
+    // Composition layers presenting the video this frame: a quad for flat modes, an equirect for 180 and 360
+    // modes, one per eye for stereo modes. Returns their count, 0 while the video is drawn by submit().
+    uint32_t layers(XrSpace space, XrCompositionLayerBaseHeader** layers);
 
 private:
+    PlayModel        mPlayModel;
+    glm::mat4        mModel;
+
+#ifdef XR_USE_PLATFORM_ANDROID
     bool initShader();
+    static void drawPacket(const RenderQueue& queue, const DrawPacket& packet);
     void InitializePfn();
     void threadDecode();
     void threadPlayAudio();
@@ -85,11 +114,18 @@ private:
     bool releaseAudioFrame(std::shared_ptr<MediaFrame> &frame);
 
     void createVertexAndIndiceData(const PlayModel model);
+    bool createSurfaceSwapchain();
+    GLuint importBuffer(AHardwareBuffer* buffer);
+    void releaseImportedBuffers(bool all);
+    void waitFence(int32_t fenceFd);
+    int32_t createReleaseFence();
 
 private:
     friend void AImageReaderImageCallback(void* context, AImageReader* reader);
+    friend void AImageReaderBufferRemovedCallback(void* context, AImageReader* reader, AHardwareBuffer* buffer);
 
     static Shader mShader;
+    static UniformHandle mModelUniform;
     GLuint mVAO;
     GLuint mVBO;
     GLuint mEBO;
@@ -99,6 +135,22 @@ private:
     PFNEGLCREATEIMAGEKHRPROC m_eglCreateImageKHR = nullptr;
     PFNEGLDESTROYIMAGEKHRPROC m_eglDestroyImageKHR = nullptr;
     PFNGLEGLIMAGETARGETTEXTURE2DOESPROC m_glEGLImageTargetTexture2DOES = nullptr;
+    PFNEGLCREATESYNCKHRPROC m_eglCreateSyncKHR = nullptr;
+    PFNEGLWAITSYNCKHRPROC m_eglWaitSyncKHR = nullptr;
+    PFNEGLDESTROYSYNCKHRPROC m_eglDestroySyncKHR = nullptr;
+    PFNEGLDUPNATIVEFENCEFDANDROIDPROC m_eglDupNativeFenceFDANDROID = nullptr;
+
+    // Every buffer of the AImageReader pool is imported once and reused whenever the reader hands it out again,
+    // until the reader removes it from the pool.
+    typedef struct {
+        EGLImageKHR image;
+        GLuint texture;   // GL_TEXTURE_EXTERNAL_OES
+    }ImportedBuffer;
+    std::unordered_map<AHardwareBuffer*, ImportedBuffer> mImportedBuffers;   // render thread, holds a reference to each key
+    std::vector<AHardwareBuffer*> mRemovedBuffers;   // reported by the reader, released by the next update()
+    std::mutex mRemovedBuffersMutex;
+    std::shared_ptr<MediaFrame> mCurrentFrame;       // shown by the eyes of this frame
+    GLuint mFrameTexture;
 
     std::string      mFileName;
     AMediaExtractor* mExtractor;
@@ -106,7 +158,6 @@ private:
     int32_t          mFd;
     bool             mStarted;
 
-    PlayModel        mPlayModel;
     uint64_t         mVideoPtsOffset;
     int64_t          mVideoDurationMs;
 
@@ -127,9 +178,18 @@ private:
     std::mutex       mDecodedVideoFrameListMutex;
     std::mutex       mDecodedAudioFrameListMutex;
 
-    glm::mat4 mModel;
-
     std::vector<SampleVertex2D> mVertexCoordinates2D;
     std::vector<SampleVertex3D> mVertexCoordinates3D;
     std::vector<GLuint>         mIndices;
+
+    // XR_KHR_android_surface_swapchain, frames go from the decoder to the compositor without our GL pipeline
+    XrSession        mSession;
+    PFN_xrCreateSwapchainAndroidSurfaceKHR mCreateSurfaceSwapchain;
+    XrSwapchain      mSurfaceSwapchain;   // destroyed with the session
+    ANativeWindow*   mSurfaceWindow;      // nullptr: decoding into the AImageReader
+    int32_t          mSurfaceWidth;
+    int32_t          mSurfaceHeight;
+    XrCompositionLayerQuad         mQuadLayers[PLAYER_MAX_LAYERS];
+    XrCompositionLayerEquirect2KHR mEquirectLayers[PLAYER_MAX_LAYERS];
+#endif
 };
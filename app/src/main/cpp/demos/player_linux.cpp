@@ -0,0 +1,58 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved.
+//
+// Player of the headless host build. There is no media decoder on the host, so no video is ever started and the
+// player draws nothing; the dashboard still lists and selects play modes.
+#include "player.h"
+#include "utils.h"
+
+#ifndef XR_USE_PLATFORM_ANDROID
+
+Player::Player() : mPlayModel(playModel_None), mModel(1.0f) {
+}
+
+Player::~Player() {
+}
+
+bool Player::initialize(EGLDisplay /*display*/) {
+    return true;
+}
+
+bool Player::start(const std::string& file) {
+    warnf("no video decoder on this platform, %s is not played", file.c_str());
+    return false;
+}
+
+bool Player::stop() {
+    return true;
+}
+
+void Player::update() {
+}
+
+void Player::setModel(const glm::mat4& m) {
+    mModel = m;
+}
+
+bool Player::render(int32_t /*eye*/) {
+    return false;
+}
+
+bool Player::render(const glm::mat4& /*m*/, int32_t /*eye*/) {
+    return false;
+}
+
+void Player::submit(RenderQueue& /*queue*/, int32_t /*eye*/) {
+}
+
+void Player::setPlayStyle(const PlayModel model) {
+    mPlayModel = model;
+}
+
+PlayModel Player::getPlayStyle() const {
+    return mPlayModel;
+}
+
+uint32_t Player::layers(XrSpace /*space*/, XrCompositionLayerBaseHeader** /*layers*/) {
+    return 0;
+}
+#endif
@@ -0,0 +1,222 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <stdio.h>
+#include <algorithm>
+#include <unistd.h>
+#include "profiler.h"
+#include "utils.h"
+
+static const char* sMarkerNames[profileMarker_Count] = {
+    "xrWaitFrame",
+    "xrBeginFrame",
+    "PollActions",
+    "RenderView",
+    "xrEndFrame",
+    "player",
+    "gui",
+    "gui offscreen",
+    "text",
+    "eye tracking",
+    "controller",
+    "hand",
+};
+
+static const char* sGpuMarkerNames[gpuMarker_Count] = {
+    "view",
+    "model",
+    "player",
+    "gui offscreen",
+    "gui composite",
+    "text",
+    "cube",
+    "ray",
+};
+
+void ProfileRing::push(const ProfileSample& sample) {
+    uint64_t index = mWriteIndex.load(std::memory_order_relaxed);
+    mSamples[index & (PROFILE_RING_SIZE - 1)] = sample;
+    mWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::now() {
+    return GetTimeNanoseconds();
+}
+
+const char* Profiler::markerName(uint32_t marker) {
+    return marker < profileMarker_Count ? sMarkerNames[marker] : "unknown";
+}
+
+Profiler::RingOwner::~RingOwner() {
+    if (ring == nullptr) {
+        return;
+    }
+    Profiler& profiler = Profiler::instance();
+    {
+        std::lock_guard<std::mutex> lock(profiler.mRingsLock);
+        profiler.mRings.erase(std::find(profiler.mRings.begin(), profiler.mRings.end(), ring));
+    }
+    delete ring;
+}
+
+ProfileRing* Profiler::threadRing() {
+    static thread_local RingOwner owner;
+    if (owner.ring == nullptr) {
+        owner.ring = new ProfileRing();
+        owner.ring->mThreadId = (uint32_t)gettid();
+        std::lock_guard<std::mutex> lock(mRingsLock);
+        mRings.push_back(owner.ring);
+    }
+    return owner.ring;
+}
+
+void Profiler::record(ProfileMarker marker, uint64_t begin, uint64_t end) {
+    ProfileSample sample;
+    sample.begin = begin;
+    sample.end = end;
+    sample.marker = marker;
+    sample.frame = mFrame.load(std::memory_order_relaxed);
+    threadRing()->push(sample);
+}
+
+void Profiler::endFrame(int64_t predictedDisplayTime, int64_t predictedDisplayPeriod) {
+    const uint32_t slot = mFrame.load(std::memory_order_relaxed) % PROFILE_HISTORY_FRAMES;
+    for (uint32_t i = 0; i < profileMarker_Count; i++) {
+        mHistory[i][slot] = 0.0f;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mRingsLock);
+        for (ProfileRing* ring : mRings) {
+            const uint64_t writeIndex = ring->mWriteIndex.load(std::memory_order_acquire);
+            uint64_t readIndex = ring->mReadIndex;
+            if (writeIndex - readIndex > PROFILE_RING_SIZE / 2) {
+                readIndex = writeIndex - PROFILE_RING_SIZE / 2;
+            }
+            for (; readIndex < writeIndex; readIndex++) {
+                const ProfileSample& sample = ring->mSamples[readIndex & (PROFILE_RING_SIZE - 1)];
+                if (sample.marker < profileMarker_Count) {
+                    mHistory[sample.marker][slot] += (sample.end - sample.begin) * 1e-6f;
+                }
+            }
+            ring->mReadIndex = readIndex;
+        }
+    }
+
+    ksNanoseconds gpuTime = 0;
+    for (uint32_t i = 0; i < gpuMarker_Count; i++) {
+        for (uint32_t view = 0; view < PROFILE_GPU_VIEWS; view++) {
+            ksNanoseconds markerTime = 0;
+            for (uint32_t j = 0; j < mGpuTimersUsed[i][view]; j++) {
+                markerTime += ksGpuTimer_GetNanoseconds(mGpuTimers[i][view][j]);
+            }
+            mGpuHistory[i][view][slot] = markerTime * 1e-6f;
+            mGpuTimersUsed[i][view] = 0;
+            if (i == gpuMarker_View) {
+                gpuTime += markerTime;
+            }
+        }
+    }
+    mGpuView = PROFILE_GPU_VIEWS - 1;
+
+    const uint64_t frameEnd = now();
+    const uint64_t frameTime = mLastFrameEnd == 0 ? 0 : frameEnd - mLastFrameEnd;
+    mFrameHistory[slot] = frameTime * 1e-6f;
+    mLastFrameEnd = frameEnd;
+
+    // The runtime skipped at least one display refresh since the previous frame.
+    mDisplayPeriodMs = predictedDisplayPeriod * 1e-6f;
+    if (mLastDisplayTime != 0 && predictedDisplayTime - mLastDisplayTime > predictedDisplayPeriod * 3 / 2) {
+        mMissedFrames++;
+        debugf("missed frame %u: display time advanced %.2f ms, period %.2f ms", mFrame.load(), (predictedDisplayTime - mLastDisplayTime) * 1e-6f, mDisplayPeriodMs);
+    }
+    mLastDisplayTime = predictedDisplayTime;
+
+    ksFrameLog_EndFrame(frameTime, gpuTime, KS_GPU_TIMER_FRAMES_DELAYED);
+    if (!mDumpPath.empty()) {
+        dump();
+        mDumpPath.clear();
+    }
+    mFrame.fetch_add(1, std::memory_order_relaxed);
+    ksFrameLog_BeginFrame();
+}
+
+void Profiler::requestDump(const char* path) {
+    mDumpPath = path;
+}
+
+void Profiler::dump() {
+    FILE* fp = fopen(mDumpPath.c_str(), "wb");
+    if (fp == nullptr) {
+        errorf("could not open %s for the frame timeline", mDumpPath.c_str());
+        return;
+    }
+    fprintf(fp, "thread,frame,marker,begin_ms,duration_ms\n");
+    std::lock_guard<std::mutex> lock(mRingsLock);
+    for (ProfileRing* ring : mRings) {
+        const uint64_t writeIndex = ring->mWriteIndex.load(std::memory_order_acquire);
+        const uint64_t count = std::min<uint64_t>(writeIndex, PROFILE_RING_SIZE / 2);
+        for (uint64_t i = writeIndex - count; i < writeIndex; i++) {
+            const ProfileSample& sample = ring->mSamples[i & (PROFILE_RING_SIZE - 1)];
+            fprintf(fp, "%u,%u,%s,%.3f,%.3f\n", ring->mThreadId, sample.frame, markerName(sample.marker), sample.begin * 1e-6, (sample.end - sample.begin) * 1e-6);
+        }
+    }
+    fclose(fp);
+    infof("frame timeline written to %s", mDumpPath.c_str());
+
+    // per frame CPU times of the following frames
+    std::string frameLogPath = mDumpPath + ".framelog";
+    ksFrameLog_Open(frameLogPath.c_str(), PROFILE_HISTORY_FRAMES);
+}
+
+uint32_t Profiler::frameIndex() const {
+    return mFrame.load(std::memory_order_relaxed);
+}
+
+uint32_t Profiler::historyOffset() const {
+    return mFrame.load(std::memory_order_relaxed) % PROFILE_HISTORY_FRAMES;
+}
+
+const float* Profiler::history(uint32_t marker) const {
+    return mHistory[marker];
+}
+
+const float* Profiler::frameHistory() const {
+    return mFrameHistory;
+}
+
+uint32_t Profiler::missedFrames() const {
+    return mMissedFrames;
+}
+
+float Profiler::displayPeriodMs() const {
+    return mDisplayPeriodMs;
+}
+
+const char* Profiler::gpuMarkerName(uint32_t marker) {
+    return marker < gpuMarker_Count ? sGpuMarkerNames[marker] : "unknown";
+}
+
+void Profiler::setGpuView(int32_t view) {
+    mGpuView = (view >= 0 && view < PROFILE_GPU_VIEWS) ? view : PROFILE_GPU_VIEWS - 1;
+}
+
+ksGpuTimer* Profiler::beginGpu(GpuMarker marker) {
+    std::vector<ksGpuTimer*>& timers = mGpuTimers[marker][mGpuView];
+    uint32_t& used = mGpuTimersUsed[marker][mGpuView];
+    if (used == timers.size()) {
+        ksGpuTimer* timer = new ksGpuTimer();
+        ksGpuTimer_Create(nullptr, timer);
+        timers.push_back(timer);
+    }
+    ksGpuTimer* timer = timers[used++];
+    ksGpuTimer_Begin(timer);
+    return timer;
+}
+
+const float* Profiler::gpuHistory(uint32_t marker, int32_t view) const {
+    return mGpuHistory[marker][view];
+}
@@ -0,0 +1,143 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/gfxwrapper_opengl.h"
+
+typedef enum {
+    profileMarker_WaitFrame = 0,
+    profileMarker_BeginFrame,
+    profileMarker_PollActions,
+    profileMarker_RenderView,
+    profileMarker_EndFrame,
+    profileMarker_Player,
+    profileMarker_Gui,
+    profileMarker_GuiOffscreen,
+    profileMarker_Text,
+    profileMarker_EyeTracking,
+    profileMarker_Controller,
+    profileMarker_Hand,
+    profileMarker_Count
+}ProfileMarker;
+
+typedef enum {
+    gpuMarker_View = 0,        // everything drawn into a view
+    gpuMarker_Model,
+    gpuMarker_Player,
+    gpuMarker_GuiOffscreen,    // ImGui into the panel texture
+    gpuMarker_GuiComposite,    // panel texture into the view
+    gpuMarker_Text,
+    gpuMarker_Cube,
+    gpuMarker_Ray,
+    gpuMarker_Count
+}GpuMarker;
+
+#define PROFILE_RING_SIZE 4096       // samples per thread, power of two
+#define PROFILE_HISTORY_FRAMES 128   // frames shown by the dashboard
+#define PROFILE_GPU_VIEWS 3          // left eye, right eye, both eyes at once or outside of a view
+
+typedef struct {
+    uint64_t begin;  // nanoseconds, GetTimeNanoseconds
+    uint64_t end;
+    uint32_t marker;
+    uint32_t frame;
+}ProfileSample;
+
+// Samples of one thread. Only the owning thread writes, the render thread reads behind the write index
+// and never blocks the writer; a sample may be overwritten while it is read once the ring has wrapped,
+// which the reader avoids by staying PROFILE_RING_SIZE / 2 behind.
+class ProfileRing {
+public:
+    void push(const ProfileSample& sample);
+    ProfileSample mSamples[PROFILE_RING_SIZE];
+    std::atomic<uint64_t> mWriteIndex{0};
+    uint64_t mReadIndex = 0;   // render thread only
+    uint32_t mThreadId = 0;
+};
+
+// CPU frame timeline. ProfileScope records a marker into the calling thread's ring, endFrame collects the
+// samples of all threads once per frame on the render thread, keeps the last PROFILE_HISTORY_FRAMES per
+// marker for the dashboard and flags frames whose display time advanced by more than one display period.
+class Profiler {
+public:
+    static Profiler& instance();
+    static uint64_t now();
+    static const char* markerName(uint32_t marker);
+
+    void record(ProfileMarker marker, uint64_t begin, uint64_t end);
+    // render thread, after xrEndFrame of the frame
+    void endFrame(int64_t predictedDisplayTime, int64_t predictedDisplayPeriod);
+    // writes every sample still held by the rings to a file and opens a ksFrameLog for the next frames
+    void requestDump(const char* path);
+
+    uint32_t frameIndex() const;
+    // Milliseconds per frame spent in the marker and between two endFrame calls, PROFILE_HISTORY_FRAMES values
+    // each. Both are rings, historyOffset() is the index of the oldest frame.
+    const float* history(uint32_t marker) const;
+    const float* frameHistory() const;
+    uint32_t historyOffset() const;
+    uint32_t missedFrames() const;
+    float displayPeriodMs() const;
+
+    // GPU timers, render thread only. Draws are attributed to the view set by setGpuView, EYE_LEFT or
+    // EYE_RIGHT while one eye is rendered and EYE_COUNT for multiview passes and work outside of a view;
+    // endFrame resets it to EYE_COUNT. A marker may be timed any number of times per view and frame.
+    void setGpuView(int32_t view);
+    ksGpuTimer* beginGpu(GpuMarker marker);
+    static const char* gpuMarkerName(uint32_t marker);
+    // Milliseconds per frame on the GPU, reported KS_GPU_TIMER_FRAMES_DELAYED frames late.
+    const float* gpuHistory(uint32_t marker, int32_t view) const;
+
+private:
+    // frees the ring of a thread when the thread exits, its samples not read yet are dropped
+    struct RingOwner {
+        ~RingOwner();
+        ProfileRing* ring = nullptr;
+    };
+
+    Profiler() = default;
+    ProfileRing* threadRing();
+    void dump();
+
+    std::mutex mRingsLock;   // taken when a thread records its first sample or exits, by endFrame() and dump()
+    std::vector<ProfileRing*> mRings;
+    std::atomic<uint32_t> mFrame{0};
+    float mHistory[profileMarker_Count][PROFILE_HISTORY_FRAMES] = {};
+    float mFrameHistory[PROFILE_HISTORY_FRAMES] = {};
+    float mDisplayPeriodMs = 0.0f;
+    uint32_t mMissedFrames = 0;
+    int64_t mLastDisplayTime = 0;
+    uint64_t mLastFrameEnd = 0;
+    std::string mDumpPath;
+
+    // one timer per use within a frame, so that each timer is begun once per frame
+    std::vector<ksGpuTimer*> mGpuTimers[gpuMarker_Count][PROFILE_GPU_VIEWS];
+    uint32_t mGpuTimersUsed[gpuMarker_Count][PROFILE_GPU_VIEWS] = {};
+    float mGpuHistory[gpuMarker_Count][PROFILE_GPU_VIEWS][PROFILE_HISTORY_FRAMES] = {};
+    int32_t mGpuView = PROFILE_GPU_VIEWS - 1;
+};
+
+class ProfileScope {
+public:
+    ProfileScope(ProfileMarker marker) : mMarker(marker), mBegin(Profiler::now()) {}
+    ~ProfileScope() { Profiler::instance().record(mMarker, mBegin, Profiler::now()); }
+private:
+    ProfileMarker mMarker;
+    uint64_t mBegin;
+};
+
+class GpuProfileScope {
+public:
+    GpuProfileScope(GpuMarker marker) : mTimer(Profiler::instance().beginGpu(marker)) {}
+    ~GpuProfileScope() { ksGpuTimer_End(mTimer); }
+private:
+    ksGpuTimer* mTimer;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(marker) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(marker)
+#define GPU_PROFILE_SCOPE(marker) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(marker)
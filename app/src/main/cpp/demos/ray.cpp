@@ -1,8 +1,18 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
+#include <algorithm>
 #include "ray.h"
 #include "utils.h"
+#include "profiler.h"
+#include "glState.h"
+#include "glm/gtc/quaternion.hpp"
+
+#define RAY_INSTANCE_LOCATION 1
+static_assert(RAY_MAX_INSTANCES == 4, "MAX_INSTANCES of the vertex shader");
 
 Shader Ray::mShader;
+UniformHandle Ray::mColorUniform;
+UniformHandle Ray::mMaxZUniform;
 Ray::Ray() {
     mColor = {1.0f, 1.0f, 1.0f};
 }
@@ -20,14 +30,28 @@ bool Ray::initShader() {
             #version 320 es
             precision highp float;
             layout (location = 0) in vec3 position;
-            uniform mat4 projection;
-            uniform mat4 view;
-            uniform mat4 model;
+            // PoseInstance, see instanceBuffer.h
+            layout (location = 1) in vec4 instanceOrientation;
+            layout (location = 2) in vec4 instancePositionScale;
+            layout (location = 3) in int instanceLatchIndex;
+            const int MAX_INSTANCES = 4;  // RAY_MAX_INSTANCES
+            uniform vec3 color[MAX_INSTANCES];
+            layout(std140, binding = LATE_LATCH_BINDING) uniform LateLatch {
+                mat4 latchedPose[LATE_LATCH_POSE_COUNT];
+            };
             out vec3 outPosition;
+            flat out vec3 outColor;
+            vec3 rotate(vec4 q, vec3 v)
+            {
+                return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+            }
             void main()
             {
                 outPosition = position;
-                gl_Position = projection * view * model * vec4(position, 1.0);
+                outColor = color[gl_InstanceID];
+                vec4 local = vec4(rotate(instanceOrientation, position * instancePositionScale.w) + instancePositionScale.xyz, 1.0);
+                vec4 world = instanceLatchIndex >= 0 ? latchedPose[instanceLatchIndex] * local : local;
+                gl_Position = cameraViewProjection[VIEW_ID] * world;
             }
         )_";
 
@@ -35,8 +59,8 @@ bool Ray::initShader() {
             #version 320 es
             precision mediump float;
             uniform float inmaxz;
-            uniform vec3 color;
             in vec3 outPosition;
+            flat in vec3 outColor;
             out vec4 FragColor;
             void main()
             {
@@ -44,13 +68,15 @@ bool Ray::initShader() {
                 if (outPosition.z < inmaxz * 0.5f) {
                    t = 1.0f + (inmaxz * 0.5f - outPosition.z) / (inmaxz * 0.5f);
                 }
-                FragColor = vec4(color, t);
+                FragColor = vec4(outColor, t);
             }
         )_";
 
-        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl) == false) {
+        if (mShader.loadShader(vertex_shader_glsl, fragment_shader_glsl, Shader::eyeViewCount()) == false) {
             return false;
         }
+        mColorUniform = mShader.uniform("color");
+        mMaxZUniform = mShader.uniform("inmaxz");
         init = true;
     }
     return true;
@@ -92,13 +118,14 @@ void Ray::initialize() {
 	GL_CALL(glGenVertexArrays(1, &mVAO));
 	GL_CALL(glGenBuffers(1, &VBO));
     GL_CALL(glGenBuffers(1, &EBO));
-	GL_CALL(glBindVertexArray(mVAO));
-	GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, VBO));
-    GL_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
+	GLState::instance().bindVertexArray(mVAO);
+	GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(float), mVertices.data(), GL_STATIC_DRAW));
     GL_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(GLuint), mIndices.data(), GL_STATIC_DRAW));
 	GL_CALL(glEnableVertexAttribArray(0));
 	GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0));
+    mInstances.initialize(RAY_INSTANCE_LOCATION, RAY_MAX_INSTANCES);
 }
 
 glm::vec3 Ray::getForwardVector() {
@@ -119,21 +146,72 @@ void Ray::setColor(float x, float y, float z) {
     mColor = {x, y, z};
 }
 
-bool Ray::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m) {
+PoseInstance Ray::pose(const glm::mat4& m, int32_t latchIndex) {
+    PoseInstance pose;
+    const float scale = glm::length(glm::vec3(m[0]));
+    const glm::quat orientation = glm::quat_cast(glm::mat3(m) / scale);
+    pose.orientation = glm::vec4(orientation.x, orientation.y, orientation.z, orientation.w);
+    pose.position = glm::vec3(m[3]);
+    pose.scale = scale;
+    pose.latchIndex = latchIndex;
+    return pose;
+}
+
+bool Ray::render(const glm::mat4& m, int32_t latchIndex) {
+    const PoseInstance ray = pose(m, latchIndex);
+    return render(&ray, &mColor, 1);
+}
+
+bool Ray::render(const PoseInstance* rays, const glm::vec3* colors, size_t count) {
+    GPU_PROFILE_SCOPE(gpuMarker_Ray);
     //GL_CALL(glDisable(GL_CULL_FACE));
     mShader.use();
-    mShader.setUniformVec3("color", mColor);
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
     float maxz = mVertices[mVertices.size() - 1];
-    mShader.setUniformFloat("inmaxz", maxz);
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0));
-    GL_CALL(glBindVertexArray(0));
+    mShader.setUniformFloat(mMaxZUniform, maxz);
+    GLState::instance().enable(GL_BLEND);
+    GLState::instance().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::instance().bindVertexArray(mVAO);
+    for (size_t first = 0; first < count;) {
+        const uint32_t instanceCount = mInstances.upload(rays + first, (uint32_t)(count - first));
+        mShader.setUniformVec3(mColorUniform, colors + first, instanceCount);
+        GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0, instanceCount));
+        first += instanceCount;
+    }
     return true;
 }
 
+typedef struct {
+    uint32_t count;
+    PoseInstance rays[RAY_MAX_INSTANCES];
+    glm::vec3 colors[RAY_MAX_INSTANCES];
+}RayParams;
+
+void Ray::submit(RenderQueue& queue, const glm::mat4& m, int32_t latchIndex, const glm::vec3& position) {
+    const PoseInstance ray = pose(m, latchIndex);
+    submit(queue, &ray, &mColor, 1, position);
+}
+
+void Ray::submit(RenderQueue& queue, const PoseInstance* rays, const glm::vec3* colors, size_t count, const glm::vec3& position) {
+    if (count == 0) {
+        return;
+    }
+    DrawPacket packet = {};
+    packet.pass = renderPass_Transparent;
+    packet.program = mShader.id();
+    packet.vertexArray = mVAO;
+    packet.draw = drawPacket;
+    packet.object = this;
+    RayParams* params = (RayParams*)queue.submit(packet, position, sizeof(RayParams));
+    params->count = (uint32_t)std::min(count, (size_t)RAY_MAX_INSTANCES);
+    memcpy(params->rays, rays, params->count * sizeof(PoseInstance));
+    memcpy(params->colors, colors, params->count * sizeof(glm::vec3));
+}
+
+void Ray::drawPacket(const RenderQueue& queue, const DrawPacket& packet) {
+    const RayParams* params = (const RayParams*)packet.params;
+    ((Ray*)packet.object)->render(params->rays, params->colors, params->count);
+}
+
 std::vector<glm::vec3> Ray::getPoints() {
     std::vector<glm::vec3> points;
     points.push_back(mPoint1);
@@ -4,16 +4,28 @@
 #include "shader.h"
 #include "glm/glm.hpp"
 #include "common/gfxwrapper_opengl.h"
+#include "renderQueue.h"
+#include "instanceBuffer.h"
 
 #define PI 3.1415926535
 #define RADIAN(x) ((x) * PI / 180)
+#define RAY_MAX_INSTANCES 4   // rays per instanced draw, the colors are a uniform array of this size
 
 class Ray {
 public:
     Ray();
     ~Ray();
     void initialize();
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m);
+    // latchIndex >= 0: m is relative to that pose of the LateLatch block. m is rotation, translation and a
+    // uniform scale.
+    bool render(const glm::mat4& m, int32_t latchIndex = -1);
+    // all rays of a call as instances, colors[i] is the color of rays[i]
+    bool render(const PoseInstance* rays, const glm::vec3* colors, size_t count);
+    // queued render with the current color, position (world space) orders the ray among the transparent draws
+    void submit(RenderQueue& queue, const glm::mat4& m, int32_t latchIndex, const glm::vec3& position);
+    // queued render of up to RAY_MAX_INSTANCES rays in one packet, the rays and colors are copied
+    void submit(RenderQueue& queue, const PoseInstance* rays, const glm::vec3* colors, size_t count, const glm::vec3& position);
+    static PoseInstance pose(const glm::mat4& m, int32_t latchIndex);
     std::vector<glm::vec3> getPoints();
     glm::vec3 getForwardVector();
     glm::vec3 getDirectionVector(const glm::mat4& m);
@@ -21,8 +33,11 @@ public:
     void setColor(float x, float y, float z);
 private:
     bool initShader();
+    static void drawPacket(const RenderQueue& queue, const DrawPacket& packet);
 private:
     static Shader mShader;
+    static UniformHandle mColorUniform;
+    static UniformHandle mMaxZUniform;
     float mRadius = 0.0015f;
     float mLength = 2.0f;
     uint32_t mVertexCount;
@@ -32,4 +47,5 @@ private:
     std::vector<GLuint> mIndices;
     GLuint mVAO;
     glm::vec3 mColor;
+    InstanceBuffer mInstances;
 };
\ No newline at end of file
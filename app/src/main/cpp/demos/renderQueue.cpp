@@ -0,0 +1,117 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
+#include <algorithm>
+#include <openxr/openxr.h>
+#include <common/xr_linear.h>
+#include "renderQueue.h"
+#include "frameArena.h"
+#include "glState.h"
+
+#define RENDER_QUEUE_FAR 100.0f   // far plane of the projections, meters
+
+// opaque:      pass(1) program(15) vertex array(16) texture(16) distance(16), front to back
+// transparent: pass(1) reversed distance(32) program(15) texture(16), back to front
+static uint64_t sortKey(const DrawPacket& packet, float distance) {
+    const uint64_t program = packet.program & 0x7fff;
+    const uint64_t vertexArray = packet.vertexArray & 0xffff;
+    const uint64_t texture = packet.texture & 0xffff;
+    distance = std::max(distance, 0.0f);
+    if (packet.pass == renderPass_Opaque) {
+        const uint64_t depth = (uint64_t)(std::min(distance / RENDER_QUEUE_FAR, 1.0f) * 0xffff);
+        return (program << 48) | (vertexArray << 32) | (texture << 16) | depth;
+    }
+    // a positive float orders like its bits
+    uint32_t depth = 0;
+    memcpy(&depth, &distance, sizeof(depth));
+    return (1ull << 63) | ((uint64_t)(~depth) << 31) | (program << 16) | texture;
+}
+
+void RenderQueue::begin(const glm::mat4* p, const glm::mat4* v, uint32_t viewCount) {
+    mView = v[0];
+    mViewCount = std::min(viewCount, (uint32_t)RENDER_QUEUE_MAX_VIEWS);
+    for (uint32_t i = 0; i < mViewCount; i++) {
+        mViewProjection[i] = p[i] * v[i];
+    }
+    mPackets.clear();
+}
+
+void RenderQueue::setMarker(ProfileMarker marker) {
+    mMarker = marker;
+}
+
+bool RenderQueue::isVisible(const glm::mat4& m, const glm::vec3& mins, const glm::vec3& maxs) {
+    mTested++;
+    for (uint32_t i = 0; i < mViewCount; i++) {
+        // glm and XrMatrix4x4f are both column-major
+        const glm::mat4 mvp = mViewProjection[i] * m;
+        if (!XrMatrix4x4f_CullBounds((const XrMatrix4x4f*)&mvp, (const XrVector3f*)&mins, (const XrVector3f*)&maxs)) {
+            return true;
+        }
+    }
+    mCulled++;
+    return false;
+}
+
+void* RenderQueue::submit(DrawPacket packet, const glm::vec3& position, size_t paramsSize) {
+    const glm::vec3 viewPosition = glm::vec3(mView * glm::vec4(position, 1.0f));
+    packet.key = sortKey(packet, glm::length(viewPosition));
+    packet.sequence = (uint32_t)mPackets.size();
+    void* params = paramsSize > 0 ? FrameArena::instance().allocate(paramsSize) : nullptr;
+    packet.params = params;
+    packet.marker = mMarker;
+    mPackets.push_back(packet);
+    return params;
+}
+
+void RenderQueue::execute() {
+    std::sort(mPackets.begin(), mPackets.end(), [](const DrawPacket& a, const DrawPacket& b) {
+        return a.key != b.key ? a.key < b.key : a.sequence < b.sequence;
+    });
+
+    GLState& glState = GLState::instance();
+    Profiler& profiler = Profiler::instance();
+    ProfileMarker marker = profileMarker_Count;
+    uint64_t begin = 0;
+    for (const DrawPacket& packet : mPackets) {
+        if (packet.marker != marker) {
+            const uint64_t now = Profiler::now();
+            if (marker != profileMarker_Count) {
+                profiler.record(marker, begin, now);
+            }
+            marker = packet.marker;
+            begin = now;
+        }
+        glState.useProgram(packet.program);
+        if (packet.vertexArray != 0) {
+            glState.bindVertexArray(packet.vertexArray);
+        }
+        if (packet.texture != 0) {
+            glState.activeTexture(GL_TEXTURE0);
+            glState.bindTexture(GL_TEXTURE_2D, packet.texture);
+        }
+        packet.draw(*this, packet);
+    }
+    if (marker != profileMarker_Count) {
+        profiler.record(marker, begin, Profiler::now());
+    }
+    mPackets.clear();
+}
+
+uint32_t RenderQueue::size() const {
+    return (uint32_t)mPackets.size();
+}
+
+void RenderQueue::endFrame() {
+    mLastTested = mTested;
+    mLastCulled = mCulled;
+    mTested = 0;
+    mCulled = 0;
+}
+
+uint32_t RenderQueue::testedBounds() const {
+    return mLastTested;
+}
+
+uint32_t RenderQueue::culledBounds() const {
+    return mLastCulled;
+}
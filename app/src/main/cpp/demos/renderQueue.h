@@ -0,0 +1,71 @@
+/* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "glm/glm.hpp"
+#include "common/gfxwrapper_opengl.h"
+#include "profiler.h"
+
+#define RENDER_QUEUE_MAX_VIEWS 2
+
+typedef enum {
+    renderPass_Opaque = 0,
+    renderPass_Transparent,
+}RenderPass;
+
+class RenderQueue;
+struct DrawPacket;
+// Sets the uniforms of the draw and issues it; program, vertex array and texture of the packet are already bound.
+typedef void (*DrawFunction)(const RenderQueue& queue, const DrawPacket& packet);
+
+struct DrawPacket {
+    RenderPass pass;
+    GLuint program;
+    GLuint vertexArray;   // 0: the draw function binds its own
+    GLuint texture;       // GL_TEXTURE_2D on unit 0, 0: none
+    DrawFunction draw;
+    void* object;         // the renderer
+    const void* params;   // frame memory returned by RenderQueue::submit
+    ProfileMarker marker; // set by RenderQueue::submit, times the draw in execute
+    uint64_t key;
+    uint32_t sequence;
+};
+
+// Draws of one view, collected from all renderers and executed in one pass. Opaque packets are grouped by
+// program, vertex array and texture and drawn front to back within a group, transparent packets are drawn
+// back to front after them. Packets with equal keys keep their submission order. Render thread only.
+class RenderQueue {
+public:
+    // Starts a view drawn to viewCount eyes at once (2 in a multiview pass). The first eye orders the packets.
+    void begin(const glm::mat4* p, const glm::mat4* v, uint32_t viewCount);
+    // CPU marker of the packets submitted from now on; execute records the time spent drawing them under it
+    void setMarker(ProfileMarker marker);
+    // false when the box mins..maxs (model space, transformed by m) lies outside the frustum of every eye
+    bool isVisible(const glm::mat4& m, const glm::vec3& mins, const glm::vec3& maxs);
+    // Queues the packet, ordered by the distance of position (world space) to the eye. Returns paramsSize bytes
+    // of frame memory for the packet's draw function, or nullptr for paramsSize 0.
+    void* submit(DrawPacket packet, const glm::vec3& position, size_t paramsSize);
+    // Sorts and draws the packets of the view, then empties the queue. Consecutive packets of one marker are
+    // recorded as one profiler sample.
+    void execute();
+
+    uint32_t size() const;
+
+    // once per frame, before the first view
+    void endFrame();
+    // bounds tested and bounds culled by isVisible during the previous frame, all views
+    uint32_t testedBounds() const;
+    uint32_t culledBounds() const;
+
+private:
+    glm::mat4 mView{1.0f};
+    glm::mat4 mViewProjection[RENDER_QUEUE_MAX_VIEWS];
+    uint32_t mViewCount = 0;
+    ProfileMarker mMarker = profileMarker_RenderView;
+    std::vector<DrawPacket> mPackets;
+    uint32_t mTested = 0;
+    uint32_t mCulled = 0;
+    uint32_t mLastTested = 0;
+    uint32_t mLastCulled = 0;
+};
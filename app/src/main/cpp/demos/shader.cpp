@@ -2,13 +2,18 @@
 #include <iostream>
 #include "shader.h"
 #include "utils.h"
+#include "lateLatch.h"
+#include "cameraBuffer.h"
+#include "glState.h"
+
+uint32_t Shader::sEyeViewCount = 1;
 
 Shader::Shader() : mProgram(0) {
 }
 
 Shader::~Shader() {
     if (mProgram) {
-        glDeleteProgram(mProgram);
+        GLState::instance().deleteProgram(mProgram);
     }
 }
 
@@ -33,14 +38,55 @@ bool Shader::checkCompileErrors(GLuint shader, std::string type) {
     return true;
 }
 
-bool Shader::loadShader(const char* vertexShaderCode, const char* fragmentShaderCode) {
+void Shader::setEyeViewCount(uint32_t count) {
+    sEyeViewCount = count;
+}
+
+uint32_t Shader::eyeViewCount() {
+    return sEyeViewCount;
+}
+
+static std::string addShaderDefines(const char* code, uint32_t viewCount) {
+    std::string defines;
+    if (viewCount > 1) {
+        defines = "#extension GL_OVR_multiview2 : require\n"
+                  "layout(num_views = " + std::to_string(viewCount) + ") in;\n"
+                  "#define VIEW_COUNT " + std::to_string(viewCount) + "\n"
+                  "#define VIEW_ID int(gl_ViewID_OVR)\n";
+    } else {
+        defines = "#define VIEW_COUNT 1\n"
+                  "#define VIEW_ID 0\n";
+    }
+    defines += "#define LATE_LATCH_BINDING " + std::to_string(LATE_LATCH_BINDING) + "\n"
+               "#define LATE_LATCH_POSE_COUNT " + std::to_string(LATE_LATCH_POSE_COUNT) + "\n";
+    // the cameras of the view, see cameraBuffer.h
+    const std::string eyeCount = std::to_string(EYE_COUNT);
+    defines += "layout(std140, binding = " + std::to_string(CAMERA_BINDING) + ") uniform Camera {\n"
+               "    highp mat4 cameraView[" + eyeCount + "];\n"
+               "    highp mat4 cameraProjection[" + eyeCount + "];\n"
+               "    highp mat4 cameraViewProjection[" + eyeCount + "];\n"
+               "    highp vec4 cameraPosition[" + eyeCount + "];\n"
+               "    highp ivec4 cameraEye[" + eyeCount + "];\n"
+               "};\n";
+    // the defines must follow the #version line
+    std::string source(code);
+    size_t version = source.find("#version");
+    size_t pos = (version == std::string::npos) ? 0 : source.find('\n', version);
+    pos = (pos == std::string::npos) ? source.size() : pos + 1;
+    source.insert(pos, defines);
+    return source;
+}
+
+bool Shader::loadShader(const char* vertexShaderCode, const char* fragmentShaderCode, uint32_t viewCount) {
     int maxVertexUniform, maxFragmentUniform;
     GL_CALL(glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &maxVertexUniform));
     GL_CALL(glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS, &maxFragmentUniform));
     //infof("maxVertexUniform:%d, maxFragmentUniform:%d", maxVertexUniform, maxFragmentUniform);
 
+    std::string vertexSource = addShaderDefines(vertexShaderCode, viewCount);
+    const char* vertexSourceCode = vertexSource.c_str();
     GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-    GL_CALL(glShaderSource(vertex, 1, &vertexShaderCode, nullptr));
+    GL_CALL(glShaderSource(vertex, 1, &vertexSourceCode, nullptr));
     GL_CALL(glCompileShader(vertex));
     if (!checkCompileErrors(vertex, "VERTEX")) {
         return false;
@@ -60,63 +106,147 @@ bool Shader::loadShader(const char* vertexShaderCode, const char* fragmentShader
     }
     GL_CALL(glDeleteShader(vertex));
     GL_CALL(glDeleteShader(fragment));
+    reflectUniforms();
     return true;
 }
 
+void Shader::reflectUniforms() {
+    mUniforms.clear();
+    mUniformIndex.clear();
+    GLint count = 0;
+    GLint maxLength = 0;
+    GL_CALL(glGetProgramiv(mProgram, GL_ACTIVE_UNIFORMS, &count));
+    GL_CALL(glGetProgramiv(mProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    std::vector<GLchar> buffer(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        GL_CALL(glGetActiveUniform(mProgram, i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data()));
+        std::string name(buffer.data(), length);
+        // arrays are reported as "name[0]"
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos) {
+            name.resize(bracket);
+        }
+        if (glGetUniformLocation(mProgram, name.c_str()) < 0) {
+            continue;  // member of a uniform block
+        }
+        mUniformIndex[name] = {(uint32_t)mUniforms.size(), (uint32_t)size};
+        for (GLint j = 0; j < size; j++) {
+            std::string element = name + "[" + std::to_string(j) + "]";
+            UniformHandle handle;
+            handle.location = glGetUniformLocation(mProgram, element.c_str());
+            handle.type = type;
+            mUniformIndex[element] = {(uint32_t)mUniforms.size(), 1};
+            mUniforms.push_back(handle);
+        }
+    }
+}
+
 void Shader::use() const {
-    GL_CALL(glUseProgram(mProgram));
+    GLState::instance().useProgram(mProgram);
 }
 
 GLuint Shader::id() const {
     return mProgram;
 }
 
+UniformHandle Shader::uniform(const std::string& name) const {
+    auto it = mUniformIndex.find(name);
+    return it != mUniformIndex.end() ? mUniforms[it->second.first] : UniformHandle();
+}
+
+UniformHandle Shader::uniform(const std::string& name, uint32_t element) const {
+    auto it = mUniformIndex.find(name);
+    if (it == mUniformIndex.end() || element >= it->second.count) {
+        return UniformHandle();
+    }
+    return mUniforms[it->second.first + element];
+}
+
+void Shader::setUniformInt(UniformHandle handle, int value) const {
+    GL_CALL(glUniform1i(handle.location, value));
+}
+
+void Shader::setUniformFloat(UniformHandle handle, float value) const {
+    GL_CALL(glUniform1f(handle.location, value));
+}
+
+void Shader::setUniformVec2(UniformHandle handle, const glm::vec2& value) const {
+    GL_CALL(glUniform2fv(handle.location, 1, &value[0]));
+}
+
+void Shader::setUniformVec3(UniformHandle handle, const glm::vec3& value) const {
+    GL_CALL(glUniform3fv(handle.location, 1, &value[0]));
+}
+
+void Shader::setUniformVec3(UniformHandle handle, const glm::vec3* values, uint32_t count) const {
+    GL_CALL(glUniform3fv(handle.location, count, &values[0][0]));
+}
+
+void Shader::setUniformVec4(UniformHandle handle, const glm::vec4& value) const {
+    GL_CALL(glUniform4fv(handle.location, 1, &value[0]));
+}
+
+void Shader::setUniformMat4(UniformHandle handle, const glm::mat4& mat) const {
+    GL_CALL(glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]));
+}
+
+void Shader::setUniformMat4(UniformHandle handle, const glm::mat4* mats, uint32_t count) const {
+    GL_CALL(glUniformMatrix4fv(handle.location, count, GL_FALSE, &mats[0][0][0]));
+}
+
 void Shader::setUniformBool(const std::string& name, bool value) const {
-    GL_CALL(glUniform1i(glGetUniformLocation(mProgram, name.c_str()), (int)value));
+    GL_CALL(glUniform1i(uniform(name).location, (int)value));
 }
 
 void Shader::setUniformInt(const std::string& name, int value) const {
-    GL_CALL(glUniform1i(glGetUniformLocation(mProgram, name.c_str()), value));
+    GL_CALL(glUniform1i(uniform(name).location, value));
 }
 
 void Shader::setUniformFloat(const std::string& name, float value) const {
-    GL_CALL(glUniform1f(glGetUniformLocation(mProgram, name.c_str()), value));
+    GL_CALL(glUniform1f(uniform(name).location, value));
 }
 
 void Shader::setUniformVec2(const std::string& name, const glm::vec2& value) const {
-    GL_CALL(glUniform2fv(glGetUniformLocation(mProgram, name.c_str()), 1, &value[0]));
+    GL_CALL(glUniform2fv(uniform(name).location, 1, &value[0]));
 }
 
 void Shader::setUniformVec2(const std::string& name, float x, float y) const {
-    GL_CALL(glUniform2f(glGetUniformLocation(mProgram, name.c_str()), x, y));
+    GL_CALL(glUniform2f(uniform(name).location, x, y));
 }
 
 void Shader::setUniformVec3(const std::string& name, const glm::vec3& value) const {
-    GL_CALL(glUniform3fv(glGetUniformLocation(mProgram, name.c_str()), 1, &value[0]));
+    GL_CALL(glUniform3fv(uniform(name).location, 1, &value[0]));
 }
 
 void Shader::setUniformVec3(const std::string& name, float x, float y, float z) const {
-    GL_CALL(glUniform3f(glGetUniformLocation(mProgram, name.c_str()), x, y, z));
+    GL_CALL(glUniform3f(uniform(name).location, x, y, z));
 }
 
 void Shader::setUniformVec4(const std::string& name, const glm::vec4& value) const {
-    GL_CALL(glUniform4fv(glGetUniformLocation(mProgram, name.c_str()), 1, &value[0]));
+    GL_CALL(glUniform4fv(uniform(name).location, 1, &value[0]));
 }
 
 void Shader::setUniformVec4(const std::string& name, float x, float y, float z, float w) const {
-    GL_CALL(glUniform4f(glGetUniformLocation(mProgram, name.c_str()), x, y, z, w));
+    GL_CALL(glUniform4f(uniform(name).location, x, y, z, w));
 }
 
 void Shader::setUniformMat2(const std::string& name, const glm::mat2& mat) const {
-    GL_CALL(glUniformMatrix2fv(glGetUniformLocation(mProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+    GL_CALL(glUniformMatrix2fv(uniform(name).location, 1, GL_FALSE, &mat[0][0]));
 }
 
 void Shader::setUniformMat3(const std::string& name, const glm::mat3& mat) const {
-    GL_CALL(glUniformMatrix3fv(glGetUniformLocation(mProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+    GL_CALL(glUniformMatrix3fv(uniform(name).location, 1, GL_FALSE, &mat[0][0]));
 }
 
 void Shader::setUniformMat4(const std::string& name, const glm::mat4& mat) const {
-    GL_CALL(glUniformMatrix4fv(glGetUniformLocation(mProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]));
+    GL_CALL(glUniformMatrix4fv(uniform(name).location, 1, GL_FALSE, &mat[0][0]));
+}
+
+void Shader::setUniformMat4(const std::string& name, const glm::mat4* mats, uint32_t count) const {
+    GL_CALL(glUniformMatrix4fv(uniform(name).location, count, GL_FALSE, &mats[0][0][0]));
 }
 
 GLuint Shader::getAttribLocation(const std::string& name) const {
@@ -1,18 +1,53 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "glm/glm.hpp"
 #include "common/gfxwrapper_opengl.h"
 
+// Location of an active uniform, resolved once with Shader::uniform. The setters ignore an invalid handle, like
+// glUniform* ignores location -1.
+struct UniformHandle {
+    GLint location = -1;
+    GLenum type = GL_NONE;  // GL_FLOAT_MAT4, GL_INT, GL_SAMPLER_2D, ...
+    bool valid() const { return location >= 0; }
+};
+
 class Shader {
 public:
     Shader();
     ~Shader();
 
-    bool loadShader(const char* vertexCode, const char* fragmentCode);
+    // viewCount > 1 compiles the vertex shader for GL_OVR_multiview2. In both cases VIEW_COUNT and VIEW_ID
+    // are defined for the vertex shader, so per-eye matrices can be declared as mat4 name[VIEW_COUNT] and
+    // indexed by VIEW_ID. LATE_LATCH_BINDING and LATE_LATCH_POSE_COUNT are defined as well, see lateLatch.h,
+    // and the Camera uniform block is declared, see cameraBuffer.h.
+    bool loadShader(const char* vertexCode, const char* fragmentCode, uint32_t viewCount = 1);
+
+    // Number of views rendered per draw into the eye buffers: 1, or EYE_COUNT with multiview. The
+    // projection and view references handed to the renderers point at this many consecutive matrices.
+    static void setEyeViewCount(uint32_t count);
+    static uint32_t eyeViewCount();
 
     void use() const;
     GLuint id() const;
+
+    // Active uniforms are reflected when the program is linked. Arrays are listed per element, name is the first
+    // element and uniform(name, i) the element i. Members of uniform blocks have no handle.
+    UniformHandle uniform(const std::string& name) const;
+    UniformHandle uniform(const std::string& name, uint32_t element) const;
+
+    void setUniformInt(UniformHandle handle, int value) const;
+    void setUniformFloat(UniformHandle handle, float value) const;
+    void setUniformVec2(UniformHandle handle, const glm::vec2& value) const;
+    void setUniformVec3(UniformHandle handle, const glm::vec3& value) const;
+    void setUniformVec3(UniformHandle handle, const glm::vec3* values, uint32_t count) const;
+    void setUniformVec4(UniformHandle handle, const glm::vec4& value) const;
+    void setUniformMat4(UniformHandle handle, const glm::mat4& mat) const;
+    void setUniformMat4(UniformHandle handle, const glm::mat4* mats, uint32_t count) const;
+
+    // By name, looked up in the reflected uniforms
     void setUniformBool(const std::string& name, bool value) const;
     void setUniformInt(const std::string& name, int value) const;
     void setUniformFloat(const std::string& name, float value) const;
@@ -25,10 +60,19 @@ public:
     void setUniformMat2(const std::string& name, const glm::mat2& mat) const;
     void setUniformMat3(const std::string& name, const glm::mat3& mat) const;
     void setUniformMat4(const std::string& name, const glm::mat4& mat) const;
+    void setUniformMat4(const std::string& name, const glm::mat4* mats, uint32_t count) const;
     GLuint getAttribLocation(const std::string& name) const;
 private:
     bool checkCompileErrors(GLuint shader, std::string type);
+    void reflectUniforms();
 
 private:
     GLuint mProgram;
+    struct UniformRange {
+        uint32_t first;
+        uint32_t count;
+    };
+    std::vector<UniformHandle> mUniforms;                        // one per array element
+    std::unordered_map<std::string, UniformRange> mUniformIndex;  // "name" and "name[i]" into mUniforms
+    static uint32_t sEyeViewCount;
 };
\ No newline at end of file
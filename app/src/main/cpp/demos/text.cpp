@@ -1,9 +1,14 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
 #include "text.h"
 #include "utils.h"
+#include "profiler.h"
+#include "glState.h"
 #include <iostream>
 
-Shader Text::mShader;
+Shader Text::mShader[glyphMode_Count];
+UniformHandle Text::mModelUniform[glyphMode_Count];
+UniformHandle Text::mTextColorUniform[glyphMode_Count];
 void Text::initShader() {
     static bool init = false;
     if (init) {
@@ -14,13 +19,11 @@ void Text::initShader() {
             layout(location = 0) in vec3 aPos;
             layout(location = 1) in vec2 aTexCoords;
             out vec2 TexCoords;
-            uniform mat4 projection;
-            uniform mat4 view;
             uniform mat4 model;
             void main()
             {
                 TexCoords = aTexCoords;
-                gl_Position = projection * view * model * vec4(aPos, 1.0);
+                gl_Position = cameraViewProjection[VIEW_ID] * model * vec4(aPos, 1.0);
             }
         )_";
 
@@ -30,162 +33,170 @@ void Text::initShader() {
             in vec2 TexCoords;
             out vec4 FragColor;
             uniform vec3 textColor;
-            uniform sampler2D texture;
+            uniform sampler2D glyphTexture;
             void main()
             {
-                vec4 color = vec4(1.0, 1.0, 1.0, texture(texture, TexCoords).r);
+                vec4 color = vec4(1.0, 1.0, 1.0, texture(glyphTexture, TexCoords).r);
                 FragColor = vec4(textColor, 1.0) * color;
             }
         )_";
-        mShader.loadShader(vertexShaderCode, fragmentShaderCode);
+
+        // the edge is at 0.5, fwidth keeps it one pixel soft at any distance
+        const char* sdfFragmentShaderCode = R"_(
+            #version 320 es
+            precision mediump float;
+            in vec2 TexCoords;
+            out vec4 FragColor;
+            uniform vec3 textColor;
+            uniform sampler2D glyphTexture;
+            void main()
+            {
+                float distance = texture(glyphTexture, TexCoords).r - 0.5;
+                float width = max(fwidth(distance), 0.0001);
+                FragColor = vec4(textColor, smoothstep(-width, width, distance));
+            }
+        )_";
+
+        const char* fragmentShaders[glyphMode_Count] = {fragmentShaderCode, sdfFragmentShaderCode};
+        for (uint32_t mode = 0; mode < glyphMode_Count; mode++) {
+            mShader[mode].loadShader(vertexShaderCode, fragmentShaders[mode], Shader::eyeViewCount());
+            mModelUniform[mode] = mShader[mode].uniform("model");
+            mTextColorUniform[mode] = mShader[mode].uniform("textColor");
+        }
         init = true;
     }
 }
 
-Text::Text() {
+Text::Text(GlyphMode mode) : mMode(mode) {
 }
 
 Text::~Text() {
-    mWordsMap.clear();
-}
-
-void Text::loadFaces(const wchar_t* text, int32_t length) {
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
-        errorf("initialize freetype error");
-        return;
-    }
-    FT_Face face;
-    std::string fft("font/Alibaba-PuHuiTi-Regular.ttf");
-
-    std::vector<char> fftData = readFileFromAssets(fft.c_str());
-    if (FT_New_Memory_Face(ft, (FT_Byte*)fftData.data(), fftData.size(), 0, &face)) {
-        errorf("FT_New_Memory_Face error");
-        return;
-    }
-
-    FT_Set_Pixel_Sizes(face, 96, 96);
-    FT_Select_Charmap(face, ft_encoding_unicode);
-
-    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
-
-    for (int32_t i = 0; i < length; ++i) {
-        wchar_t ch = text[i];
-        auto it = mWordsMap.find(ch);
-        if (it != mWordsMap.end()) {
-            continue;
-        }
-
-        if (FT_Load_Glyph(face, FT_Get_Char_Index(face, ch), FT_LOAD_DEFAULT)) {
-            errorf("TextRenderSample::LoadFacesByUnicode FREETYTPE: Failed to load Glyph");
-            continue;
-        }
-
-        FT_Glyph glyph;
-        FT_Get_Glyph(face->glyph, &glyph);
-
-        //Convert the glyph to a bitmap.
-        FT_Glyph_To_Bitmap(&glyph, ft_render_mode_normal, 0, 1);
-        FT_BitmapGlyph bitmap_glyph = (FT_BitmapGlyph)glyph;
-        FT_Bitmap& bitmap = bitmap_glyph->bitmap;
-
-        GLuint texture;
-        GL_CALL(glGenTextures(1, &texture));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, texture));
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, bitmap.width, bitmap.rows, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, bitmap.buffer));
-
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-
-        Word word{texture, face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap_left, face->glyph->bitmap_top, glyph->advance.x};
-        mWordsMap[ch] = word;
-
-        debugf("bitmap.width:%d, bitmap.rows:%d, bitmap_left:%d, bitmap_top:%d, advance.x:%d", 
-            face->glyph->bitmap.width, face->glyph->bitmap.rows, face->glyph->bitmap_left, face->glyph->bitmap_top, glyph->advance.x);
-    }
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
 }
 
 bool Text::initialize() {
     initShader();
+    if (!GlyphAtlas::instance().initialize()) {
+        return false;
+    }
+    // queued now, so the digits are ready by the time they are drawn
     const wchar_t texts[] = L"-0123456789";
-    loadFaces(texts, sizeof(texts) / sizeof(texts[0]) - 1);
+    const int32_t length = sizeof(texts) / sizeof(texts[0]) - 1;
+    mGlyphs.resize(length);
+    GlyphAtlas::instance().find(texts, length, mMode, mGlyphs.data());
 
     GL_CALL(glGenVertexArrays(1, &mVAO));
     GL_CALL(glGenBuffers(1, &mVBO));
 
-    GL_CALL(glBindVertexArray(mVAO));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-    GL_CALL(glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 5, nullptr, GL_DYNAMIC_DRAW));
+    GLState::instance().bindVertexArray(mVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO);
     GL_CALL(glEnableVertexAttribArray(0));
-    GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0));
+    GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, position)));
     GL_CALL(glEnableVertexAttribArray(1));
-    GL_CALL(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(float))));
-    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, GL_NONE));
-    GL_CALL(glBindVertexArray(GL_NONE));
+    GL_CALL(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, texCoords)));
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    GLState::instance().bindVertexArray(GL_NONE);
 
     return true;
 }
 
-bool Text::render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color) {
-    mShader.use();
-    mShader.setUniformMat4("projection", p);
-    mShader.setUniformMat4("view", v);
-    mShader.setUniformMat4("model", m);
-    mShader.setUniformVec3("textColor", color);
-
-    GL_CALL(glBindVertexArray(mVAO));
-
-    float scale = 0.001f;
-    float xpos = 0.0f;
-    float ypos = 0.0f;
-    for (int32_t i = 0; i < length; ++i) {
-        wchar_t ch = text[i];
-        if (ch == L' ') {
-            xpos += 60 * scale;
-            continue;
+bool Text::render(const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color) {
+    GPU_PROFILE_SCOPE(gpuMarker_Text);
+    GlyphAtlas& atlas = GlyphAtlas::instance();
+    if ((int32_t)mGlyphs.size() < length) {
+        mGlyphs.resize(length);
+    }
+    atlas.find(text, length, mMode, mGlyphs.data());
+
+    // quads of the glyphs on each page, one after the other. A pixel of a bitmap glyph is 1mm, distance glyphs
+    // are smaller and scaled up to the same size.
+    const float scale = 0.001f * GLYPH_ATLAS_PIXEL_SIZE / GlyphAtlas::pixelSize(mMode);
+    const float spaceWidth = 0.06f;
+    const float texel = 1.0f / GLYPH_ATLAS_PAGE_SIZE;
+    uint32_t first[GLYPH_ATLAS_MAX_PAGES] = {};
+    uint32_t count[GLYPH_ATLAS_MAX_PAGES] = {};
+    mVertices.clear();
+    for (uint32_t page = 0; page < atlas.pageCount(); page++) {
+        first[page] = (uint32_t)mVertices.size();
+        float xpos = 0.0f;
+        float ypos = 0.0f;
+        for (int32_t i = 0; i < length; ++i) {
+            const AtlasGlyph* glyph = mGlyphs[i];
+            if (text[i] == L' ') {
+                xpos += spaceWidth;
+                continue;
+            }
+            if (glyph == nullptr) {
+                continue;
+            }
+            // The pen moves by the advance, the quad is placed at the bitmap offset from it. A distance glyph is
+            // GLYPH_ATLAS_SDF_SPREAD texels larger on each side, FreeType already moved its left and top by that,
+            // so both modes end up with the same metrics.
+            GLfloat w = glyph->width * scale;
+            GLfloat left = xpos + glyph->left * scale;
+            GLfloat top = glyph->top * scale;
+            GLfloat bottom = (glyph->top - glyph->rows) * scale;
+            if (glyph->page == page && glyph->width > 0) {
+                const float u0 = glyph->x * texel;
+                const float v0 = glyph->y * texel;
+                const float u1 = (glyph->x + glyph->width) * texel;
+                const float v1 = (glyph->y + glyph->rows) * texel;
+                mVertices.push_back({{left,     ypos + top,    0.0f}, {u0, v0}});
+                mVertices.push_back({{left,     ypos + bottom, 0.0f}, {u0, v1}});
+                mVertices.push_back({{left + w, ypos + bottom, 0.0f}, {u1, v1}});
+                mVertices.push_back({{left,     ypos + top,    0.0f}, {u0, v0}});
+                mVertices.push_back({{left + w, ypos + bottom, 0.0f}, {u1, v1}});
+                mVertices.push_back({{left + w, ypos + top,    0.0f}, {u1, v0}});
+            }
+            xpos += glyph->advance * scale;
         }
-        auto it = mWordsMap.find(ch);
-        if (it == mWordsMap.end()) {
-            loadFaces(text + i, length - i);
-            i--;
-            continue;
-        } else {
-            Word word = it->second;
-
-            GLfloat w = word.bitmap_width * scale;
-            GLfloat h = word.bitmap_top * scale;
-
-            xpos += word.bitmap_left * scale;
-
-            GLfloat vertices[][5] = {
-                    { xpos,     ypos + h, 0.0,   0.0, 0.0 },
-                    { xpos,     ypos,     0.0,   0.0, 1.0 },
-                    { xpos + w, ypos,     0.0,   1.0, 1.0 },
-
-                    { xpos,     ypos + h, 0.0,   0.0, 0.0 },
-                    { xpos + w, ypos,     0.0,   1.0, 1.0 },
-                    { xpos + w, ypos + h, 0.0,   1.0, 0.0 }
-            };
-
-            GL_CALL(glActiveTexture(GL_TEXTURE0));
-            GL_CALL(glBindTexture(GL_TEXTURE_2D, word.textureId));
-            //glUniform1i(m_SamplerLoc, 0);
-
-            GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-            GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices));
-            GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
-            GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 6));
-
-            xpos += w;
+        count[page] = (uint32_t)mVertices.size() - first[page];
+    }
+    if (mVertices.empty()) {
+        return true;
+    }
+
+    mShader[mMode].use();
+    mShader[mMode].setUniformMat4(mModelUniform[mMode], m);
+    mShader[mMode].setUniformVec3(mTextColorUniform[mMode], color);
+    GLState::instance().enable(GL_BLEND);
+    GLState::instance().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::instance().bindVertexArray(mVAO);
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, mVBO);
+    // a new store for every text, the draws of the previous one may still read the old
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(TextVertex), mVertices.data(), GL_STREAM_DRAW));
+    GLState::instance().activeTexture(GL_TEXTURE0);
+    for (uint32_t page = 0; page < atlas.pageCount(); page++) {
+        if (count[page] > 0) {
+            GLState::instance().bindTexture(GL_TEXTURE_2D, atlas.texture(page));
+            GL_CALL(glDrawArrays(GL_TRIANGLES, first[page], count[page]));
         }
     }
-    GL_CALL(glBindVertexArray(0));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
 
     return true;
 }
+
+typedef struct {
+    glm::mat4 model;
+    glm::vec3 color;
+    int32_t length;
+    wchar_t text[1];
+}TextParams;
+
+void Text::submit(RenderQueue& queue, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color) {
+    DrawPacket packet = {};
+    packet.pass = renderPass_Transparent;
+    packet.program = mShader[mMode].id();
+    packet.vertexArray = mVAO;
+    packet.draw = drawPacket;
+    packet.object = this;
+    TextParams* params = (TextParams*)queue.submit(packet, glm::vec3(m[3]), offsetof(TextParams, text) + length * sizeof(wchar_t));
+    params->model = m;
+    params->color = color;
+    params->length = length;
+    memcpy(params->text, text, length * sizeof(wchar_t));
+}
+
+void Text::drawPacket(const RenderQueue& queue, const DrawPacket& packet) {
+    const TextParams* params = (const TextParams*)packet.params;
+    ((Text*)packet.object)->render(params->model, params->text, params->length, params->color);
+}
@@ -1,33 +1,34 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
 #pragma once
 #include <vector>
-#include <map>
 #include "shader.h"
-#include "ft2build.h"
-#include "freetype/freetype.h"
-#include "freetype/ftglyph.h"
+#include "renderQueue.h"
+#include "glyphAtlas.h"
 
 typedef struct {
-    GLuint textureId;
-    uint32_t bitmap_width;
-    uint32_t bitmap_rows;
-    FT_Int bitmap_left;
-    FT_Int bitmap_top;
-    long advance;
-}Word;
+    glm::vec3 position;
+    glm::vec2 texCoords;
+}TextVertex;
 
 class Text {
 public:
-    Text();
+    Text(GlyphMode mode = glyphMode_Bitmap);
     ~Text();
     bool initialize();
-    bool render(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color);
+    // one draw per atlas page the glyphs of the text are on, usually one
+    bool render(const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color);
+    // queued render, the text is copied
+    void submit(RenderQueue& queue, const glm::mat4& m, const wchar_t* text, int32_t length, const glm::vec3& color);
 private:
     void initShader();
-    void loadFaces(const wchar_t* text, int32_t length);
+    static void drawPacket(const RenderQueue& queue, const DrawPacket& packet);
 private:
-    static Shader mShader;
-    std::map<int32_t, Word> mWordsMap;
+    static Shader mShader[glyphMode_Count];
+    static UniformHandle mModelUniform[glyphMode_Count];
+    static UniformHandle mTextColorUniform[glyphMode_Count];
+    GlyphMode mMode;
+    std::vector<const AtlasGlyph*> mGlyphs;   // of the text being rendered
+    std::vector<TextVertex> mVertices;        // its quads, grouped by page
     GLuint mVAO;
     GLuint mVBO;
 };
@@ -1,5 +1,8 @@
 /* Copyright (2021-2023) Bytedance Ltd. and/or its affiliates, All rights reserved. */
+#include <string.h>
 #include "utils.h"
+#include "glState.h"
+#include "glm/gtc/quaternion.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -21,7 +24,7 @@ unsigned int TextureFromFile(const char* path, const std::string& directory, boo
         } else if (nrComponents == 4) {
             format = GL_RGBA;
         }
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -57,32 +60,6 @@ bool copyFile(const char* src, const char* dst) {
     return true;
 }
 
-#include <jni.h>
-#include <android/asset_manager_jni.h>
-#include <android/asset_manager.h>
-static AAssetManager *s_nativeasset = nullptr;
-static JNIEnv *s_env = nullptr;
-static jobject s_jobj;
-static jmethodID s_mid;
-//called by java
-extern "C" JNIEXPORT 
-void JNICALL Java_com_picovr_openxr_MainActivity_setNativeAssetManager(JNIEnv *env, jobject instance, jobject assetManager) {
-    //s_env = env;
-    s_nativeasset = AAssetManager_fromJava(env, assetManager);
-    if (s_nativeasset == nullptr) {
-        errorf("s_nativeasset is nullptr!");
-    }
-
-    jclass cls = env->GetObjectClass(instance);
-    s_jobj = env->NewGlobalRef(instance);
-    s_mid = env->GetMethodID(cls, "scanFile", "(Ljava/lang/String;)V");
-    //env->CallVoidMethod(s_jobj, s_mid, env->NewStringUTF("/sdcard"));
-}
-
-void setJNIEnv(JNIEnv *env) {
-    s_env = env;
-}
-
 unsigned int TextureFromFileAssets(const char* path, const std::string& directory, bool gamma) {
     std::string filename = std::string(path);
     if (directory != "") {
@@ -92,13 +69,11 @@ unsigned int TextureFromFileAssets(const char* path, const std::string& director
     glGenTextures(1, &textureID);
 
     // read file from assets
-    AAsset *pathAsset = AAssetManager_open(s_nativeasset, filename.c_str(), AASSET_MODE_UNKNOWN);
-    off_t assetLength = AAsset_getLength(pathAsset);
-    unsigned char *fileData = (unsigned char *) AAsset_getBuffer(pathAsset);
+    std::vector<char> fileData = readFileFromAssets(filename.c_str());
 
     int width, height, nrComponents;
     //unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    unsigned char *data = stbi_load_from_memory(fileData, assetLength, &width, &height, &nrComponents, 0);
+    unsigned char *data = stbi_load_from_memory((const stbi_uc*)fileData.data(), fileData.size(), &width, &height, &nrComponents, 0);
     if (data) {
         GLenum format;
         if (nrComponents == 1) {
@@ -108,7 +83,7 @@ unsigned int TextureFromFileAssets(const char* path, const std::string& director
         } else if (nrComponents == 4) {
             format = GL_RGBA;
         }
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, textureID);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -119,20 +94,29 @@ unsigned int TextureFromFileAssets(const char* path, const std::string& director
     } else {
         errorf("Texture failed to load at path: %s", path);
     }
-    AAsset_close(pathAsset);
     return textureID;
 }
 
-std::vector<char> readFileFromAssets(const char* filename) {
-    AAsset *pathAsset = AAssetManager_open(s_nativeasset, filename, AASSET_MODE_UNKNOWN);
-    off_t assetLength = AAsset_getLength(pathAsset);
-    unsigned char *fileData = (unsigned char *) AAsset_getBuffer(pathAsset);
-    std::vector<char> buffer(assetLength);
-    memcpy(buffer.data(), fileData, assetLength);
-    AAsset_close(pathAsset);
-    return buffer;
+bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension != nullptr && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void refreshMedia(const std::string& path) {
-    s_env->CallVoidMethod(s_jobj, s_mid, s_env->NewStringUTF(path.c_str()));
+XrPosef quadLayerPose(const glm::mat4& model, float quadSize, XrExtent2Df& size) {
+    const glm::vec3 axisX = glm::vec3(model[0]);
+    const glm::vec3 axisY = glm::vec3(model[1]);
+    const glm::vec3 axisZ = glm::vec3(model[2]);
+    const glm::quat orientation = glm::quat_cast(glm::mat3(glm::normalize(axisX), glm::normalize(axisY), glm::normalize(axisZ)));
+    XrPosef pose;
+    pose.orientation = {orientation.x, orientation.y, orientation.z, orientation.w};
+    pose.position = {model[3].x, model[3].y, model[3].z};
+    size = {quadSize * glm::length(axisX), quadSize * glm::length(axisY)};
+    return pose;
 }
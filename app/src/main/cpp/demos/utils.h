@@ -3,7 +3,10 @@
 #include <string>
 #include <vector>
 #include "common/gfxwrapper_opengl.h"
+#include "glm/glm.hpp"
+#include <openxr/openxr.h>
 #include "logger.h"
+#include "platform.h"
 
 #define OPENGL_DEBUG
 #ifdef OPENGL_DEBUG
@@ -22,9 +25,11 @@
 bool copyFile(const char* src, const char* dst);
 unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma = false);
 unsigned int TextureFromFileAssets(const char* path, const std::string& directory, bool gamma = false);
-std::vector<char> readFileFromAssets(const char* file);
-void refreshMedia(const std::string& path);
-void setJNIEnv(JNIEnv *env);
+// true if the current GL context lists the extension
+bool hasGLExtension(const char* name);
+// Pose and size of a quad layer covering a quad drawn with model. The quad spans -quadSize/2..quadSize/2 on x and y
+// in model space, the scale of the model goes into the size.
+XrPosef quadLayerPose(const glm::mat4& model, float quadSize, XrExtent2Df& size);
 
 
 #define HAND_LEFT  0
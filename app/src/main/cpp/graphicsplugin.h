@@ -36,6 +36,16 @@ struct IGraphicsPlugin {
     virtual void RenderView(std::shared_ptr<IApplication>& application, const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                             int64_t swapchainFormat, const int32_t eye) = 0;
 
+    // True if all views can be rendered in a single pass into the layers of one array swapchain image.
+    virtual bool IsMultiviewSupported() const { return false; }
+
+    // Render all projection views in a single pass. layerViews[i] targets array layer i of the swapchain image.
+    virtual void RenderMultiView(std::shared_ptr<IApplication>& /*application*/, const XrCompositionLayerProjectionView* /*layerViews*/,
+                                 uint32_t /*viewCount*/, const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*swapchainFormat*/) {}
+
+    // Copy a width x height GL_TEXTURE_2D of the application into a swapchain image of the same size.
+    virtual void CopyToSwapchainImage(uint32_t /*texture*/, int32_t /*width*/, int32_t /*height*/, const XrSwapchainImageBaseHeader* /*swapchainImage*/) {}
+
     // Get recommended number of sub-data element samples in view (recommendedSwapchainSampleCount)
     // if supported by the graphics plugin. A supported value otherwise.
     virtual uint32_t GetSupportedSwapchainSampleCount(const XrViewConfigurationView& view) {
@@ -14,6 +14,9 @@
 #include <common/xr_linear.h>
 #include "demos/controller.h"
 #include "demos/application.h"
+#include "demos/cameraBuffer.h"
+#include "demos/glState.h"
+#include "demos/utils.h"
 
 namespace {
 
@@ -27,16 +30,29 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         if (m_swapchainFramebuffer != 0) {
             glDeleteFramebuffers(1, &m_swapchainFramebuffer);
         }
+        if (m_copyFramebuffer != 0) {
+            glDeleteFramebuffers(1, &m_copyFramebuffer);
+        }
         for (auto& colorToDepth : m_colorToDepthMap) {
             if (colorToDepth.second != 0) {
                 glDeleteTextures(1, &colorToDepth.second);
             }
         }
+        // The EGL display stays initialized, it is shared with the runtime.
+        ksGpuContext_Destroy(&context);
+        ksGpuDevice_Destroy(&device);
     }
 
-    std::vector<std::string> GetInstanceExtensions() const override { return {XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME}; }
+    std::vector<std::string> GetInstanceExtensions() const override {
+#if defined(XR_USE_PLATFORM_EGL)
+        return {XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME, XR_MNDX_EGL_ENABLE_EXTENSION_NAME};
+#else
+        return {XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME};
+#endif
+    }
 
-    ksGpuWindow window{};
+    ksGpuDevice device{};
+    ksGpuContext context{};
 
     void DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
         (void)source;
@@ -55,13 +71,14 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         XrGraphicsRequirementsOpenGLESKHR graphicsRequirements{XR_TYPE_GRAPHICS_REQUIREMENTS_OPENGL_ES_KHR};
         CHECK_XRCMD(pfnGetOpenGLESGraphicsRequirementsKHR(instance, systemId, &graphicsRequirements));
 
-        // Initialize the gl extensions. Note we have to open a window.
+        // Initialize the gl extensions. All rendering goes to swapchain images, so the context does not need a window.
         ksDriverInstance driverInstance{};
         ksGpuQueueInfo queueInfo{};
         ksGpuSurfaceColorFormat colorFormat{KS_GPU_SURFACE_COLOR_FORMAT_B8G8R8A8};
-        ksGpuSurfaceDepthFormat depthFormat{KS_GPU_SURFACE_DEPTH_FORMAT_D24};
+        ksGpuSurfaceDepthFormat depthFormat{KS_GPU_SURFACE_DEPTH_FORMAT_NONE};
         ksGpuSampleCount sampleCount{KS_GPU_SAMPLE_COUNT_1};
-        if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
+        ksGpuDevice_Create(&device, &driverInstance, &queueInfo);
+        if (!ksGpuContext_CreateSurfaceless(&context, &device, 0, colorFormat, depthFormat, sampleCount)) {
             THROW("Unable to create GL context");
         }
 
@@ -76,9 +93,14 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         }
 
 #if defined(XR_USE_PLATFORM_ANDROID)
-        m_graphicsBinding.display = window.display;
+        m_graphicsBinding.display = context.display;
         m_graphicsBinding.config = (EGLConfig)0;
-        m_graphicsBinding.context = window.context.context;
+        m_graphicsBinding.context = context.context;
+#elif defined(XR_USE_PLATFORM_EGL)
+        m_graphicsBinding.getProcAddress = reinterpret_cast<PFN_xrEglGetProcAddressMNDX>(eglGetProcAddress);
+        m_graphicsBinding.display = context.display;
+        m_graphicsBinding.config = context.config;
+        m_graphicsBinding.context = context.context;
 #endif
 
         glEnable(GL_DEBUG_OUTPUT);
@@ -89,11 +111,16 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
             },
             this);
 
+        m_multiviewSupported = (glFramebufferTextureMultiviewOVR != nullptr) && hasGLExtension("GL_OVR_multiview2");
+        Log::Write(Log::Level::Info, Fmt("GL_OVR_multiview2 %s", m_multiviewSupported ? "supported" : "not supported"));
+
         InitializeResources();
     }
 
     void InitializeResources() {
         glGenFramebuffers(1, &m_swapchainFramebuffer);
+        glGenFramebuffers(1, &m_copyFramebuffer);
+        GLState::instance().initialize();
     }
 
     int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
@@ -140,13 +167,13 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         // This back-buffer has no corresponding depth-stencil texture, so create one with matching dimensions.
         GLint width;
         GLint height;
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, colorTexture);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
 
         uint32_t depthTexture;
         glGenTextures(1, &depthTexture);
-        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, depthTexture);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -158,17 +185,89 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         return depthTexture;
     }
 
+    uint32_t GetDepthTextureArray(uint32_t colorTexture, uint32_t layerCount) {
+        auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
+        if (depthBufferIt != m_colorToDepthMap.end()) {
+            return depthBufferIt->second;
+        }
+
+        GLint width;
+        GLint height;
+        GLState::instance().bindTexture(GL_TEXTURE_2D_ARRAY, colorTexture);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &height);
+
+        uint32_t depthTexture;
+        glGenTextures(1, &depthTexture);
+        GLState::instance().bindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, width, height, layerCount);
+
+        m_colorToDepthMap.insert(std::make_pair(colorTexture, depthTexture));
+
+        return depthTexture;
+    }
+
+    bool IsMultiviewSupported() const override { return m_multiviewSupported; }
+
+    void RenderMultiView(std::shared_ptr<IApplication>& application, const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                         const XrSwapchainImageBaseHeader* swapchainImage, int64_t swapchainFormat) override {
+        CHECK(viewCount == 2);
+        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
+
+        GLState::instance().bindFramebuffer(m_swapchainFramebuffer);
+
+        // All views share the same image rect, one array layer each.
+        GLState::instance().viewport(static_cast<GLint>(layerViews[0].subImage.imageRect.offset.x),
+                                     static_cast<GLint>(layerViews[0].subImage.imageRect.offset.y),
+                                     static_cast<GLsizei>(layerViews[0].subImage.imageRect.extent.width),
+                                     static_cast<GLsizei>(layerViews[0].subImage.imageRect.extent.height));
+
+        const uint32_t depthTexture = GetDepthTextureArray(colorTexture, viewCount);
+
+        glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, 0, viewCount);
+        glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0, viewCount);
+
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+        XrPosef eyePose[2];
+        glm::mat4 p[2];
+        glm::mat4 v[2];
+        for (uint32_t i = 0; i < viewCount; i++) {
+            eyePose[i] = layerViews[i].pose;
+            XrMatrix4x4f projection{};
+            XrMatrix4x4f view{};
+            XrMatrix4x4f toView{};
+            XrVector3f scale{1.0f, 1.0f, 1.0f};
+            XrMatrix4x4f_CreateProjectionFov(&projection, GRAPHICS_OPENGL_ES, layerViews[i].fov, 0.05f, 100.0f);
+            XrMatrix4x4f_CreateTranslationRotationScale(&toView, &eyePose[i].position, &eyePose[i].orientation, &scale);
+            XrMatrix4x4f_InvertRigidBody(&view, &toView);
+
+            p[i] = glm::make_mat4((float*)&projection);
+            v[i] = glm::make_mat4((float*)&view);
+        }
+
+        CameraBuffer::instance().update(p, v, viewCount, EYE_LEFT);
+        application->renderFrameMultiview(eyePose, p, v);
+
+        GLState::instance().bindFramebuffer(0);
+    }
+
     void RenderView(std::shared_ptr<IApplication>& application, const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const int32_t eye) override {
 
         const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
 
-        glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+        GLState::instance().bindFramebuffer(m_swapchainFramebuffer);
         
-        glViewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
-                   static_cast<GLint>(layerView.subImage.imageRect.offset.y),
-                   static_cast<GLsizei>(layerView.subImage.imageRect.extent.width),
-                   static_cast<GLsizei>(layerView.subImage.imageRect.extent.height));
+        GLState::instance().viewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
+                                     static_cast<GLint>(layerView.subImage.imageRect.offset.y),
+                                     static_cast<GLsizei>(layerView.subImage.imageRect.extent.width),
+                                     static_cast<GLsizei>(layerView.subImage.imageRect.extent.height));
 
         const uint32_t depthTexture = GetDepthTexture(colorTexture);
 
@@ -190,18 +289,41 @@ struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
         glm::mat4 p = glm::make_mat4((float*)&projection);
         glm::mat4 v = glm::make_mat4((float*)&view);
 
+        CameraBuffer::instance().update(&p, &v, 1, eye);
         application->renderFrame(eyePose, p, v, eye);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::instance().bindFramebuffer(0);
+    }
+
+    void CopyToSwapchainImage(uint32_t texture, int32_t width, int32_t height, const XrSwapchainImageBaseHeader* swapchainImage) override {
+        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
+
+        GLState::instance().bindFramebuffer(m_swapchainFramebuffer);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_copyFramebuffer);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+        // the blit is scissored like a draw
+        GLState::instance().disable(GL_SCISSOR_TEST);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        // GLState tracks a single binding for the read and the draw framebuffer
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_swapchainFramebuffer);
+        GLState::instance().bindFramebuffer(0);
     }
 
    private:
 #ifdef XR_USE_PLATFORM_ANDROID
     XrGraphicsBindingOpenGLESAndroidKHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_OPENGL_ES_ANDROID_KHR};
+#elif defined(XR_USE_PLATFORM_EGL)
+    XrGraphicsBindingEGLMNDX m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_EGL_MNDX};
 #endif
     std::list<std::vector<XrSwapchainImageOpenGLESKHR>> m_swapchainImageBuffers;
     GLuint m_swapchainFramebuffer{0};
+    GLuint m_copyFramebuffer{0};   // reads the application texture of CopyToSwapchainImage
     std::map<uint32_t, uint32_t> m_colorToDepthMap;
+    bool m_multiviewSupported{false};
 };
 }  // namespace
 
@@ -0,0 +1,115 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pch.h"
+#include "common.h"
+#include "logger.h"
+
+#if defined(XR_USE_PLATFORM_EGL) && !defined(XR_USE_PLATFORM_ANDROID)
+
+#include <dlfcn.h>
+#include <fstream>
+#include <sstream>
+#include <openxr/openxr_loader_negotiation.h>
+
+#define LOADER_DEFINE_FUNCTION(name, version) PFN_xr##name xr##name = nullptr;
+XR_LIST_FUNCTIONS_XR_VERSION_1_0(LOADER_DEFINE_FUNCTION)
+#undef LOADER_DEFINE_FUNCTION
+
+namespace {
+void* g_runtimeLibrary = nullptr;
+PFN_xrCreateInstance g_runtimeCreateInstance = nullptr;
+
+// Only what the loader needs from the manifest: the value of "library_path", relative to the manifest.
+std::string ReadLibraryPath(const std::string& manifestPath) {
+    std::ifstream file(manifestPath);
+    if (!file) {
+        return {};
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    const std::string json = content.str();
+
+    size_t pos = json.find("\"library_path\"");
+    if (pos == std::string::npos || (pos = json.find(':', pos)) == std::string::npos ||
+        (pos = json.find('"', pos)) == std::string::npos) {
+        return {};
+    }
+    const size_t end = json.find('"', pos + 1);
+    if (end == std::string::npos) {
+        return {};
+    }
+    std::string libraryPath = json.substr(pos + 1, end - pos - 1);
+    if (!libraryPath.empty() && libraryPath[0] != '/') {
+        const size_t slash = manifestPath.find_last_of('/');
+        if (slash != std::string::npos) {
+            libraryPath = manifestPath.substr(0, slash + 1) + libraryPath;
+        }
+    }
+    return libraryPath;
+}
+
+void LoadFunctions(XrInstance instance) {
+#define LOADER_LOAD_FUNCTION(name, version)                                                  \
+    if (std::string(#name) != "GetInstanceProcAddr" && std::string(#name) != "CreateInstance") { \
+        xrGetInstanceProcAddr(instance, "xr" #name, (PFN_xrVoidFunction*)&xr##name);              \
+    }
+    XR_LIST_FUNCTIONS_XR_VERSION_1_0(LOADER_LOAD_FUNCTION)
+#undef LOADER_LOAD_FUNCTION
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL LoaderCreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance) {
+    const XrResult result = g_runtimeCreateInstance(createInfo, instance);
+    if (XR_SUCCEEDED(result)) {
+        LoadFunctions(*instance);
+    }
+    return result;
+}
+}  // namespace
+
+bool LoadRuntime() {
+    const char* manifestPath = getenv("XR_RUNTIME_JSON");
+    if (manifestPath == nullptr) {
+        Log::Write(Log::Level::Error, "XR_RUNTIME_JSON is not set");
+        return false;
+    }
+    const std::string libraryPath = ReadLibraryPath(manifestPath);
+    if (libraryPath.empty()) {
+        Log::Write(Log::Level::Error, Fmt("No library_path in runtime manifest %s", manifestPath));
+        return false;
+    }
+
+    g_runtimeLibrary = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (g_runtimeLibrary == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("Failed to open runtime %s: %s", libraryPath.c_str(), dlerror()));
+        return false;
+    }
+    auto negotiate = (PFN_xrNegotiateLoaderRuntimeInterface)dlsym(g_runtimeLibrary, "xrNegotiateLoaderRuntimeInterface");
+    if (negotiate == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("%s does not export xrNegotiateLoaderRuntimeInterface", libraryPath.c_str()));
+        return false;
+    }
+
+    XrNegotiateLoaderInfo loaderInfo{XR_LOADER_INTERFACE_STRUCT_LOADER_INFO, XR_LOADER_INFO_STRUCT_VERSION, sizeof(XrNegotiateLoaderInfo)};
+    loaderInfo.minInterfaceVersion = 1;
+    loaderInfo.maxInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+    loaderInfo.minApiVersion = XR_MAKE_VERSION(1, 0, 0);
+    loaderInfo.maxApiVersion = XR_MAKE_VERSION(1, 0x3ff, 0xfff);
+    XrNegotiateRuntimeRequest runtimeRequest{XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST, XR_RUNTIME_INFO_STRUCT_VERSION,
+                                             sizeof(XrNegotiateRuntimeRequest)};
+    if (XR_FAILED(negotiate(&loaderInfo, &runtimeRequest)) || runtimeRequest.getInstanceProcAddr == nullptr) {
+        Log::Write(Log::Level::Error, Fmt("Loader interface negotiation with %s failed", libraryPath.c_str()));
+        return false;
+    }
+    Log::Write(Log::Level::Info, Fmt("Loaded runtime %s", libraryPath.c_str()));
+
+    // The functions a loader resolves without an instance, xrCreateInstance resolves the others.
+    xrGetInstanceProcAddr = runtimeRequest.getInstanceProcAddr;
+    xrGetInstanceProcAddr(XR_NULL_HANDLE, "xrEnumerateInstanceExtensionProperties", (PFN_xrVoidFunction*)&xrEnumerateInstanceExtensionProperties);
+    xrGetInstanceProcAddr(XR_NULL_HANDLE, "xrEnumerateApiLayerProperties", (PFN_xrVoidFunction*)&xrEnumerateApiLayerProperties);
+    xrGetInstanceProcAddr(XR_NULL_HANDLE, "xrCreateInstance", (PFN_xrVoidFunction*)&g_runtimeCreateInstance);
+    xrCreateInstance = LoaderCreateInstance;
+    return g_runtimeCreateInstance != nullptr;
+}
+#endif
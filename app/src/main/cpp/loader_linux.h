@@ -0,0 +1,15 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// Headless Linux host, which has no libopenxr_loader. The program is built with XR_NO_PROTOTYPES and calls the
+// core OpenXR functions through these pointers. LoadRuntime fills the ones usable without an instance, the
+// others are filled when xrCreateInstance succeeds.
+#define LOADER_DECLARE_FUNCTION(name, version) extern PFN_xr##name xr##name;
+XR_LIST_FUNCTIONS_XR_VERSION_1_0(LOADER_DECLARE_FUNCTION)
+#undef LOADER_DECLARE_FUNCTION
+
+// Opens the runtime library named by the manifest in XR_RUNTIME_JSON and negotiates the loader interface with it.
+bool LoadRuntime();
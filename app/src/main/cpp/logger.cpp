@@ -7,11 +7,20 @@
 
 #include <sstream>
 
+#ifdef XR_USE_PLATFORM_ANDROID
 #define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR,   "demos", __VA_ARGS__)
 #define ALOGW(...) __android_log_print(ANDROID_LOG_WARN,    "demos", __VA_ARGS__)
 #define ALOGI(...) __android_log_print(ANDROID_LOG_INFO,    "demos", __VA_ARGS__)
 #define ALOGD(...) __android_log_print(ANDROID_LOG_DEBUG,   "demos", __VA_ARGS__)
 #define ALOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, "demos", __VA_ARGS__)
+#else
+// std::cout and std::clog already carry the message
+#define ALOGE(...)
+#define ALOGW(...)
+#define ALOGI(...)
+#define ALOGD(...)
+#define ALOGV(...)
+#endif
 
 namespace {
     Log::Level g_minSeverity{Log::Level::Verbose};
@@ -18,15 +18,45 @@ void ShowHelp() {
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.formFactor Hmd|Handheld");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.viewConfiguration Stereo|Mono");
     Log::Write(Log::Level::Info, "adb shell setprop debug.xr.blendMode Opaque|Additive|AlphaBlend");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.pipelinedFrameLoop 0|1");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.multiview 0|1");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.countFrameAllocations 0|1");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.guiLayer 0|1");
+    Log::Write(Log::Level::Info, "adb shell setprop debug.xr.videoLayer 0|1");
     Log::Write(Log::Level::Info, "adb shell setprop persist.log.tag V");
 }
 
 bool UpdateOptionsFromSystemProperties(Options& options) {
-    char value[PROP_VALUE_MAX] = {};
-    if (__system_property_get("debug.xr.graphicsPlugin", value) != 0) {
+    std::string value = getSystemProperty("debug.xr.graphicsPlugin");
+    if (!value.empty()) {
         options.GraphicsPlugin = value;
     }
 
+    value = getSystemProperty("debug.xr.pipelinedFrameLoop");
+    if (!value.empty()) {
+        options.PipelinedFrameLoop = (value == "1" || EqualsIgnoreCase(value, "true"));
+    }
+
+    value = getSystemProperty("debug.xr.multiview");
+    if (!value.empty()) {
+        options.Multiview = (value == "1" || EqualsIgnoreCase(value, "true"));
+    }
+
+    value = getSystemProperty("debug.xr.countFrameAllocations");
+    if (!value.empty()) {
+        options.CountFrameAllocations = (value == "1" || EqualsIgnoreCase(value, "true"));
+    }
+
+    value = getSystemProperty("debug.xr.guiLayer");
+    if (!value.empty()) {
+        options.GuiLayer = (value == "1" || EqualsIgnoreCase(value, "true"));
+    }
+
+    value = getSystemProperty("debug.xr.videoLayer");
+    if (!value.empty()) {
+        options.VideoLayer = (value == "1" || EqualsIgnoreCase(value, "true"));
+    }
+
     // Check for required parameters.
     if (options.GraphicsPlugin.empty()) {
         Log::Write(Log::Level::Warning, __FILE__, __LINE__, "GraphicsPlugin Default OpenGLES");
@@ -36,7 +66,7 @@ bool UpdateOptionsFromSystemProperties(Options& options) {
 }
 }  // namespace
 
-
+#ifdef XR_USE_PLATFORM_ANDROID
 struct AndroidAppState {
     ANativeWindow* NativeWindow = nullptr;
     bool Resumed = false;
@@ -205,3 +235,58 @@ void android_main(struct android_app* app) {
         Log::Write(Log::Level::Error, __FILE__, __LINE__, "Unknown Error");
     }
 }
+#else
+/**
+ * Headless host: runs the frame loop until the runtime ends the session, e.g. the mock runtime after
+ * MOCK_XR_FRAME_COUNT frames. Options are read from the environment, see getSystemProperty.
+ */
+int main() {
+    try {
+        if (!LoadRuntime()) {
+            return 1;
+        }
+
+        std::shared_ptr<Options> options = std::make_shared<Options>();
+        if (!UpdateOptionsFromSystemProperties(*options)) {
+            return 1;
+        }
+        std::shared_ptr<PlatformData> data = std::make_shared<PlatformData>();
+
+        bool requestRestart = false;
+        bool exitRenderLoop = false;
+
+        std::shared_ptr<IPlatformPlugin> platformPlugin = CreatePlatformPlugin(options, data);
+        std::shared_ptr<IGraphicsPlugin> graphicsPlugin = CreateGraphicsPlugin(options, platformPlugin);
+        std::shared_ptr<IOpenXrProgram> program = CreateOpenXrProgram(options, platformPlugin, graphicsPlugin);
+
+        program->CreateInstance();
+        program->InitializeSystem();
+        program->InitializeSession();
+        program->CreateSwapchains();
+        program->InitializeApplication();
+
+        while (!exitRenderLoop) {
+            program->PollEvents(&exitRenderLoop, &requestRestart);
+            if (exitRenderLoop) {
+                break;
+            }
+
+            if (!program->IsSessionRunning()) {
+                // Throttle loop since xrWaitFrame won't be called.
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+
+            program->PollActions();
+            program->RenderFrame();
+        }
+    } catch (const std::exception& ex) {
+        Log::Write(Log::Level::Error, __FILE__, __LINE__, ex.what());
+        return 1;
+    } catch (...) {
+        Log::Write(Log::Level::Error, __FILE__, __LINE__, "Unknown Error");
+        return 1;
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,1303 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Headless stand-in for an OpenXR runtime. It implements the subset of OpenXR used by this program:
+// instance and session lifetime, swapchains backed by plain GL textures, xrWaitFrame pacing, reference and
+// action spaces with scripted poses, hand joints, and stubs for passthrough and the display refresh rate.
+// Nothing is displayed, submitted layers are only counted.
+//
+// Point the loader at mock_runtime.json (XR_RUNTIME_JSON on desktop loaders and the host build, whose CMakeLists.txt
+// copies it next to the library and runs the demos against it under ctest). Environment variables:
+//   MOCK_XR_FRAME_COUNT=<n>   request the session to exit after n frames
+//   MOCK_XR_FREE_RUNNING=1    do not sleep in xrWaitFrame; the display time advances by exactly one display
+//                             period per frame from a fixed epoch, so poses and timing are reproducible
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#ifdef XR_USE_PLATFORM_ANDROID
+#include <jni.h>
+#endif
+
+#define XR_NO_PROTOTYPES
+#include <openxr/openxr.h>
+#include <openxr/openxr_platform.h>
+#include <openxr/openxr_loader_negotiation.h>
+#include <openxr/openxr_reflection.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define MOCK_LOG(...) __android_log_print(ANDROID_LOG_INFO, "mock_runtime", __VA_ARGS__)
+#else
+#define MOCK_LOG(...) (fprintf(stderr, "mock_runtime: " __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+namespace {
+
+constexpr XrSystemId MockSystemId = 1;
+constexpr XrTime FreeRunningEpoch = 1000000000;  // display time of the first frame when free running
+constexpr uint32_t ViewCount = 2;
+constexpr uint32_t RecommendedImageSize = 1920;
+constexpr uint32_t SwapchainImageCount = 3;
+constexpr float Ipd = 0.063f;
+constexpr float StageHeight = 1.6f;
+constexpr float DisplayRefreshRates[] = {72.0f, 90.0f};
+
+const char* const SupportedExtensions[] = {
+    XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME,
+#ifdef __ANDROID__
+    XR_KHR_ANDROID_CREATE_INSTANCE_EXTENSION_NAME,
+    XR_KHR_LOADER_INIT_EXTENSION_NAME,
+    XR_KHR_LOADER_INIT_ANDROID_EXTENSION_NAME,
+#endif
+#ifdef XR_USE_PLATFORM_EGL
+    XR_MNDX_EGL_ENABLE_EXTENSION_NAME,
+#endif
+    XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME,
+    XR_KHR_LOCATE_SPACES_EXTENSION_NAME,
+    XR_EPIC_VIEW_CONFIGURATION_FOV_EXTENSION_NAME,
+    XR_FB_PASSTHROUGH_EXTENSION_NAME,
+    XR_FB_TRIANGLE_MESH_EXTENSION_NAME,
+    XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME,
+    XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME,
+    XR_EXT_HAND_TRACKING_EXTENSION_NAME,
+    XR_BD_CONTROLLER_INTERACTION_EXTENSION_NAME,
+};
+
+XrTime NowNanoseconds() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (XrTime)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+bool IsEnvironmentSet(const char* name) {
+    const char* value = getenv(name);
+    return value != nullptr && (strcmp(value, "1") == 0 || strcmp(value, "true") == 0);
+}
+
+template <typename Handle, typename T>
+Handle ToHandle(T* object) {
+    return (Handle)(uintptr_t)object;
+}
+
+template <typename T, typename Handle>
+T* FromHandle(Handle handle) {
+    return (T*)(uintptr_t)handle;
+}
+
+// Two-call idiom for arrays of plain values.
+template <typename T>
+XrResult CopyArray(const T* values, uint32_t valueCount, uint32_t capacityInput, uint32_t* countOutput, T* output) {
+    if (countOutput == nullptr) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    *countOutput = valueCount;
+    if (capacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacityInput < valueCount) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    std::copy(values, values + valueCount, output);
+    return XR_SUCCESS;
+}
+
+template <typename T>
+T* FindNext(void* next, XrStructureType type) {
+    for (XrBaseOutStructure* s = reinterpret_cast<XrBaseOutStructure*>(next); s != nullptr; s = s->next) {
+        if (s->type == type) {
+            return reinterpret_cast<T*>(s);
+        }
+    }
+    return nullptr;
+}
+
+//
+// Pose math
+//
+
+XrQuaternionf Multiply(const XrQuaternionf& a, const XrQuaternionf& b) {
+    return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y, a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w, a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+XrVector3f Rotate(const XrQuaternionf& q, const XrVector3f& v) {
+    const XrQuaternionf p{v.x, v.y, v.z, 0.0f};
+    const XrQuaternionf r = Multiply(Multiply(q, p), {-q.x, -q.y, -q.z, q.w});
+    return {r.x, r.y, r.z};
+}
+
+// b expressed in the space of a, returned in the parent space of a
+XrPosef Multiply(const XrPosef& a, const XrPosef& b) {
+    const XrVector3f p = Rotate(a.orientation, b.position);
+    return {Multiply(a.orientation, b.orientation), {a.position.x + p.x, a.position.y + p.y, a.position.z + p.z}};
+}
+
+XrPosef Invert(const XrPosef& a) {
+    const XrQuaternionf q{-a.orientation.x, -a.orientation.y, -a.orientation.z, a.orientation.w};
+    const XrVector3f p = Rotate(q, {-a.position.x, -a.position.y, -a.position.z});
+    return {q, p};
+}
+
+XrPosef MakePose(float yaw, float pitch, const XrVector3f& position) {
+    const XrQuaternionf qYaw{0.0f, sinf(yaw * 0.5f), 0.0f, cosf(yaw * 0.5f)};
+    const XrQuaternionf qPitch{sinf(pitch * 0.5f), 0.0f, 0.0f, cosf(pitch * 0.5f)};
+    return {Multiply(qYaw, qPitch), position};
+}
+
+//
+// Scripted poses in LOCAL space, functions of the display time only.
+//
+
+XrPosef HeadPose(XrTime time) {
+    const float s = time * 1e-9f;
+    return MakePose(0.15f * sinf(0.4f * s), 0.05f * sinf(0.3f * s), {0.0f, 0.02f * sinf(0.7f * s), 0.0f});
+}
+
+XrPosef GazePose(XrTime time) {
+    const float s = time * 1e-9f;
+    const XrPosef head = HeadPose(time);
+    return Multiply(head, MakePose(0.3f * sinf(0.9f * s), 0.1f * sinf(1.3f * s), {0.0f, 0.0f, 0.0f}));
+}
+
+XrPosef HandPose(uint32_t hand, bool aim, XrTime time) {
+    const float s = time * 1e-9f;
+    const float side = hand == 0 ? -1.0f : 1.0f;
+    const float phase = hand == 0 ? 0.0f : 1.5f;
+    const XrVector3f position{side * 0.2f + 0.05f * cosf(s + phase), -0.35f + 0.05f * sinf(2.0f * s + phase), -0.45f};
+    return MakePose(side * -0.1f, aim ? -0.6f : 0.0f, position);
+}
+
+//
+// Objects behind the handles
+//
+
+struct Instance;
+struct Session;
+
+struct ActionSet {
+    Instance* instance;
+    std::string name;
+};
+
+struct Action {
+    ActionSet* actionSet;
+    std::string name;
+    XrActionType type;
+};
+
+struct Space {
+    Session* session;
+    bool isReference;
+    XrReferenceSpaceType referenceSpaceType;
+    Action* action;
+    int32_t hand;  // -1 if the action space is not bound to /user/hand/left or /user/hand/right
+    XrPosef pose;  // pose in the reference or action space
+};
+
+struct Swapchain {
+    Session* session;
+    XrSwapchainCreateInfo createInfo;
+    std::vector<GLuint> images;
+    uint32_t acquireIndex;
+};
+
+struct HandTracker {
+    Session* session;
+    XrHandEXT hand;
+};
+
+struct TriangleMesh {
+    std::vector<XrVector3f> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Passthrough, passthrough layers and geometry instances carry no state.
+struct Placeholder {
+    Session* session;
+};
+
+struct Session {
+    Instance* instance;
+    XrSessionState state{XR_SESSION_STATE_UNKNOWN};
+    bool running{false};
+    bool exitRequested{false};
+
+    std::mutex frameMutex;
+    std::condition_variable frameCondition;
+    bool frameWaited{false};  // xrWaitFrame returned and the next xrBeginFrame has not been called yet
+    bool frameBegun{false};   // xrBeginFrame was called and xrEndFrame has not been called yet
+    XrTime lastDisplayTime{0};
+    uint64_t frameCount{0};
+    float refreshRate{DisplayRefreshRates[0]};
+};
+
+struct Instance {
+    std::mutex mutex;
+    std::vector<std::string> paths;  // XrPath is the index + 1
+    std::deque<XrEventDataBuffer> events;
+    Session* session{nullptr};
+
+    bool freeRunning{false};
+    uint64_t frameLimit{0};
+
+    XrPath StringToPath(const char* string) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(paths.begin(), paths.end(), string);
+        if (it != paths.end()) {
+            return (XrPath)(it - paths.begin() + 1);
+        }
+        paths.push_back(string);
+        return (XrPath)paths.size();
+    }
+
+    std::string PathToString(XrPath path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (path == XR_NULL_PATH || path > paths.size()) ? std::string() : paths[path - 1];
+    }
+
+    template <typename T>
+    void PushEvent(const T& event) {
+        XrEventDataBuffer buffer{};
+        static_assert(sizeof(T) <= sizeof(buffer), "event does not fit into XrEventDataBuffer");
+        memcpy(&buffer, &event, sizeof(T));
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(buffer);
+    }
+};
+
+XrTime CurrentTime(const Session* session) {
+    return session->instance->freeRunning ? session->lastDisplayTime : NowNanoseconds();
+}
+
+void ChangeSessionState(Session* session, XrSessionState state) {
+    session->state = state;
+    XrEventDataSessionStateChanged event{XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED};
+    event.session = ToHandle<XrSession>(session);
+    event.state = state;
+    event.time = CurrentTime(session);
+    session->instance->PushEvent(event);
+}
+
+// Pose of a space in LOCAL space at the given time.
+XrPosef SpacePose(const Space* space, XrTime time) {
+    if (space->isReference) {
+        switch (space->referenceSpaceType) {
+            case XR_REFERENCE_SPACE_TYPE_VIEW:
+                return Multiply(HeadPose(time), space->pose);
+            case XR_REFERENCE_SPACE_TYPE_STAGE:
+            case XR_REFERENCE_SPACE_TYPE_LOCAL_FLOOR:
+                return Multiply(MakePose(0.0f, 0.0f, {0.0f, -StageHeight, 0.0f}), space->pose);
+            default:
+                return space->pose;
+        }
+    }
+    if (space->hand < 0) {
+        // the eye gaze pose is the only pose action without a hand
+        return Multiply(GazePose(time), space->pose);
+    }
+    const bool aim = space->action->name.find("aim") != std::string::npos;
+    return Multiply(HandPose(space->hand, aim, time), space->pose);
+}
+
+XrPosef RelativePose(const Space* space, const Space* baseSpace, XrTime time) {
+    return Multiply(Invert(SpacePose(baseSpace, time)), SpacePose(space, time));
+}
+
+constexpr XrSpaceLocationFlags AllLocationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+                                                  XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+
+//
+// Instance
+//
+
+XrResult XRAPI_CALL Mock_xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
+
+XrResult XRAPI_CALL Mock_xrEnumerateInstanceExtensionProperties(const char* layerName, uint32_t propertyCapacityInput,
+                                                                uint32_t* propertyCountOutput, XrExtensionProperties* properties) {
+    if (layerName != nullptr) {
+        return XR_ERROR_API_LAYER_NOT_PRESENT;
+    }
+    const uint32_t count = (uint32_t)(sizeof(SupportedExtensions) / sizeof(SupportedExtensions[0]));
+    *propertyCountOutput = count;
+    if (propertyCapacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (propertyCapacityInput < count) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        strncpy(properties[i].extensionName, SupportedExtensions[i], XR_MAX_EXTENSION_NAME_SIZE - 1);
+        properties[i].extensionVersion = 1;
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEnumerateApiLayerProperties(uint32_t propertyCapacityInput, uint32_t* propertyCountOutput,
+                                                       XrApiLayerProperties* /*properties*/) {
+    return CopyArray<XrApiLayerProperties>(nullptr, 0, propertyCapacityInput, propertyCountOutput, nullptr);
+}
+
+XrResult XRAPI_CALL Mock_xrInitializeLoaderKHR(const XrLoaderInitInfoBaseHeaderKHR* /*loaderInitInfo*/) { return XR_SUCCESS; }
+
+XrResult XRAPI_CALL Mock_xrCreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance) {
+    for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++) {
+        if (std::none_of(std::begin(SupportedExtensions), std::end(SupportedExtensions),
+                         [&](const char* name) { return strcmp(name, createInfo->enabledExtensionNames[i]) == 0; })) {
+            MOCK_LOG("extension %s is not supported", createInfo->enabledExtensionNames[i]);
+            return XR_ERROR_EXTENSION_NOT_PRESENT;
+        }
+    }
+
+    Instance* object = new Instance();
+    object->freeRunning = IsEnvironmentSet("MOCK_XR_FREE_RUNNING");
+    if (const char* frameCount = getenv("MOCK_XR_FRAME_COUNT")) {
+        object->frameLimit = strtoull(frameCount, nullptr, 10);
+    }
+    MOCK_LOG("instance created for %s, %s, frame limit %llu", createInfo->applicationInfo.applicationName,
+             object->freeRunning ? "free running" : "paced", (unsigned long long)object->frameLimit);
+    *instance = ToHandle<XrInstance>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyInstance(XrInstance instance) {
+    delete FromHandle<Instance>(instance);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrGetInstanceProperties(XrInstance /*instance*/, XrInstanceProperties* instanceProperties) {
+    instanceProperties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+    strncpy(instanceProperties->runtimeName, "Mock Runtime", XR_MAX_RUNTIME_NAME_SIZE - 1);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) {
+    Instance* object = FromHandle<Instance>(instance);
+    std::lock_guard<std::mutex> lock(object->mutex);
+    if (object->events.empty()) {
+        return XR_EVENT_UNAVAILABLE;
+    }
+    *eventData = object->events.front();
+    object->events.pop_front();
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrResultToString(XrInstance /*instance*/, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE]) {
+#define MOCK_ENUM_CASE(name, val) \
+    case name:                    \
+        snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "%s", #name); \
+        return XR_SUCCESS;
+    switch (value) {
+        XR_LIST_ENUM_XrResult(MOCK_ENUM_CASE)
+        default:
+            snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_UNKNOWN_%s_%d", XR_SUCCEEDED(value) ? "SUCCESS" : "FAILURE", (int)value);
+            return XR_SUCCESS;
+    }
+#undef MOCK_ENUM_CASE
+}
+
+XrResult XRAPI_CALL Mock_xrStructureTypeToString(XrInstance /*instance*/, XrStructureType value,
+                                                 char buffer[XR_MAX_STRUCTURE_NAME_SIZE]) {
+#define MOCK_ENUM_CASE(name, val) \
+    case name:                    \
+        snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "%s", #name); \
+        return XR_SUCCESS;
+    switch (value) {
+        XR_LIST_ENUM_XrStructureType(MOCK_ENUM_CASE)
+        default:
+            snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "XR_UNKNOWN_STRUCTURE_TYPE_%d", (int)value);
+            return XR_SUCCESS;
+    }
+#undef MOCK_ENUM_CASE
+}
+
+XrResult XRAPI_CALL Mock_xrStringToPath(XrInstance instance, const char* pathString, XrPath* path) {
+    if (pathString == nullptr || pathString[0] != '/') {
+        return XR_ERROR_PATH_FORMAT_INVALID;
+    }
+    *path = FromHandle<Instance>(instance)->StringToPath(pathString);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrPathToString(XrInstance instance, XrPath path, uint32_t bufferCapacityInput, uint32_t* bufferCountOutput,
+                                        char* buffer) {
+    const std::string string = FromHandle<Instance>(instance)->PathToString(path);
+    if (string.empty()) {
+        return XR_ERROR_PATH_INVALID;
+    }
+    return CopyArray(string.c_str(), (uint32_t)string.size() + 1, bufferCapacityInput, bufferCountOutput, buffer);
+}
+
+XrResult XRAPI_CALL Mock_xrConvertTimespecTimeToTimeKHR(XrInstance /*instance*/, const struct timespec* timespecTime, XrTime* time) {
+    *time = (XrTime)timespecTime->tv_sec * 1000000000 + timespecTime->tv_nsec;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrConvertTimeToTimespecTimeKHR(XrInstance /*instance*/, XrTime time, struct timespec* timespecTime) {
+    timespecTime->tv_sec = time / 1000000000;
+    timespecTime->tv_nsec = time % 1000000000;
+    return XR_SUCCESS;
+}
+
+//
+// System
+//
+
+XrResult XRAPI_CALL Mock_xrGetSystem(XrInstance /*instance*/, const XrSystemGetInfo* getInfo, XrSystemId* systemId) {
+    if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
+        return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+    }
+    *systemId = MockSystemId;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrGetSystemProperties(XrInstance /*instance*/, XrSystemId systemId, XrSystemProperties* properties) {
+    properties->systemId = systemId;
+    properties->vendorId = 0;
+    strncpy(properties->systemName, "Mock HMD", XR_MAX_SYSTEM_NAME_SIZE - 1);
+    properties->graphicsProperties.maxSwapchainImageWidth = 4096;
+    properties->graphicsProperties.maxSwapchainImageHeight = 4096;
+    properties->graphicsProperties.maxLayerCount = XR_MIN_COMPOSITION_LAYERS_SUPPORTED;
+    properties->trackingProperties.orientationTracking = XR_TRUE;
+    properties->trackingProperties.positionTracking = XR_TRUE;
+
+    if (auto eyeGaze = FindNext<XrSystemEyeGazeInteractionPropertiesEXT>(properties->next, XR_TYPE_SYSTEM_EYE_GAZE_INTERACTION_PROPERTIES_EXT)) {
+        eyeGaze->supportsEyeGazeInteraction = XR_TRUE;
+    }
+    if (auto handTracking = FindNext<XrSystemHandTrackingPropertiesEXT>(properties->next, XR_TYPE_SYSTEM_HAND_TRACKING_PROPERTIES_EXT)) {
+        handTracking->supportsHandTracking = XR_TRUE;
+    }
+    if (auto passthrough = FindNext<XrSystemPassthroughPropertiesFB>(properties->next, XR_TYPE_SYSTEM_PASSTHROUGH_PROPERTIES_FB)) {
+        passthrough->supportsPassthrough = XR_TRUE;
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEnumerateViewConfigurations(XrInstance /*instance*/, XrSystemId /*systemId*/, uint32_t capacityInput,
+                                                       uint32_t* countOutput, XrViewConfigurationType* viewConfigurationTypes) {
+    const XrViewConfigurationType types[] = {XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO};
+    return CopyArray(types, 1, capacityInput, countOutput, viewConfigurationTypes);
+}
+
+XrResult XRAPI_CALL Mock_xrGetViewConfigurationProperties(XrInstance /*instance*/, XrSystemId /*systemId*/,
+                                                          XrViewConfigurationType viewConfigurationType,
+                                                          XrViewConfigurationProperties* configurationProperties) {
+    if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    configurationProperties->viewConfigurationType = viewConfigurationType;
+    configurationProperties->fovMutable = XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XrFovf ViewFov() { return {-0.785f, 0.785f, 0.785f, -0.785f}; }
+
+XrResult XRAPI_CALL Mock_xrEnumerateViewConfigurationViews(XrInstance /*instance*/, XrSystemId /*systemId*/,
+                                                           XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput,
+                                                           uint32_t* viewCountOutput, XrViewConfigurationView* views) {
+    if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    *viewCountOutput = ViewCount;
+    if (viewCapacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (viewCapacityInput < ViewCount) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t i = 0; i < ViewCount; i++) {
+        views[i].recommendedImageRectWidth = RecommendedImageSize;
+        views[i].recommendedImageRectHeight = RecommendedImageSize;
+        views[i].maxImageRectWidth = 4096;
+        views[i].maxImageRectHeight = 4096;
+        views[i].recommendedSwapchainSampleCount = 1;
+        views[i].maxSwapchainSampleCount = 4;
+        if (auto fov = FindNext<XrViewConfigurationViewFovEPIC>(views[i].next, XR_TYPE_VIEW_CONFIGURATION_VIEW_FOV_EPIC)) {
+            fov->recommendedFov = ViewFov();
+            fov->maxMutableFov = ViewFov();
+        }
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEnumerateEnvironmentBlendModes(XrInstance /*instance*/, XrSystemId /*systemId*/,
+                                                          XrViewConfigurationType /*viewConfigurationType*/,
+                                                          uint32_t capacityInput, uint32_t* countOutput,
+                                                          XrEnvironmentBlendMode* environmentBlendModes) {
+    const XrEnvironmentBlendMode modes[] = {XR_ENVIRONMENT_BLEND_MODE_OPAQUE};
+    return CopyArray(modes, 1, capacityInput, countOutput, environmentBlendModes);
+}
+
+XrResult XRAPI_CALL Mock_xrGetOpenGLESGraphicsRequirementsKHR(XrInstance /*instance*/, XrSystemId /*systemId*/,
+                                                              XrGraphicsRequirementsOpenGLESKHR* graphicsRequirements) {
+    graphicsRequirements->minApiVersionSupported = XR_MAKE_VERSION(3, 0, 0);
+    graphicsRequirements->maxApiVersionSupported = XR_MAKE_VERSION(3, 2, 0);
+    return XR_SUCCESS;
+}
+
+//
+// Session
+//
+
+XrResult XRAPI_CALL Mock_xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
+    if (createInfo->systemId != MockSystemId) {
+        return XR_ERROR_SYSTEM_INVALID;
+    }
+    Instance* instanceObject = FromHandle<Instance>(instance);
+    if (instanceObject->session != nullptr) {
+        return XR_ERROR_LIMIT_REACHED;
+    }
+    Session* object = new Session();
+    object->instance = instanceObject;
+    object->lastDisplayTime = instanceObject->freeRunning ? FreeRunningEpoch - (XrTime)(1e9 / object->refreshRate) : 0;
+    instanceObject->session = object;
+    *session = ToHandle<XrSession>(object);
+
+    ChangeSessionState(object, XR_SESSION_STATE_IDLE);
+    ChangeSessionState(object, XR_SESSION_STATE_READY);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroySession(XrSession session) {
+    Session* object = FromHandle<Session>(session);
+    object->instance->session = nullptr;
+    delete object;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+    Session* object = FromHandle<Session>(session);
+    if (object->running) {
+        return XR_ERROR_SESSION_RUNNING;
+    }
+    if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    object->running = true;
+    ChangeSessionState(object, XR_SESSION_STATE_SYNCHRONIZED);
+    ChangeSessionState(object, XR_SESSION_STATE_VISIBLE);
+    ChangeSessionState(object, XR_SESSION_STATE_FOCUSED);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrRequestExitSession(XrSession session) {
+    Session* object = FromHandle<Session>(session);
+    if (!object->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (!object->exitRequested) {
+        object->exitRequested = true;
+        ChangeSessionState(object, XR_SESSION_STATE_VISIBLE);
+        ChangeSessionState(object, XR_SESSION_STATE_SYNCHRONIZED);
+        ChangeSessionState(object, XR_SESSION_STATE_STOPPING);
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEndSession(XrSession session) {
+    Session* object = FromHandle<Session>(session);
+    if (!object->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (object->state != XR_SESSION_STATE_STOPPING) {
+        return XR_ERROR_SESSION_NOT_STOPPING;
+    }
+    {
+        // release an xrWaitFrame blocked on the outstanding frame
+        std::lock_guard<std::mutex> lock(object->frameMutex);
+        object->running = false;
+        object->frameWaited = object->frameBegun = false;
+    }
+    object->frameCondition.notify_all();
+    ChangeSessionState(object, XR_SESSION_STATE_IDLE);
+    ChangeSessionState(object, XR_SESSION_STATE_EXITING);
+    MOCK_LOG("session ended after %llu frames", (unsigned long long)object->frameCount);
+    return XR_SUCCESS;
+}
+
+//
+// Frame timing
+//
+
+XrResult XRAPI_CALL Mock_xrWaitFrame(XrSession session, const XrFrameWaitInfo* /*frameWaitInfo*/, XrFrameState* frameState) {
+    Session* object = FromHandle<Session>(session);
+    if (!object->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    std::unique_lock<std::mutex> lock(object->frameMutex);
+    // Throttle like a runtime: a frame returned by xrWaitFrame must be begun before the next one is waited for.
+    object->frameCondition.wait(lock, [object] { return !object->frameWaited || !object->running; });
+    if (!object->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    const XrDuration period = (XrDuration)(1e9 / object->refreshRate);
+    XrTime displayTime = object->lastDisplayTime + period;
+    if (!object->instance->freeRunning) {
+        // pace to the display, a frame that missed its refresh is shown one period from now
+        const XrTime now = NowNanoseconds();
+        if (object->lastDisplayTime == 0 || displayTime < now) {
+            displayTime = now + period;
+        }
+        const XrTime wakeTime = displayTime - period;
+        if (wakeTime > now) {
+            timespec ts{(time_t)((wakeTime - now) / 1000000000), (long)((wakeTime - now) % 1000000000)};
+            nanosleep(&ts, nullptr);
+        }
+    }
+    object->lastDisplayTime = displayTime;
+    object->frameWaited = true;
+
+    frameState->predictedDisplayTime = displayTime;
+    frameState->predictedDisplayPeriod = period;
+    frameState->shouldRender = (object->state == XR_SESSION_STATE_VISIBLE || object->state == XR_SESSION_STATE_FOCUSED) ? XR_TRUE : XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrBeginFrame(XrSession session, const XrFrameBeginInfo* /*frameBeginInfo*/) {
+    Session* object = FromHandle<Session>(session);
+    bool discarded;
+    {
+        std::lock_guard<std::mutex> lock(object->frameMutex);
+        if (!object->running) {
+            return XR_ERROR_SESSION_NOT_RUNNING;
+        }
+        if (!object->frameWaited) {
+            return XR_ERROR_CALL_ORDER_INVALID;
+        }
+        object->frameWaited = false;
+        discarded = object->frameBegun;  // the previous frame was begun but never ended
+        object->frameBegun = true;
+    }
+    object->frameCondition.notify_all();
+    return discarded ? XR_FRAME_DISCARDED : XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) {
+    Session* object = FromHandle<Session>(session);
+    if (!object->running) {
+        return XR_ERROR_SESSION_NOT_RUNNING;
+    }
+    if (frameEndInfo->layerCount > XR_MIN_COMPOSITION_LAYERS_SUPPORTED) {
+        return XR_ERROR_LAYER_LIMIT_EXCEEDED;
+    }
+    for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
+        if (frameEndInfo->layers[i] == nullptr) {
+            return XR_ERROR_LAYER_INVALID;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(object->frameMutex);
+        if (!object->frameBegun) {
+            return XR_ERROR_CALL_ORDER_INVALID;
+        }
+        object->frameBegun = false;
+    }
+
+    object->frameCount++;
+    if (object->instance->frameLimit != 0 && object->frameCount == object->instance->frameLimit) {
+        Mock_xrRequestExitSession(session);
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEnumerateDisplayRefreshRatesFB(XrSession /*session*/, uint32_t capacityInput, uint32_t* countOutput,
+                                                          float* displayRefreshRates) {
+    return CopyArray(DisplayRefreshRates, (uint32_t)(sizeof(DisplayRefreshRates) / sizeof(DisplayRefreshRates[0])), capacityInput,
+                     countOutput, displayRefreshRates);
+}
+
+XrResult XRAPI_CALL Mock_xrGetDisplayRefreshRateFB(XrSession session, float* displayRefreshRate) {
+    *displayRefreshRate = FromHandle<Session>(session)->refreshRate;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrRequestDisplayRefreshRateFB(XrSession session, float displayRefreshRate) {
+    if (std::find(std::begin(DisplayRefreshRates), std::end(DisplayRefreshRates), displayRefreshRate) == std::end(DisplayRefreshRates)) {
+        return XR_ERROR_DISPLAY_REFRESH_RATE_UNSUPPORTED_FB;
+    }
+    Session* object = FromHandle<Session>(session);
+    XrEventDataDisplayRefreshRateChangedFB event{XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB};
+    {
+        std::lock_guard<std::mutex> lock(object->frameMutex);
+        event.fromDisplayRefreshRate = object->refreshRate;
+        event.toDisplayRefreshRate = displayRefreshRate;
+        object->refreshRate = displayRefreshRate;
+    }
+    object->instance->PushEvent(event);
+    return XR_SUCCESS;
+}
+
+//
+// Spaces
+//
+
+XrResult XRAPI_CALL Mock_xrEnumerateReferenceSpaces(XrSession /*session*/, uint32_t spaceCapacityInput, uint32_t* spaceCountOutput,
+                                                    XrReferenceSpaceType* spaces) {
+    const XrReferenceSpaceType types[] = {XR_REFERENCE_SPACE_TYPE_VIEW, XR_REFERENCE_SPACE_TYPE_LOCAL, XR_REFERENCE_SPACE_TYPE_STAGE};
+    return CopyArray(types, 3, spaceCapacityInput, spaceCountOutput, spaces);
+}
+
+XrResult XRAPI_CALL Mock_xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space) {
+    Space* object = new Space();
+    object->session = FromHandle<Session>(session);
+    object->isReference = true;
+    object->referenceSpaceType = createInfo->referenceSpaceType;
+    object->action = nullptr;
+    object->hand = -1;
+    object->pose = createInfo->poseInReferenceSpace;
+    *space = ToHandle<XrSpace>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo* createInfo, XrSpace* space) {
+    Session* sessionObject = FromHandle<Session>(session);
+    Action* action = FromHandle<Action>(createInfo->action);
+    if (action == nullptr || action->type != XR_ACTION_TYPE_POSE_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    const std::string subactionPath = sessionObject->instance->PathToString(createInfo->subactionPath);
+
+    Space* object = new Space();
+    object->session = sessionObject;
+    object->isReference = false;
+    object->referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+    object->action = action;
+    object->hand = subactionPath == "/user/hand/left" ? 0 : (subactionPath == "/user/hand/right" ? 1 : -1);
+    object->pose = createInfo->poseInActionSpace;
+    *space = ToHandle<XrSpace>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroySpace(XrSpace space) {
+    delete FromHandle<Space>(space);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) {
+    if (time <= 0) {
+        return XR_ERROR_TIME_INVALID;
+    }
+    location->pose = RelativePose(FromHandle<Space>(space), FromHandle<Space>(baseSpace), time);
+    location->locationFlags = AllLocationFlags;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrLocateSpaces(XrSession /*session*/, const XrSpacesLocateInfo* locateInfo, XrSpaceLocations* spaceLocations) {
+    if (locateInfo->time <= 0) {
+        return XR_ERROR_TIME_INVALID;
+    }
+    if (spaceLocations->locationCount != locateInfo->spaceCount) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const Space* baseSpace = FromHandle<Space>(locateInfo->baseSpace);
+    for (uint32_t i = 0; i < locateInfo->spaceCount; i++) {
+        spaceLocations->locations[i].pose = RelativePose(FromHandle<Space>(locateInfo->spaces[i]), baseSpace, locateInfo->time);
+        spaceLocations->locations[i].locationFlags = AllLocationFlags;
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrLocateViews(XrSession /*session*/, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState,
+                                       uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views) {
+    if (viewLocateInfo->viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+        return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+    }
+    if (viewLocateInfo->displayTime <= 0) {
+        return XR_ERROR_TIME_INVALID;
+    }
+    *viewCountOutput = ViewCount;
+    if (viewCapacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (viewCapacityInput < ViewCount) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    const XrPosef baseInverse = Invert(SpacePose(FromHandle<Space>(viewLocateInfo->space), viewLocateInfo->displayTime));
+    const XrPosef head = HeadPose(viewLocateInfo->displayTime);
+    for (uint32_t i = 0; i < ViewCount; i++) {
+        const XrPosef eye = MakePose(0.0f, 0.0f, {(i == 0 ? -0.5f : 0.5f) * Ipd, 0.0f, 0.0f});
+        views[i].pose = Multiply(baseInverse, Multiply(head, eye));
+        views[i].fov = ViewFov();
+    }
+    viewState->viewStateFlags = AllLocationFlags;
+    return XR_SUCCESS;
+}
+
+//
+// Swapchains
+//
+
+XrResult XRAPI_CALL Mock_xrEnumerateSwapchainFormats(XrSession /*session*/, uint32_t formatCapacityInput, uint32_t* formatCountOutput,
+                                                     int64_t* formats) {
+    const int64_t supportedFormats[] = {GL_RGBA8, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT16, GL_DEPTH24_STENCIL8};
+    return CopyArray(supportedFormats, (uint32_t)(sizeof(supportedFormats) / sizeof(supportedFormats[0])), formatCapacityInput,
+                     formatCountOutput, formats);
+}
+
+// Images are created in the GL context that is current on the calling thread.
+XrResult XRAPI_CALL Mock_xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain) {
+    if (createInfo->faceCount != 1 || createInfo->arraySize == 0 || createInfo->mipCount == 0) {
+        return XR_ERROR_FEATURE_UNSUPPORTED;
+    }
+    Swapchain* object = new Swapchain();
+    object->session = FromHandle<Session>(session);
+    object->createInfo = *createInfo;
+    object->createInfo.next = nullptr;
+    object->acquireIndex = 0;
+    object->images.resize(SwapchainImageCount);
+
+    // the application context is current, leave its texture binding as it was
+    const GLenum target = createInfo->arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+    GLint previousTexture = 0;
+    glGetIntegerv(target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D, &previousTexture);
+    glGenTextures((GLsizei)object->images.size(), object->images.data());
+    for (GLuint image : object->images) {
+        glBindTexture(target, image);
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            glTexStorage3D(target, createInfo->mipCount, (GLenum)createInfo->format, createInfo->width, createInfo->height,
+                           createInfo->arraySize);
+        } else {
+            glTexStorage2D(target, createInfo->mipCount, (GLenum)createInfo->format, createInfo->width, createInfo->height);
+        }
+    }
+    glBindTexture(target, (GLuint)previousTexture);
+    if (glGetError() != GL_NO_ERROR) {
+        glDeleteTextures((GLsizei)object->images.size(), object->images.data());
+        delete object;
+        return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+    }
+    *swapchain = ToHandle<XrSwapchain>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroySwapchain(XrSwapchain swapchain) {
+    Swapchain* object = FromHandle<Swapchain>(swapchain);
+    glDeleteTextures((GLsizei)object->images.size(), object->images.data());
+    delete object;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput,
+                                                    XrSwapchainImageBaseHeader* images) {
+    const Swapchain* object = FromHandle<Swapchain>(swapchain);
+    *imageCountOutput = (uint32_t)object->images.size();
+    if (imageCapacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (imageCapacityInput < object->images.size()) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    XrSwapchainImageOpenGLESKHR* glImages = reinterpret_cast<XrSwapchainImageOpenGLESKHR*>(images);
+    for (size_t i = 0; i < object->images.size(); i++) {
+        glImages[i].image = object->images[i];
+    }
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* /*acquireInfo*/,
+                                                 uint32_t* index) {
+    Swapchain* object = FromHandle<Swapchain>(swapchain);
+    *index = object->acquireIndex;
+    object->acquireIndex = (object->acquireIndex + 1) % object->images.size();
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrWaitSwapchainImage(XrSwapchain /*swapchain*/, const XrSwapchainImageWaitInfo* /*waitInfo*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrReleaseSwapchainImage(XrSwapchain /*swapchain*/, const XrSwapchainImageReleaseInfo* /*releaseInfo*/) {
+    return XR_SUCCESS;
+}
+
+//
+// Actions. Every action is active; buttons, triggers and thumbsticks rest at zero.
+//
+
+XrResult XRAPI_CALL Mock_xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet) {
+    ActionSet* object = new ActionSet();
+    object->instance = FromHandle<Instance>(instance);
+    object->name = createInfo->actionSetName;
+    *actionSet = ToHandle<XrActionSet>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyActionSet(XrActionSet actionSet) {
+    delete FromHandle<ActionSet>(actionSet);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action) {
+    Action* object = new Action();
+    object->actionSet = FromHandle<ActionSet>(actionSet);
+    object->name = createInfo->actionName;
+    object->type = createInfo->actionType;
+    *action = ToHandle<XrAction>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyAction(XrAction action) {
+    delete FromHandle<Action>(action);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrSuggestInteractionProfileBindings(XrInstance /*instance*/,
+                                                             const XrInteractionProfileSuggestedBinding* /*suggestedBindings*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrAttachSessionActionSets(XrSession /*session*/, const XrSessionActionSetsAttachInfo* /*attachInfo*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrGetCurrentInteractionProfile(XrSession /*session*/, XrPath /*topLevelUserPath*/,
+                                                        XrInteractionProfileState* interactionProfile) {
+    interactionProfile->interactionProfile = XR_NULL_PATH;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrSyncActions(XrSession session, const XrActionsSyncInfo* /*syncInfo*/) {
+    return FromHandle<Session>(session)->state == XR_SESSION_STATE_FOCUSED ? XR_SUCCESS : XR_SESSION_NOT_FOCUSED;
+}
+
+XrResult XRAPI_CALL Mock_xrGetActionStateBoolean(XrSession /*session*/, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* state) {
+    if (FromHandle<Action>(getInfo->action)->type != XR_ACTION_TYPE_BOOLEAN_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->currentState = XR_FALSE;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrGetActionStateFloat(XrSession /*session*/, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state) {
+    if (FromHandle<Action>(getInfo->action)->type != XR_ACTION_TYPE_FLOAT_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->currentState = 0.0f;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrGetActionStateVector2f(XrSession /*session*/, const XrActionStateGetInfo* getInfo,
+                                                  XrActionStateVector2f* state) {
+    if (FromHandle<Action>(getInfo->action)->type != XR_ACTION_TYPE_VECTOR2F_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->currentState = {0.0f, 0.0f};
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrGetActionStatePose(XrSession /*session*/, const XrActionStateGetInfo* getInfo, XrActionStatePose* state) {
+    if (FromHandle<Action>(getInfo->action)->type != XR_ACTION_TYPE_POSE_INPUT) {
+        return XR_ERROR_ACTION_TYPE_MISMATCH;
+    }
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrEnumerateBoundSourcesForAction(XrSession /*session*/, const XrBoundSourcesForActionEnumerateInfo* /*enumerateInfo*/,
+                                                          uint32_t sourceCapacityInput, uint32_t* sourceCountOutput, XrPath* sources) {
+    return CopyArray<XrPath>(nullptr, 0, sourceCapacityInput, sourceCountOutput, sources);
+}
+
+XrResult XRAPI_CALL Mock_xrGetInputSourceLocalizedName(XrSession /*session*/, const XrInputSourceLocalizedNameGetInfo* /*getInfo*/,
+                                                       uint32_t bufferCapacityInput, uint32_t* bufferCountOutput, char* buffer) {
+    return CopyArray("", 1, bufferCapacityInput, bufferCountOutput, buffer);
+}
+
+XrResult XRAPI_CALL Mock_xrApplyHapticFeedback(XrSession /*session*/, const XrHapticActionInfo* /*hapticActionInfo*/,
+                                               const XrHapticBaseHeader* /*hapticFeedback*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrStopHapticFeedback(XrSession /*session*/, const XrHapticActionInfo* /*hapticActionInfo*/) { return XR_SUCCESS; }
+
+//
+// XR_EXT_hand_tracking. The joints lie along the grip pose of the hand, 1 cm apart.
+//
+
+XrResult XRAPI_CALL Mock_xrCreateHandTrackerEXT(XrSession session, const XrHandTrackerCreateInfoEXT* createInfo,
+                                                XrHandTrackerEXT* handTracker) {
+    HandTracker* object = new HandTracker();
+    object->session = FromHandle<Session>(session);
+    object->hand = createInfo->hand;
+    *handTracker = ToHandle<XrHandTrackerEXT>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyHandTrackerEXT(XrHandTrackerEXT handTracker) {
+    delete FromHandle<HandTracker>(handTracker);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrLocateHandJointsEXT(XrHandTrackerEXT handTracker, const XrHandJointsLocateInfoEXT* locateInfo,
+                                               XrHandJointLocationsEXT* locations) {
+    if (locateInfo->time <= 0) {
+        return XR_ERROR_TIME_INVALID;
+    }
+    const HandTracker* object = FromHandle<HandTracker>(handTracker);
+    const XrPosef baseInverse = Invert(SpacePose(FromHandle<Space>(locateInfo->baseSpace), locateInfo->time));
+    const XrPosef hand = HandPose(object->hand == XR_HAND_LEFT_EXT ? 0 : 1, false, locateInfo->time);
+    for (uint32_t i = 0; i < locations->jointCount; i++) {
+        const XrPosef joint = MakePose(0.0f, 0.0f, {0.0f, 0.0f, -0.01f * i});
+        locations->jointLocations[i].pose = Multiply(baseInverse, Multiply(hand, joint));
+        locations->jointLocations[i].radius = 0.008f;
+        locations->jointLocations[i].locationFlags = AllLocationFlags;
+    }
+    locations->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+//
+// XR_FB_passthrough and XR_FB_triangle_mesh, nothing is composited.
+//
+
+template <typename Handle>
+XrResult CreatePlaceholder(XrSession session, Handle* handle) {
+    Placeholder* object = new Placeholder();
+    object->session = FromHandle<Session>(session);
+    *handle = ToHandle<Handle>(object);
+    return XR_SUCCESS;
+}
+
+template <typename Handle>
+XrResult DestroyPlaceholder(Handle handle) {
+    delete FromHandle<Placeholder>(handle);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrCreatePassthroughFB(XrSession session, const XrPassthroughCreateInfoFB* /*createInfo*/,
+                                               XrPassthroughFB* passthrough) {
+    return CreatePlaceholder(session, passthrough);
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyPassthroughFB(XrPassthroughFB passthrough) { return DestroyPlaceholder(passthrough); }
+
+XrResult XRAPI_CALL Mock_xrPassthroughStartFB(XrPassthroughFB /*passthrough*/) { return XR_SUCCESS; }
+
+XrResult XRAPI_CALL Mock_xrPassthroughPauseFB(XrPassthroughFB /*passthrough*/) { return XR_SUCCESS; }
+
+XrResult XRAPI_CALL Mock_xrCreatePassthroughLayerFB(XrSession session, const XrPassthroughLayerCreateInfoFB* /*createInfo*/,
+                                                    XrPassthroughLayerFB* layer) {
+    return CreatePlaceholder(session, layer);
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyPassthroughLayerFB(XrPassthroughLayerFB layer) { return DestroyPlaceholder(layer); }
+
+XrResult XRAPI_CALL Mock_xrPassthroughLayerPauseFB(XrPassthroughLayerFB /*layer*/) { return XR_SUCCESS; }
+
+XrResult XRAPI_CALL Mock_xrPassthroughLayerResumeFB(XrPassthroughLayerFB /*layer*/) { return XR_SUCCESS; }
+
+XrResult XRAPI_CALL Mock_xrPassthroughLayerSetStyleFB(XrPassthroughLayerFB /*layer*/, const XrPassthroughStyleFB* /*style*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrCreateGeometryInstanceFB(XrSession session, const XrGeometryInstanceCreateInfoFB* /*createInfo*/,
+                                                    XrGeometryInstanceFB* outGeometryInstance) {
+    return CreatePlaceholder(session, outGeometryInstance);
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyGeometryInstanceFB(XrGeometryInstanceFB instance) { return DestroyPlaceholder(instance); }
+
+XrResult XRAPI_CALL Mock_xrGeometryInstanceSetTransformFB(XrGeometryInstanceFB /*instance*/,
+                                                          const XrGeometryInstanceTransformFB* /*transformation*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrCreateTriangleMeshFB(XrSession /*session*/, const XrTriangleMeshCreateInfoFB* createInfo,
+                                                XrTriangleMeshFB* outTriangleMesh) {
+    TriangleMesh* object = new TriangleMesh();
+    object->vertices.resize(createInfo->vertexCount);
+    object->indices.resize(createInfo->triangleCount * 3);
+    if (createInfo->vertexBuffer != nullptr) {
+        std::copy(createInfo->vertexBuffer, createInfo->vertexBuffer + createInfo->vertexCount, object->vertices.begin());
+    }
+    if (createInfo->indexBuffer != nullptr) {
+        std::copy(createInfo->indexBuffer, createInfo->indexBuffer + createInfo->triangleCount * 3, object->indices.begin());
+    }
+    *outTriangleMesh = ToHandle<XrTriangleMeshFB>(object);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrDestroyTriangleMeshFB(XrTriangleMeshFB mesh) {
+    delete FromHandle<TriangleMesh>(mesh);
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrTriangleMeshGetVertexBufferFB(XrTriangleMeshFB mesh, XrVector3f** outVertexBuffer) {
+    *outVertexBuffer = FromHandle<TriangleMesh>(mesh)->vertices.data();
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrTriangleMeshGetIndexBufferFB(XrTriangleMeshFB mesh, uint32_t** outIndexBuffer) {
+    *outIndexBuffer = FromHandle<TriangleMesh>(mesh)->indices.data();
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrTriangleMeshBeginUpdateFB(XrTriangleMeshFB /*mesh*/) { return XR_SUCCESS; }
+
+XrResult XRAPI_CALL Mock_xrTriangleMeshEndUpdateFB(XrTriangleMeshFB /*mesh*/, uint32_t /*vertexCount*/, uint32_t /*triangleCount*/) {
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrTriangleMeshBeginVertexBufferUpdateFB(XrTriangleMeshFB mesh, uint32_t* outVertexCount) {
+    *outVertexCount = (uint32_t)FromHandle<TriangleMesh>(mesh)->vertices.size();
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Mock_xrTriangleMeshEndVertexBufferUpdateFB(XrTriangleMeshFB /*mesh*/) { return XR_SUCCESS; }
+
+//
+// Dispatch
+//
+
+// clang-format off
+#define MOCK_LIST_FUNCTIONS(_)                       \
+    _(xrGetInstanceProcAddr)                         \
+    _(xrEnumerateInstanceExtensionProperties)        \
+    _(xrEnumerateApiLayerProperties)                 \
+    _(xrInitializeLoaderKHR)                         \
+    _(xrCreateInstance)                              \
+    _(xrDestroyInstance)                             \
+    _(xrGetInstanceProperties)                       \
+    _(xrPollEvent)                                   \
+    _(xrResultToString)                              \
+    _(xrStructureTypeToString)                       \
+    _(xrStringToPath)                                \
+    _(xrPathToString)                                \
+    _(xrConvertTimespecTimeToTimeKHR)                \
+    _(xrConvertTimeToTimespecTimeKHR)                \
+    _(xrGetSystem)                                   \
+    _(xrGetSystemProperties)                         \
+    _(xrEnumerateViewConfigurations)                 \
+    _(xrGetViewConfigurationProperties)              \
+    _(xrEnumerateViewConfigurationViews)             \
+    _(xrEnumerateEnvironmentBlendModes)              \
+    _(xrGetOpenGLESGraphicsRequirementsKHR)          \
+    _(xrCreateSession)                               \
+    _(xrDestroySession)                              \
+    _(xrBeginSession)                                \
+    _(xrEndSession)                                  \
+    _(xrRequestExitSession)                          \
+    _(xrWaitFrame)                                   \
+    _(xrBeginFrame)                                  \
+    _(xrEndFrame)                                    \
+    _(xrEnumerateDisplayRefreshRatesFB)              \
+    _(xrGetDisplayRefreshRateFB)                     \
+    _(xrRequestDisplayRefreshRateFB)                 \
+    _(xrEnumerateReferenceSpaces)                    \
+    _(xrCreateReferenceSpace)                        \
+    _(xrCreateActionSpace)                           \
+    _(xrDestroySpace)                                \
+    _(xrLocateSpace)                                 \
+    _(xrLocateSpaces)                                \
+    _(xrLocateViews)                                 \
+    _(xrEnumerateSwapchainFormats)                   \
+    _(xrCreateSwapchain)                             \
+    _(xrDestroySwapchain)                            \
+    _(xrEnumerateSwapchainImages)                    \
+    _(xrAcquireSwapchainImage)                       \
+    _(xrWaitSwapchainImage)                          \
+    _(xrReleaseSwapchainImage)                       \
+    _(xrCreateActionSet)                             \
+    _(xrDestroyActionSet)                            \
+    _(xrCreateAction)                                \
+    _(xrDestroyAction)                               \
+    _(xrSuggestInteractionProfileBindings)           \
+    _(xrAttachSessionActionSets)                     \
+    _(xrGetCurrentInteractionProfile)                \
+    _(xrSyncActions)                                 \
+    _(xrGetActionStateBoolean)                       \
+    _(xrGetActionStateFloat)                         \
+    _(xrGetActionStateVector2f)                      \
+    _(xrGetActionStatePose)                          \
+    _(xrEnumerateBoundSourcesForAction)              \
+    _(xrGetInputSourceLocalizedName)                 \
+    _(xrApplyHapticFeedback)                         \
+    _(xrStopHapticFeedback)                          \
+    _(xrCreateHandTrackerEXT)                        \
+    _(xrDestroyHandTrackerEXT)                       \
+    _(xrLocateHandJointsEXT)                         \
+    _(xrCreatePassthroughFB)                         \
+    _(xrDestroyPassthroughFB)                        \
+    _(xrPassthroughStartFB)                          \
+    _(xrPassthroughPauseFB)                          \
+    _(xrCreatePassthroughLayerFB)                    \
+    _(xrDestroyPassthroughLayerFB)                   \
+    _(xrPassthroughLayerPauseFB)                     \
+    _(xrPassthroughLayerResumeFB)                    \
+    _(xrPassthroughLayerSetStyleFB)                  \
+    _(xrCreateGeometryInstanceFB)                    \
+    _(xrDestroyGeometryInstanceFB)                   \
+    _(xrGeometryInstanceSetTransformFB)              \
+    _(xrCreateTriangleMeshFB)                        \
+    _(xrDestroyTriangleMeshFB)                       \
+    _(xrTriangleMeshGetVertexBufferFB)               \
+    _(xrTriangleMeshGetIndexBufferFB)                \
+    _(xrTriangleMeshBeginUpdateFB)                   \
+    _(xrTriangleMeshEndUpdateFB)                     \
+    _(xrTriangleMeshBeginVertexBufferUpdateFB)       \
+    _(xrTriangleMeshEndVertexBufferUpdateFB)
+// clang-format on
+
+XrResult XRAPI_CALL Mock_xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+    *function = nullptr;
+#define MOCK_FUNCTION_ENTRY(fn)                                        \
+    if (strcmp(name, #fn) == 0) {                                      \
+        *function = reinterpret_cast<PFN_xrVoidFunction>(Mock_##fn);   \
+    }
+    MOCK_LIST_FUNCTIONS(MOCK_FUNCTION_ENTRY)
+#undef MOCK_FUNCTION_ENTRY
+    // the KHR entry point of XR_KHR_locate_spaces is the core 1.1 function
+    if (strcmp(name, "xrLocateSpacesKHR") == 0) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrLocateSpaces);
+    }
+    if (*function == nullptr) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    if (instance == XR_NULL_HANDLE && strcmp(name, "xrEnumerateInstanceExtensionProperties") != 0 &&
+        strcmp(name, "xrEnumerateApiLayerProperties") != 0 && strcmp(name, "xrCreateInstance") != 0 &&
+        strcmp(name, "xrInitializeLoaderKHR") != 0 && strcmp(name, "xrGetInstanceProcAddr") != 0) {
+        *function = nullptr;
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    return XR_SUCCESS;
+}
+
+}  // namespace
+
+extern "C" __attribute__((visibility("default"))) XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(
+    const XrNegotiateLoaderInfo* loaderInfo, XrNegotiateRuntimeRequest* runtimeRequest) {
+    if (loaderInfo == nullptr || loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+        runtimeRequest == nullptr || runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    if (loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+        loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+    runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+    runtimeRequest->getInstanceProcAddr = Mock_xrGetInstanceProcAddr;
+    return XR_SUCCESS;
+}
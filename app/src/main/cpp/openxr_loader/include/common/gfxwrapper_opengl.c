@@ -154,10 +154,10 @@ The CPU and GPU times for the recorded frames will be listed at the end of the l
 
 ksFrameLog
 
-static void ksFrameLog_Open( const char * fileName, const int frameCount );
-static void ksFrameLog_Write( const char * fileName, const int lineNumber, const char * function );
-static void ksFrameLog_BeginFrame();
-static void ksFrameLog_EndFrame( const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds, const int
+void ksFrameLog_Open( const char * fileName, const int frameCount );
+void ksFrameLog_Write( const char * fileName, const int lineNumber, const char * function );
+void ksFrameLog_BeginFrame();
+void ksFrameLog_EndFrame( const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds, const int
 gpuTimeFramesDelayed );
 
 ================================================================================================================================
@@ -183,7 +183,7 @@ static ksFrameLog *ksFrameLog_Get() {
     return l;
 }
 
-static void ksFrameLog_Open(const char *fileName, const int frameCount) {
+void ksFrameLog_Open(const char *fileName, const int frameCount) {
     ksFrameLog *l = ksFrameLog_Get();
     if (l != NULL && l->fp == NULL) {
         l->fp = fopen(fileName, "wb");
@@ -201,7 +201,7 @@ static void ksFrameLog_Open(const char *fileName, const int frameCount) {
     }
 }
 
-static void ksFrameLog_Write(const char *fileName, const int lineNumber, const char *function) {
+void ksFrameLog_Write(const char *fileName, const int lineNumber, const char *function) {
     ksFrameLog *l = ksFrameLog_Get();
     if (l != NULL && l->fp != NULL) {
         if (l->frame < l->frameCount) {
@@ -210,7 +210,7 @@ static void ksFrameLog_Write(const char *fileName, const int lineNumber, const c
     }
 }
 
-static void ksFrameLog_BeginFrame() {
+void ksFrameLog_BeginFrame() {
     ksFrameLog *l = ksFrameLog_Get();
     if (l != NULL && l->fp != NULL) {
         if (l->frame < l->frameCount) {
@@ -221,8 +221,8 @@ static void ksFrameLog_BeginFrame() {
     }
 }
 
-static void ksFrameLog_EndFrame(const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds,
-                                const int gpuTimeFramesDelayed) {
+void ksFrameLog_EndFrame(const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds,
+                         const int gpuTimeFramesDelayed) {
     ksFrameLog *l = ksFrameLog_Get();
     if (l != NULL && l->fp != NULL) {
         if (l->frame < l->frameCount) {
@@ -282,7 +282,7 @@ OpenGL error checking.
     }
 #endif
 
-#if defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#if defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
 static const char *EglErrorString(const EGLint error) {
     switch (error) {
         case EGL_SUCCESS:
@@ -335,7 +335,7 @@ static const char *GlErrorString(GLenum error) {
             return "GL_INVALID_FRAMEBUFFER_OPERATION";
         case GL_OUT_OF_MEMORY:
             return "GL_OUT_OF_MEMORY";
-#if !defined(OS_APPLE_MACOS) && !defined(OS_ANDROID) && !defined(OS_APPLE_IOS)
+#if !defined(OS_APPLE_MACOS) && !defined(OS_ANDROID) && !defined(OS_APPLE_IOS) && !defined(OS_LINUX_EGL)
         case GL_STACK_UNDERFLOW:
             return "GL_STACK_UNDERFLOW";
         case GL_STACK_OVERFLOW:
@@ -358,7 +358,7 @@ static const char *GlFramebufferStatusString(GLenum status) {
             return "GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT";
         case GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE:
             return "GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE";
-#if !defined(OS_ANDROID) && !defined(OS_APPLE_IOS)
+#if !defined(OS_ANDROID) && !defined(OS_APPLE_IOS) && !defined(OS_LINUX_EGL)
         case GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER:
             return "GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER";
         case GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER:
@@ -415,7 +415,7 @@ PROC GetExtension(const char *functionName) { return wglGetProcAddress(functionN
 void (*GetExtension(const char *functionName))() { return NULL; }
 #elif defined(OS_LINUX_XCB) || defined(OS_LINUX_XLIB) || defined(OS_LINUX_XCB_GLX)
 void (*GetExtension(const char *functionName))() { return glXGetProcAddress((const GLubyte *)functionName); }
-#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
 void (*GetExtension(const char *functionName))() { return eglGetProcAddress(functionName); }
 #endif
 
@@ -426,7 +426,7 @@ GLint glGetInteger(GLenum pname) {
 }
 
 static bool GlCheckExtension(const char *extension) {
-#if defined(OS_WINDOWS) || defined(OS_LINUX)
+#if defined(OS_WINDOWS) || (defined(OS_LINUX) && !defined(OS_LINUX_EGL))
     PFNGLGETSTRINGIPROC glGetStringi = (PFNGLGETSTRINGIPROC)GetExtension("glGetStringi");
 #endif
     GL(const GLint numExtensions = glGetInteger(GL_NUM_EXTENSIONS));
@@ -439,7 +439,7 @@ static bool GlCheckExtension(const char *extension) {
     return false;
 }
 
-#if defined(OS_WINDOWS) || defined(OS_LINUX)
+#if defined(OS_WINDOWS) || (defined(OS_LINUX) && !defined(OS_LINUX_EGL))
 
 PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
 PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
@@ -756,7 +756,7 @@ void GlInitExtensions() {
     glExtensions.texture_clamp_to_border_id = GL_CLAMP_TO_BORDER;
 }
 
-#elif defined(OS_ANDROID)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_EGL)
 
 // GL_EXT_disjoint_timer_query without _EXT
 #if !defined(GL_TIMESTAMP)
@@ -1521,11 +1521,12 @@ static bool ksGpuContext_CreateForSurface(ksGpuContext *context, const ksGpuDevi
     return true;
 }
 
-#elif defined(OS_ANDROID)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_EGL)
 
+// The config supports at least the surfaceType bits.
 static bool ksGpuContext_CreateForSurface(ksGpuContext *context, const ksGpuDevice *device, const int queueIndex,
                                           const ksGpuSurfaceColorFormat colorFormat, const ksGpuSurfaceDepthFormat depthFormat,
-                                          const ksGpuSampleCount sampleCount, EGLDisplay display) {
+                                          const ksGpuSampleCount sampleCount, EGLDisplay display, const EGLint surfaceType) {
     context->device = device;
 
     context->display = display;
@@ -1555,9 +1556,9 @@ static bool ksGpuContext_CreateForSurface(ksGpuContext *context, const ksGpuDevi
             continue;
         }
 
-        // Without EGL_KHR_surfaceless_context, the config needs to support both pbuffers and window surfaces.
+        // Without EGL_KHR_surfaceless_context, the config needs to support pbuffers for the tiny surface.
         eglGetConfigAttrib(display, configs[i], EGL_SURFACE_TYPE, &value);
-        if ((value & (EGL_WINDOW_BIT | EGL_PBUFFER_BIT)) != (EGL_WINDOW_BIT | EGL_PBUFFER_BIT)) {
+        if ((value & surfaceType) != surfaceType) {
             continue;
         }
 
@@ -1604,6 +1605,51 @@ static bool ksGpuContext_CreateForSurface(ksGpuContext *context, const ksGpuDevi
     return true;
 }
 
+bool ksGpuContext_CreateSurfaceless(ksGpuContext *context, const ksGpuDevice *device, const int queueIndex,
+                                    const ksGpuSurfaceColorFormat colorFormat, const ksGpuSurfaceDepthFormat depthFormat,
+                                    const ksGpuSampleCount sampleCount) {
+    memset(context, 0, sizeof(ksGpuContext));
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+#if defined(OS_LINUX_EGL) && defined(EGL_PLATFORM_SURFACELESS_MESA)
+    // Without a window system the default display may still try to connect to X11 or Wayland.
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (clientExtensions != NULL && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != NULL &&
+        eglGetPlatformDisplayEXT != NULL) {
+        display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+#endif
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint majorVersion = 0;
+    EGLint minorVersion = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &majorVersion, &minorVersion)) {
+        Error("eglInitialize() failed: %s", EglErrorString(eglGetError()));
+        return false;
+    }
+
+    if (!ksGpuContext_CreateForSurface(context, device, queueIndex, colorFormat, depthFormat, sampleCount, display,
+                                       EGL_PBUFFER_BIT)) {
+        return false;
+    }
+
+    // Nothing is ever presented from this context, so skip the tiny surface when the display allows it.
+    const char *displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (displayExtensions != NULL && strstr(displayExtensions, "EGL_KHR_surfaceless_context") != NULL) {
+        EGL(eglDestroySurface(display, context->tinySurface));
+        context->tinySurface = EGL_NO_SURFACE;
+        context->mainSurface = EGL_NO_SURFACE;
+    }
+    ksGpuContext_SetCurrent(context);
+
+    GlInitExtensions();
+
+    return true;
+}
+
 #endif
 
 bool ksGpuContext_CreateShared(ksGpuContext *context, const ksGpuContext *other, int queueIndex) {
@@ -1652,7 +1698,7 @@ bool ksGpuContext_CreateShared(ksGpuContext *context, const ksGpuContext *other,
     if (CGLSetSurface(context->cglContext, cid, wid, sid) != kCGLNoError) {
         return false;
     }
-#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
     context->display = other->display;
     EGLint configID;
     if (!eglQueryContext(context->display, other->context, EGL_CONFIG_ID, &configID)) {
@@ -1679,7 +1725,7 @@ bool ksGpuContext_CreateShared(ksGpuContext *context, const ksGpuContext *other,
     EGLint surfaceType = 0;
     eglGetConfigAttrib(context->display, context->config, EGL_SURFACE_TYPE, &surfaceType);
 
-#if defined(OS_ANDROID)
+#if defined(OS_ANDROID) || defined(OS_LINUX_EGL)
     if ((surfaceType & EGL_PBUFFER_BIT) == 0) {
         Error("Share context config does have EGL_PBUFFER_BIT.");
         return false;
@@ -1691,7 +1737,7 @@ bool ksGpuContext_CreateShared(ksGpuContext *context, const ksGpuContext *other,
         Error("eglCreateContext() failed: %s", EglErrorString(eglGetError()));
         return false;
     }
-#if defined(OS_ANDROID)
+#if defined(OS_ANDROID) || defined(OS_LINUX_EGL)
     const EGLint surfaceAttribs[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
     context->tinySurface = eglCreatePbufferSurface(context->display, context->config, surfaceAttribs);
     if (context->tinySurface == EGL_NO_SURFACE) {
@@ -1747,7 +1793,7 @@ void ksGpuContext_Destroy(ksGpuContext *context) {
         CGLDestroyContext(context->cglContext);
     }
     context->cglContext = nil;
-#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
     if (context->display != 0) {
         EGL(eglMakeCurrent(context->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT));
     }
@@ -1755,7 +1801,7 @@ void ksGpuContext_Destroy(ksGpuContext *context) {
         EGL(eglDestroyContext(context->display, context->context));
     }
 
-#if defined(OS_ANDROID)
+#if defined(OS_ANDROID) || defined(OS_LINUX_EGL)
     if (context->mainSurface != context->tinySurface) {
         EGL(eglDestroySurface(context->display, context->mainSurface));
     }
@@ -1801,7 +1847,7 @@ void ksGpuContext_SetCurrent(ksGpuContext *context) {
     free(glx_make_current_reply);
 #elif defined(OS_APPLE_MACOS)
     CGLSetCurrentContext(context->cglContext);
-#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
     EGL(eglMakeCurrent(context->display, context->mainSurface, context->mainSurface, context->context));
 #endif
 }
@@ -1815,7 +1861,7 @@ void ksGpuContext_UnsetCurrent(ksGpuContext *context) {
     xcb_glx_make_current(context->connection, 0, 0, 0);
 #elif defined(OS_APPLE_MACOS)
     CGLSetCurrentContext(NULL);
-#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
     EGL(eglMakeCurrent(context->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT));
 #endif
 }
@@ -1831,7 +1877,7 @@ bool ksGpuContext_CheckCurrent(ksGpuContext *context) {
     return (CGLGetCurrentContext() == context->cglContext);
 #elif defined(OS_APPLE_IOS)
     return (false);  // TODO: pick current context off the UIView
-#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_WAYLAND) || defined(OS_LINUX_EGL)
     return (eglGetCurrentContext() == context->context);
 #endif
 }
@@ -4227,7 +4273,7 @@ bool ksGpuWindow_Create(ksGpuWindow *window, ksDriverInstance *instance, const k
 
     ksGpuDevice_Create(&window->device, instance, queueInfo);
     ksGpuContext_CreateForSurface(&window->context, &window->device, queueIndex, colorFormat, depthFormat, sampleCount,
-                                  window->display);
+                                  window->display, EGL_WINDOW_BIT | EGL_PBUFFER_BIT);
     ksGpuContext_SetCurrent(&window->context);
 
     GlInitExtensions();
@@ -4312,6 +4358,66 @@ ksGpuWindowEvent ksGpuWindow_ProcessEvents(ksGpuWindow *window) {
     return KS_GPU_WINDOW_EVENT_NONE;
 }
 
+#elif defined(OS_LINUX_EGL)
+
+// There is no window system, the window is a surfaceless context that never presents.
+
+typedef enum { KEY_ESCAPE = 0x1B } ksKeyboardKey;
+
+typedef enum { MOUSE_LEFT = 0, MOUSE_RIGHT = 1 } ksMouseButton;
+
+void ksGpuWindow_Destroy(ksGpuWindow *window) {
+    const EGLDisplay display = window->context.display;
+
+    ksGpuContext_Destroy(&window->context);
+    ksGpuDevice_Destroy(&window->device);
+
+    if (display != 0) {
+        EGL(eglTerminate(display));
+    }
+}
+
+bool ksGpuWindow_Create(ksGpuWindow *window, ksDriverInstance *instance, const ksGpuQueueInfo *queueInfo, const int queueIndex,
+                        const ksGpuSurfaceColorFormat colorFormat, const ksGpuSurfaceDepthFormat depthFormat,
+                        const ksGpuSampleCount sampleCount, const int width, const int height, const bool fullscreen) {
+    UNUSED_PARM(fullscreen);
+
+    memset(window, 0, sizeof(ksGpuWindow));
+
+    window->colorFormat = colorFormat;
+    window->depthFormat = depthFormat;
+    window->sampleCount = sampleCount;
+    window->windowWidth = width;
+    window->windowHeight = height;
+    window->windowSwapInterval = 1;
+    window->windowRefreshRate = 60.0f;
+    window->windowFullscreen = false;
+    window->windowActive = true;
+    window->windowExit = false;
+    window->lastSwapTime = GetTimeNanoseconds();
+
+    ksGpuDevice_Create(&window->device, instance, queueInfo);
+    if (!ksGpuContext_CreateSurfaceless(&window->context, &window->device, queueIndex, colorFormat, depthFormat, sampleCount)) {
+        ksGpuDevice_Destroy(&window->device);
+        return false;
+    }
+
+    return true;
+}
+
+static bool ksGpuWindow_SupportedResolution(const int width, const int height) {
+    UNUSED_PARM(width);
+    UNUSED_PARM(height);
+
+    return true;
+}
+
+void ksGpuWindow_Exit(ksGpuWindow *window) { window->windowExit = true; }
+
+ksGpuWindowEvent ksGpuWindow_ProcessEvents(ksGpuWindow *window) {
+    return window->windowExit ? KS_GPU_WINDOW_EVENT_EXIT : KS_GPU_WINDOW_EVENT_NONE;
+}
+
 #endif
 
 void ksGpuWindow_SwapInterval(ksGpuWindow *window, int swapInterval) {
@@ -4447,3 +4553,24 @@ ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer) {
         return 0;
     }
 }
+
+void ksGpuTimer_Begin(ksGpuTimer *timer) {
+    if (glExtensions.timer_query) {
+        const int index = timer->queryIndex % KS_GPU_TIMER_FRAMES_DELAYED;
+        if (timer->queryIndex >= KS_GPU_TIMER_FRAMES_DELAYED) {
+            GLuint64 beginGpuTime = 0;
+            GL(glGetQueryObjectui64v(timer->beginQueries[index], GL_QUERY_RESULT, &beginGpuTime));
+            GLuint64 endGpuTime = 0;
+            GL(glGetQueryObjectui64v(timer->endQueries[index], GL_QUERY_RESULT, &endGpuTime));
+            timer->gpuTime = (endGpuTime - beginGpuTime);
+        }
+        GL(glQueryCounter(timer->beginQueries[index], GL_TIMESTAMP));
+    }
+}
+
+void ksGpuTimer_End(ksGpuTimer *timer) {
+    if (glExtensions.timer_query) {
+        GL(glQueryCounter(timer->endQueries[timer->queryIndex % KS_GPU_TIMER_FRAMES_DELAYED], GL_TIMESTAMP));
+        timer->queryIndex++;
+    }
+}
@@ -185,6 +185,40 @@ Platform headers / declarations
 
 #define __thread __declspec(thread)
 
+#elif defined(OS_LINUX_EGL)
+#define XR_USE_PLATFORM_EGL 1
+
+// Headless Linux host: OpenGL ES through EGL without a window system, e.g. Mesa llvmpipe on a pbuffer or
+// surfaceless display. Built with -DOS_LINUX_EGL.
+#define OPENGL_VERSION_MAJOR 3
+#define OPENGL_VERSION_MINOR 2
+#define GLSL_VERSION "320 es"
+#define SPIRV_VERSION "99"
+#define USE_SYNC_OBJECT 1  // 0 = GLsync, 1 = EGLSyncKHR, 2 = storage buffer
+
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <malloc.h>  // for memalign
+#include <dlfcn.h>   // for dlopen
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+#include <GLES3/gl32.h>
+#include <GLES3/gl3ext.h>
+#include <GL/gl_format.h>
+
+#define GRAPHICS_API_OPENGL_ES 1
+#define OUTPUT_PATH ""
+
+// These prototypes are only included when __USE_GNU is defined but that causes other compile errors.
+extern int pthread_setname_np(pthread_t __target_thread, __const char *__name);
+extern int pthread_setaffinity_np(pthread_t thread, size_t cpusetsize, const cpu_set_t *cpuset);
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
 #elif defined(OS_LINUX)
 
 #define OPENGL_VERSION_MAJOR 4
@@ -417,7 +451,7 @@ Common defines
 #define GLSL_EXTENSIONS "#extension GL_EXT_shader_io_blocks : enable\n"
 #define GL_FINISH_SYNC 1
 
-#if defined(OS_ANDROID)
+#if defined(OS_ANDROID) || defined(OS_LINUX_EGL)
 #define ES_HIGHP "highp"  // GLSL "310 es" requires a precision qualifier on a image2D
 #else
 #define ES_HIGHP ""  // GLSL "430" disallows a precision qualifier on a image2D
@@ -469,7 +503,7 @@ typedef void (*PFNGLFRAMEBUFFERTEXTUREMULTISAMPLEMULTIVIEWOVRPROC)(GLenum target
                                                                    GLsizei samples, GLint baseViewIndex, GLsizei numViews);
 #endif
 
-#if defined(OS_WINDOWS) || defined(OS_LINUX)
+#if defined(OS_WINDOWS) || (defined(OS_LINUX) && !defined(OS_LINUX_EGL))
 
 extern PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
 extern PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
@@ -614,7 +648,7 @@ extern PFNGLFRAMEBUFFERTEXTUREMULTISAMPLEMULTIVIEWOVRPROC glFramebufferTextureMu
 extern PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
 extern PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC glRenderbufferStorageMultisampleEXT;
 
-#elif defined(OS_ANDROID)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_EGL)
 
 // GL_EXT_disjoint_timer_query without _EXT
 #if !defined(GL_TIMESTAMP)
@@ -787,6 +821,11 @@ void ksGpuContext_SetCurrent( ksGpuContext * context );
 void ksGpuContext_UnsetCurrent( ksGpuContext * context );
 bool ksGpuContext_CheckCurrent( ksGpuContext * context );
 
+bool ksGpuContext_CreateSurfaceless( ksGpuContext * context, const ksGpuDevice * device, const int queueIndex,
+                                                                                const ksGpuSurfaceColorFormat colorFormat,
+                                                                                const ksGpuSurfaceDepthFormat depthFormat,
+                                                                                const ksGpuSampleCount sampleCount );
+
 bool ksGpuContext_CreateForSurface( ksGpuContext * context, const ksGpuDevice * device, const int queueIndex,
                                                                                 const ksGpuSurfaceColorFormat colorFormat,
                                                                                 const ksGpuSurfaceDepthFormat depthFormat,
@@ -854,7 +893,7 @@ typedef struct {
 #elif defined(OS_APPLE_MACOS)
     NSOpenGLContext *nsContext;
     CGLContextObj cglContext;
-#elif defined(OS_ANDROID)
+#elif defined(OS_ANDROID) || defined(OS_LINUX_EGL)
     EGLDisplay display;
     EGLConfig config;
     EGLSurface tinySurface;
@@ -879,6 +918,15 @@ void ksGpuContext_SetCurrent(ksGpuContext *context);
 void ksGpuContext_UnsetCurrent(ksGpuContext *context);
 bool ksGpuContext_CheckCurrent(ksGpuContext *context);
 
+#if defined(OS_ANDROID) || defined(OS_LINUX_EGL)
+// Initializes the default EGL display and creates a context that is current without a window: without a
+// surface when the display supports EGL_KHR_surfaceless_context, on a 16x16 pbuffer otherwise. The display
+// stays initialized after ksGpuContext_Destroy, the caller terminates it when nothing else uses it.
+bool ksGpuContext_CreateSurfaceless(ksGpuContext *context, const ksGpuDevice *device, int queueIndex,
+                                    ksGpuSurfaceColorFormat colorFormat, ksGpuSurfaceDepthFormat depthFormat,
+                                    ksGpuSampleCount sampleCount);
+#endif
+
 /*
 ================================================================================================================================
 
@@ -1015,6 +1063,30 @@ ksNanoseconds ksGpuWindow_GetFrameTimeNanoseconds(ksGpuWindow *window);
 /*
 ================================================================================================================================
 
+Frame logging.
+
+Each thread that calls ksFrameLog_Open will open its own log.
+A frame log is always opened for a specified number of frames, and will
+automatically close after the specified number of frames have been recorded.
+The CPU and GPU times for the recorded frames will be listed at the end of the log.
+
+void ksFrameLog_Open( const char * fileName, const int frameCount );
+void ksFrameLog_Write( const char * fileName, const int lineNumber, const char * function );
+void ksFrameLog_BeginFrame();
+void ksFrameLog_EndFrame( const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds, const int
+gpuTimeFramesDelayed );
+
+================================================================================================================================
+*/
+
+void ksFrameLog_Open(const char *fileName, const int frameCount);
+void ksFrameLog_Write(const char *fileName, const int lineNumber, const char *function);
+void ksFrameLog_BeginFrame();
+void ksFrameLog_EndFrame(const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds, const int gpuTimeFramesDelayed);
+
+/*
+================================================================================================================================
+
 GPU timer.
 
 A timer is used to measure the amount of time it takes to complete GPU commands.
@@ -1028,6 +1100,11 @@ ksGpuTimer
 static void ksGpuTimer_Create( ksGpuContext * context, ksGpuTimer * timer );
 static void ksGpuTimer_Destroy( ksGpuContext * context, ksGpuTimer * timer );
 static ksNanoseconds ksGpuTimer_GetNanoseconds( ksGpuTimer * timer );
+static void ksGpuTimer_Begin( ksGpuTimer * timer );
+static void ksGpuTimer_End( ksGpuTimer * timer );
+
+A timer measures one Begin/End pair per frame. ksGpuTimer_Begin() reads back the pair issued
+KS_GPU_TIMER_FRAMES_DELAYED frames ago before it issues a new one.
 
 ================================================================================================================================
 */
@@ -1044,6 +1121,8 @@ typedef struct {
 void ksGpuTimer_Create(ksGpuContext *context, ksGpuTimer *timer);
 void ksGpuTimer_Destroy(ksGpuContext *context, ksGpuTimer *timer);
 ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer);
+void ksGpuTimer_Begin(ksGpuTimer *timer);
+void ksGpuTimer_End(ksGpuTimer *timer);
 
 #ifdef __cplusplus
 }
@@ -12,8 +12,16 @@
 #include <common/xr_linear.h>
 #include <array>
 #include <cmath>
+#include <condition_variable>
+#include <mutex>
 #include <math.h>
 #include "demos/application.h"
+#include "demos/frameArena.h"
+#include "demos/lateLatch.h"
+#include "demos/profiler.h"
+#include "demos/glState.h"
+#include "demos/platform.h"
+#include "posecache.h"
 
 namespace {
 
@@ -98,6 +106,22 @@ inline XrReferenceSpaceCreateInfo GetXrReferenceSpaceCreateInfo(const std::strin
     return referenceSpaceCreateInfo;
 }
 
+// Everything sampled for one frame between xrWaitFrame and xrBeginFrame. Once it has been handed
+// to the render thread it is never written again.
+struct FrameSnapshot {
+    XrFrameState frameState{XR_TYPE_FRAME_STATE};
+    bool viewsValid{false};
+    std::array<XrView, Side::COUNT> views;
+    float ipd{0.0f};
+    bool aimValid[Side::COUNT] = {false, false};
+    XrPosef aimPose[Side::COUNT];
+    bool gazeValid{false};
+    XrSpaceLocation gazeLocation{XR_TYPE_SPACE_LOCATION};
+    XrResult gazeResult{XR_SUCCESS};
+    XrHandJointLocationEXT jointLocations[Side::COUNT][XR_HAND_JOINT_COUNT_EXT] = {};
+    ApplicationEvent applicationEvent[Side::COUNT] = {};
+};
+
 struct OpenXrProgram : IOpenXrProgram {
     OpenXrProgram(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin>& platformPlugin,
                   const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin)
@@ -106,6 +130,8 @@ struct OpenXrProgram : IOpenXrProgram {
         }
 
     ~OpenXrProgram() override {
+        StopSimulationThread();
+
         if (m_input.actionSet != XR_NULL_HANDLE) {
             for (auto hand : {Side::LEFT, Side::RIGHT}) {
                 xrDestroySpace(m_input.handSpace[hand]);
@@ -117,6 +143,9 @@ struct OpenXrProgram : IOpenXrProgram {
         for (Swapchain swapchain : m_swapchains) {
             xrDestroySwapchain(swapchain.handle);
         }
+        if (m_panelSwapchain.handle != XR_NULL_HANDLE) {
+            xrDestroySwapchain(m_panelSwapchain.handle);
+        }
 
         if (m_appSpace != XR_NULL_HANDLE) {
             xrDestroySpace(m_appSpace);
@@ -132,23 +161,22 @@ struct OpenXrProgram : IOpenXrProgram {
     }
 
     void CheckDeviceSupportExtentions() {
-        char buffer[64] = {0};
-        __system_property_get("sys.pxr.product.name", buffer);
-        Log::Write(Log::Level::Info, Fmt("device is: %s", buffer));
-        if (std::string(buffer) == "Pico Neo 3 Pro Eye") {
+        std::string product = getSystemProperty("sys.pxr.product.name");
+        Log::Write(Log::Level::Info, Fmt("device is: %s", product.c_str()));
+        if (product == "Pico Neo 3 Pro Eye") {
             m_deviceType = DeviceTypeNeo3ProEye;
-        } else if (std::string(buffer) == "PICO 4") {
+        } else if (product == "PICO 4") {
             m_deviceType = DeviceTypePico4;
-        }else if (std::string(buffer) == "PICO 4 Pro") {
+        }else if (product == "PICO 4 Pro") {
             m_deviceType = DeviceTypePico4Pro;
-        } else if (std::string(buffer) == "PICO 4 Ultra") {
+        } else if (product == "PICO 4 Ultra") {
             m_deviceType = DeviceTypePico4Ultra;
         }
 
         if (m_deviceType != DeviceTypePico4Ultra) {
-            __system_property_get("ro.build.id", buffer);
-            int a, b, c;
-            sscanf(buffer, "%d.%d.%d",&a, &b, &c);
+            std::string buildId = getSystemProperty("ro.build.id");
+            int a = 0, b = 0, c = 0;
+            sscanf(buildId.c_str(), "%d.%d.%d",&a, &b, &c);
             m_deviceROM = (a << 8) + (b << 4) + c;
             Log::Write(Log::Level::Info, Fmt("device ROM: %x", m_deviceROM));
             if (m_deviceROM < 0x540) {
@@ -224,6 +252,19 @@ struct OpenXrProgram : IOpenXrProgram {
         }
     }
 
+    static bool IsInstanceExtensionSupported(const char* name) {
+        uint32_t instanceExtensionCount;
+        CHECK_XRCMD(xrEnumerateInstanceExtensionProperties(nullptr, 0, &instanceExtensionCount, nullptr));
+        std::vector<XrExtensionProperties> extensions(instanceExtensionCount, {XR_TYPE_EXTENSION_PROPERTIES});
+        CHECK_XRCMD(xrEnumerateInstanceExtensionProperties(nullptr, (uint32_t)extensions.size(), &instanceExtensionCount, extensions.data()));
+        for (const XrExtensionProperties& extension : extensions) {
+            if (strcmp(extension.extensionName, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void LogInstanceInfo() {
         CHECK(m_instance != XR_NULL_HANDLE);
 
@@ -263,6 +304,28 @@ struct OpenXrProgram : IOpenXrProgram {
         //hand tracking
         extensions.push_back(XR_EXT_HAND_TRACKING_EXTENSION_NAME);
         extensions.push_back(XR_BD_CONTROLLER_INTERACTION_EXTENSION_NAME);
+
+        //locate all spaces of a frame in one call
+        m_locateSpacesEnabled = IsInstanceExtensionSupported(XR_KHR_LOCATE_SPACES_EXTENSION_NAME);
+        if (m_locateSpacesEnabled) {
+            extensions.push_back(XR_KHR_LOCATE_SPACES_EXTENSION_NAME);
+        }
+        Log::Write(Log::Level::Info, Fmt("XR_KHR_locate_spaces %s", m_locateSpacesEnabled ? "enabled" : "not supported"));
+
+        //video decoded into a swapchain surface, presented as quad or equirect layers
+#ifdef XR_USE_PLATFORM_ANDROID
+        if (m_options.VideoLayer) {
+            m_extentions.activeVideoLayer = IsInstanceExtensionSupported(XR_KHR_ANDROID_SURFACE_SWAPCHAIN_EXTENSION_NAME) &&
+                                            IsInstanceExtensionSupported(XR_KHR_COMPOSITION_LAYER_EQUIRECT2_EXTENSION_NAME);
+            if (m_extentions.activeVideoLayer) {
+                extensions.push_back(XR_KHR_ANDROID_SURFACE_SWAPCHAIN_EXTENSION_NAME);
+                extensions.push_back(XR_KHR_COMPOSITION_LAYER_EQUIRECT2_EXTENSION_NAME);
+            } else {
+                Log::Write(Log::Level::Warning, "Video layers requested but not supported, drawing the video into the eye buffers");
+            }
+        }
+#endif
+
         XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
         createInfo.next = m_platformPlugin->GetInstanceCreateExtension();
         createInfo.enabledExtensionCount = (uint32_t)extensions.size();
@@ -439,10 +502,48 @@ struct OpenXrProgram : IOpenXrProgram {
 
         //eye tracking
         XrAction gazeAction{XR_NULL_HANDLE};
-        XrSpace  gazeActionSpace;
+        XrSpace  gazeActionSpace{XR_NULL_HANDLE};
         XrBool32 gazeActive;
     };
 
+    // One row per ApplicationEvent field filled by SyncActions. Boolean rows report changes of the button state,
+    // float and vector rows report their value every sync until it has returned to zero.
+    struct ActionEventBinding {
+        XrAction InputState::*action;
+        XrActionType type;
+        uint32_t hands;                  // bit per Side the action is bound on
+        uint32_t eventBit;               // CONTROLLER_EVENT_BIT_*
+        bool ApplicationEvent::*state;   // XR_ACTION_TYPE_BOOLEAN_INPUT
+        float ApplicationEvent::*x;      // XR_ACTION_TYPE_FLOAT_INPUT and XR_ACTION_TYPE_VECTOR2F_INPUT
+        float ApplicationEvent::*y;      // XR_ACTION_TYPE_VECTOR2F_INPUT
+    };
+
+    static const std::vector<ActionEventBinding>& ActionEventBindings() {
+        const uint32_t left = 1 << Side::LEFT;
+        const uint32_t right = 1 << Side::RIGHT;
+        const uint32_t both = left | right;
+        static const std::vector<ActionEventBinding> bindings = {
+            {&InputState::menuAction,            XR_ACTION_TYPE_BOOLEAN_INPUT,  both,  CONTROLLER_EVENT_BIT_click_menu,       &ApplicationEvent::click_menu,       nullptr, nullptr},
+            {&InputState::thumbstickValueAction, XR_ACTION_TYPE_VECTOR2F_INPUT, both,  CONTROLLER_EVENT_BIT_value_thumbstick, nullptr, &ApplicationEvent::thumbstick_x, &ApplicationEvent::thumbstick_y},
+            {&InputState::thumbstickClickAction, XR_ACTION_TYPE_BOOLEAN_INPUT,  both,  CONTROLLER_EVENT_BIT_click_thumbstick, &ApplicationEvent::click_thumbstck,  nullptr, nullptr},
+            {&InputState::thumbstickTouchAction, XR_ACTION_TYPE_BOOLEAN_INPUT,  both,  CONTROLLER_EVENT_BIT_touch_thumbstick, &ApplicationEvent::touch_thumbstick, nullptr, nullptr},
+            {&InputState::triggerValueAction,    XR_ACTION_TYPE_FLOAT_INPUT,    both,  CONTROLLER_EVENT_BIT_value_trigger,    nullptr, &ApplicationEvent::trigger, nullptr},
+            {&InputState::triggerClickAction,    XR_ACTION_TYPE_BOOLEAN_INPUT,  both,  CONTROLLER_EVENT_BIT_click_trigger,    &ApplicationEvent::click_trigger,    nullptr, nullptr},
+            {&InputState::triggerTouchAction,    XR_ACTION_TYPE_BOOLEAN_INPUT,  both,  CONTROLLER_EVENT_BIT_touch_trigger,    &ApplicationEvent::touch_trigger,    nullptr, nullptr},
+            {&InputState::squeezeValueAction,    XR_ACTION_TYPE_FLOAT_INPUT,    both,  CONTROLLER_EVENT_BIT_value_squeeze,    nullptr, &ApplicationEvent::squeeze, nullptr},
+            {&InputState::squeezeClickAction,    XR_ACTION_TYPE_BOOLEAN_INPUT,  both,  CONTROLLER_EVENT_BIT_click_squeeze,    &ApplicationEvent::click_squeeze,    nullptr, nullptr},
+            {&InputState::AAction,               XR_ACTION_TYPE_BOOLEAN_INPUT,  right, CONTROLLER_EVENT_BIT_click_a,          &ApplicationEvent::click_a,          nullptr, nullptr},
+            {&InputState::BAction,               XR_ACTION_TYPE_BOOLEAN_INPUT,  right, CONTROLLER_EVENT_BIT_click_b,          &ApplicationEvent::click_b,          nullptr, nullptr},
+            {&InputState::XAction,               XR_ACTION_TYPE_BOOLEAN_INPUT,  left,  CONTROLLER_EVENT_BIT_click_x,          &ApplicationEvent::click_x,          nullptr, nullptr},
+            {&InputState::YAction,               XR_ACTION_TYPE_BOOLEAN_INPUT,  left,  CONTROLLER_EVENT_BIT_click_y,          &ApplicationEvent::click_y,          nullptr, nullptr},
+            {&InputState::ATouchAction,          XR_ACTION_TYPE_BOOLEAN_INPUT,  right, CONTROLLER_EVENT_BIT_touch_a,          &ApplicationEvent::touch_a,          nullptr, nullptr},
+            {&InputState::BTouchAction,          XR_ACTION_TYPE_BOOLEAN_INPUT,  right, CONTROLLER_EVENT_BIT_touch_b,          &ApplicationEvent::touch_b,          nullptr, nullptr},
+            {&InputState::XTouchAction,          XR_ACTION_TYPE_BOOLEAN_INPUT,  left,  CONTROLLER_EVENT_BIT_touch_x,          &ApplicationEvent::touch_x,          nullptr, nullptr},
+            {&InputState::YTouchAction,          XR_ACTION_TYPE_BOOLEAN_INPUT,  left,  CONTROLLER_EVENT_BIT_touch_y,          &ApplicationEvent::touch_y,          nullptr, nullptr},
+        };
+        return bindings;
+    }
+
     void InitializeActions() {
         // Create an action set.
         {
@@ -780,6 +881,10 @@ struct OpenXrProgram : IOpenXrProgram {
         actionSpaceInfo.subactionPath = m_input.handSubactionPath[Side::RIGHT];
         CHECK_XRCMD(xrCreateActionSpace(m_session, &actionSpaceInfo, &m_input.aimSpace[Side::RIGHT]));
 
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            m_actionEventValues[hand].assign(ActionEventBindings().size(), {0.0f, 0.0f});
+        }
+
         XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
         attachInfo.countActionSets = 1;
         attachInfo.actionSets = &m_input.actionSet;
@@ -816,6 +921,15 @@ struct OpenXrProgram : IOpenXrProgram {
             CHECK_XRCMD(xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &m_appSpace));
         }
 
+        // the aim spaces SampleFrame needs, the late latch only re-locates those; the gaze space is added while
+        // eye tracking is on
+        m_poseCache.Initialize(m_instance, m_session, m_appSpace, m_locateSpacesEnabled);
+        m_lateLatchPoseCache.Initialize(m_instance, m_session, m_appSpace, m_locateSpacesEnabled);
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            m_poseCache.AddSpace(m_input.aimSpace[hand]);
+            m_lateLatchPoseCache.AddSpace(m_input.aimSpace[hand]);
+        }
+
         //XR_FB_passthrough
         {
             XrPassthroughCreateInfoFB passthroughCreateInfo = {XR_TYPE_PASSTHROUGH_CREATE_INFO_FB};
@@ -927,15 +1041,23 @@ struct OpenXrProgram : IOpenXrProgram {
                 Log::Write(Log::Level::Verbose, Fmt("Swapchain Formats: %s", swapchainFormatsString.c_str()));
             }
 
-            // Create a swapchain for each view.
-            for (uint32_t i = 0; i < viewCount; i++) {
+            // With multiview both views render into the layers of a single array swapchain, otherwise
+            // create a swapchain for each view.
+            m_extentions.activeMultiview = m_options.Multiview && m_graphicsPlugin->IsMultiviewSupported() && viewCount == 2 &&
+                                           m_configViews[0].recommendedImageRectWidth == m_configViews[1].recommendedImageRectWidth &&
+                                           m_configViews[0].recommendedImageRectHeight == m_configViews[1].recommendedImageRectHeight;
+            if (m_options.Multiview && !m_extentions.activeMultiview) {
+                Log::Write(Log::Level::Warning, "Multiview requested but not supported, rendering each view separately");
+            }
+            const uint32_t swapchainCount = m_extentions.activeMultiview ? 1 : viewCount;
+            for (uint32_t i = 0; i < swapchainCount; i++) {
                 const XrViewConfigurationView& vp = m_configViews[i];
                 Log::Write(Log::Level::Info, Fmt("Creating swapchain for view %d with dimensions Width=%d Height=%d SampleCount=%d, maxSampleCount=%d", i,
                                                     vp.recommendedImageRectWidth, vp.recommendedImageRectHeight, vp.recommendedSwapchainSampleCount, vp.maxSwapchainSampleCount));
 
                 // Create the swapchain.
                 XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
-                swapchainCreateInfo.arraySize = 1;
+                swapchainCreateInfo.arraySize = m_extentions.activeMultiview ? viewCount : 1;
                 swapchainCreateInfo.format = m_colorSwapchainFormat;
                 swapchainCreateInfo.width = vp.recommendedImageRectWidth;
                 swapchainCreateInfo.height = vp.recommendedImageRectHeight;
@@ -1036,6 +1158,7 @@ struct OpenXrProgram : IOpenXrProgram {
             case XR_SESSION_STATE_STOPPING: {
                 CHECK(m_session != XR_NULL_HANDLE);
                 m_sessionRunning = false;
+                StopSimulationThread();
                 CHECK_XRCMD(xrEndSession(m_session))
                 break;
             }
@@ -1097,6 +1220,25 @@ struct OpenXrProgram : IOpenXrProgram {
     bool IsSessionFocused() const override { return m_sessionState == XR_SESSION_STATE_FOCUSED; }
 
     void PollActions() override {
+        if (m_options.PipelinedFrameLoop) {
+            // Actions are synced on the simulation thread right after xrWaitFrame.
+            return;
+        }
+        SyncActions(m_applicationEvent);
+        DispatchInputEvents(m_applicationEvent);
+    }
+
+    void DispatchInputEvents(const ApplicationEvent (&applicationEvents)[Side::COUNT]) {
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            m_applicationEvent[hand] = applicationEvents[hand];
+            m_application->inputEvent(hand, m_applicationEvent[hand]);
+        }
+    }
+
+    // Updates the event state of both hands in place; values without a change bit keep their last value.
+    void SyncActions(ApplicationEvent (&applicationEvents)[Side::COUNT]) {
+        PROFILE_SCOPE(profileMarker_PollActions);
+
         // Sync actions
         const XrActiveActionSet activeActionSet{m_input.actionSet, XR_NULL_PATH};
         XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
@@ -1104,239 +1246,63 @@ struct OpenXrProgram : IOpenXrProgram {
         syncInfo.activeActionSets = &activeActionSet;
         CHECK_XRCMD(xrSyncActions(m_session, &syncInfo));
 
-        static float joystick_x[Side::COUNT] = {0};
-        static float joystick_y[Side::COUNT] = {0};
-        static float trigger[Side::COUNT] = {0};
-        static float squeeze[Side::COUNT] = {0};
-
-        // Get pose and grab action state and start haptic vibrate when hand is 90% squeezed.
+        // Only the actions whose event bits the application currently reads are queried.
+        const uint32_t eventMask = m_application->inputEventMask();
+        const std::vector<ActionEventBinding>& bindings = ActionEventBindings();
         for (auto hand : {Side::LEFT, Side::RIGHT}) {
-            ApplicationEvent &applicationEvent = m_applicationEvent[hand];
+            ApplicationEvent &applicationEvent = applicationEvents[hand];
             applicationEvent.controllerEventBit = 0x00;
 
             XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
             getInfo.subactionPath = m_input.handSubactionPath[hand];
-            //menu click
-            getInfo.action = m_input.menuAction;
-            XrActionStateBoolean homeValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &homeValue));
-            if (homeValue.isActive == XR_TRUE) {
-                if(homeValue.changedSinceLastSync == XR_TRUE) {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_menu;
-                    if(homeValue.currentState == XR_TRUE) {
-                        applicationEvent.click_menu = true;
-                    } else{
-                        applicationEvent.click_menu = false;
-                    }
+            for (size_t i = 0; i < bindings.size(); i++) {
+                const ActionEventBinding& binding = bindings[i];
+                if ((binding.hands & (1 << hand)) == 0 || (binding.eventBit & eventMask) == 0) {
+                    continue;
                 }
-            }
-
-            //thumbstick value x/y
-            getInfo.action = m_input.thumbstickValueAction;
-            XrActionStateVector2f thumbstickValue{XR_TYPE_ACTION_STATE_VECTOR2F};
-            CHECK_XRCMD(xrGetActionStateVector2f(m_session, &getInfo, &thumbstickValue));
-            if (thumbstickValue.isActive == XR_TRUE) {
-                if (thumbstickValue.currentState.x == 0 && thumbstickValue.currentState.y == 0 && joystick_x[hand] == 0 && joystick_y[hand] == 0) {
-                } else {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_value_thumbstick;
-                    applicationEvent.thumbstick_x = thumbstickValue.currentState.x;
-                    applicationEvent.thumbstick_y = thumbstickValue.currentState.y;
-                }
-                joystick_x[hand] = thumbstickValue.currentState.x;
-                joystick_y[hand] = thumbstickValue.currentState.y;
-            }
-            // thumbstick click
-            getInfo.action = m_input.thumbstickClickAction;
-            XrActionStateBoolean thumbstickClick{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &thumbstickClick));
-            if ((thumbstickClick.isActive == XR_TRUE) && (thumbstickClick.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_thumbstick;
-                if(thumbstickClick.currentState == XR_TRUE) {
-                    applicationEvent.click_thumbstck = true;
-                } else {
-                    applicationEvent.click_thumbstck = false;
-                }
-            }
-            // thumbstick touch
-            getInfo.action = m_input.thumbstickTouchAction;
-            XrActionStateBoolean thumbstickTouch{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &thumbstickTouch));
-            if (thumbstickTouch.isActive == XR_TRUE) {
-                if (thumbstickTouch.changedSinceLastSync == XR_TRUE) {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_touch_thumbstick;
-                    if (thumbstickTouch.currentState == XR_TRUE) {
-                        applicationEvent.touch_thumbstick = true;
-                    } else {
-                        applicationEvent.touch_thumbstick = false;
+                getInfo.action = m_input.*binding.action;
+                XrVector2f& lastValue = m_actionEventValues[hand][i];
+                switch (binding.type) {
+                    case XR_ACTION_TYPE_BOOLEAN_INPUT: {
+                        XrActionStateBoolean state{XR_TYPE_ACTION_STATE_BOOLEAN};
+                        CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &state));
+                        // the comparison catches changes made while the binding was not subscribed
+                        const bool currentState = (state.currentState == XR_TRUE);
+                        if (state.isActive == XR_TRUE && (state.changedSinceLastSync == XR_TRUE || applicationEvent.*binding.state != currentState)) {
+                            applicationEvent.controllerEventBit |= binding.eventBit;
+                            applicationEvent.*binding.state = currentState;
+                        }
+                        break;
                     }
-                }
-            }
-
-            //trigger value
-            getInfo.action = m_input.triggerValueAction;
-            XrActionStateFloat triggerValue{XR_TYPE_ACTION_STATE_FLOAT};
-            CHECK_XRCMD(xrGetActionStateFloat(m_session, &getInfo, &triggerValue));
-            if (triggerValue.isActive == XR_TRUE) {
-                if (triggerValue.currentState == 0 && trigger[hand] == 0) {
-                } else {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_value_trigger;
-                    applicationEvent.trigger = triggerValue.currentState;
-                }
-                trigger[hand] = triggerValue.currentState;
-            }
-            // trigger click
-            getInfo.action = m_input.triggerClickAction;
-            XrActionStateBoolean TriggerClick{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &TriggerClick));
-            if (TriggerClick.isActive == XR_TRUE) {
-                if (TriggerClick.changedSinceLastSync == XR_TRUE) {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_trigger;
-                    if (TriggerClick.currentState == XR_TRUE) {
-                        applicationEvent.click_trigger = true;
-                    } else {
-                        applicationEvent.click_trigger = false;
+                    case XR_ACTION_TYPE_FLOAT_INPUT: {
+                        XrActionStateFloat state{XR_TYPE_ACTION_STATE_FLOAT};
+                        CHECK_XRCMD(xrGetActionStateFloat(m_session, &getInfo, &state));
+                        if (state.isActive == XR_TRUE) {
+                            if (state.currentState != 0 || lastValue.x != 0) {
+                                applicationEvent.controllerEventBit |= binding.eventBit;
+                                applicationEvent.*binding.x = state.currentState;
+                            }
+                            lastValue.x = state.currentState;
+                        }
+                        break;
                     }
-                }
-            }
-            // trigger touch
-            getInfo.action = m_input.triggerTouchAction;
-            XrActionStateBoolean TriggerTouch{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &TriggerTouch));
-            if (TriggerTouch.isActive == XR_TRUE) {
-                if (TriggerTouch.changedSinceLastSync == XR_TRUE) {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_touch_trigger;
-                    if (TriggerTouch.currentState == XR_TRUE) {
-                        applicationEvent.touch_trigger = true;
-                    } else {
-                        applicationEvent.touch_trigger = false;
+                    case XR_ACTION_TYPE_VECTOR2F_INPUT: {
+                        XrActionStateVector2f state{XR_TYPE_ACTION_STATE_VECTOR2F};
+                        CHECK_XRCMD(xrGetActionStateVector2f(m_session, &getInfo, &state));
+                        if (state.isActive == XR_TRUE) {
+                            if (state.currentState.x != 0 || state.currentState.y != 0 || lastValue.x != 0 || lastValue.y != 0) {
+                                applicationEvent.controllerEventBit |= binding.eventBit;
+                                applicationEvent.*binding.x = state.currentState.x;
+                                applicationEvent.*binding.y = state.currentState.y;
+                            }
+                            lastValue = state.currentState;
+                        }
+                        break;
                     }
+                    default:
+                        THROW(Fmt("Unsupported action type %d in the action event table", binding.type));
                 }
             }
-
-            // squeeze value
-            getInfo.action = m_input.squeezeValueAction;
-            XrActionStateFloat squeezeValue{XR_TYPE_ACTION_STATE_FLOAT};
-            CHECK_XRCMD(xrGetActionStateFloat(m_session, &getInfo, &squeezeValue));
-            if (squeezeValue.isActive == XR_TRUE) {
-                if (squeezeValue.currentState == 0 && squeeze[hand] == 0) {
-                } else {
-                    applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_value_squeeze;
-                    applicationEvent.squeeze = squeezeValue.currentState;
-                }
-                squeeze[hand] = squeezeValue.currentState;
-            }
-            // squeeze click
-            getInfo.action = m_input.squeezeClickAction;
-            XrActionStateBoolean squeezeClick{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &squeezeClick));
-            if ((squeezeClick.isActive == XR_TRUE) && (squeezeClick.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_squeeze;
-                if(squeezeClick.currentState == XR_TRUE) {
-                    applicationEvent.click_squeeze = true;
-                } else{
-                    applicationEvent.click_squeeze = false;
-                }
-            }
-           
-            // A button
-            getInfo.action = m_input.AAction;
-            XrActionStateBoolean AValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &AValue));
-            if ((AValue.isActive == XR_TRUE) && (AValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_a;
-                if(AValue.currentState == XR_TRUE) {
-                    applicationEvent.click_a = true;
-                } else {
-                    applicationEvent.click_a = false;
-                }
-            }
-            // B button
-            getInfo.action = m_input.BAction;
-            XrActionStateBoolean BValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &BValue));
-            if ((BValue.isActive == XR_TRUE) && (BValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_b;
-                if(BValue.currentState == XR_TRUE) {
-                    applicationEvent.click_b = true;
-                } else {
-                    applicationEvent.click_b = false;
-                }
-            }
-            // X button
-            getInfo.action = m_input.XAction;
-            XrActionStateBoolean XValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &XValue));
-            if ((XValue.isActive == XR_TRUE) && (XValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_x;
-                if(XValue.currentState == XR_TRUE) {
-                    applicationEvent.click_x = true;
-                } else {
-                    applicationEvent.click_x = false;
-                }
-            }
-            // Y button
-            getInfo.action = m_input.YAction;
-            XrActionStateBoolean YValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &YValue));
-            if ((YValue.isActive == XR_TRUE) && (YValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_click_y;
-                if(YValue.currentState == XR_TRUE) {
-                    applicationEvent.click_y = true;
-                } else {
-                    applicationEvent.click_y = false;
-                }
-            }
-
-            // A button touch
-            getInfo.action = m_input.ATouchAction;
-            XrActionStateBoolean ATouchValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &ATouchValue));
-            if ((ATouchValue.isActive == XR_TRUE) && (ATouchValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_touch_a;
-                if(ATouchValue.currentState == XR_TRUE) {
-                    applicationEvent.touch_a = true;
-                } else {
-                    applicationEvent.touch_a = false;
-                }
-            }
-            // B button touch
-            getInfo.action = m_input.BTouchAction;
-            XrActionStateBoolean BTouchValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &BTouchValue));
-            if ((BTouchValue.isActive == XR_TRUE) && (BTouchValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_touch_b;
-                if(BTouchValue.currentState == XR_TRUE) {
-                    applicationEvent.touch_b = true;
-                } else {
-                    applicationEvent.touch_b = false;
-                }
-            }
-            // X button touch
-            getInfo.action = m_input.XTouchAction;
-            XrActionStateBoolean XTouchValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &XTouchValue));
-            if ((XTouchValue.isActive == XR_TRUE) && (XTouchValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_touch_x;
-                if(XTouchValue.currentState == XR_TRUE) {
-                    applicationEvent.touch_x = true;
-                } else {
-                    applicationEvent.touch_x = false;
-                }
-            }
-            // Y button touch
-            getInfo.action = m_input.YTouchAction;
-            XrActionStateBoolean YTouchValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-            CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &YTouchValue));
-            if ((YTouchValue.isActive == XR_TRUE) && (YTouchValue.changedSinceLastSync == XR_TRUE)) {
-                applicationEvent.controllerEventBit |= CONTROLLER_EVENT_BIT_touch_y;
-                if(YTouchValue.currentState == XR_TRUE) {
-                    applicationEvent.touch_y = true;
-                } else {
-                    applicationEvent.touch_y = false;
-                }
-            }
-
-            m_application->inputEvent(hand, applicationEvent);
         }
 
         if (m_extentions.isSupportEyeTracking && m_extentions.activeEyeTracking) {
@@ -1350,106 +1316,188 @@ struct OpenXrProgram : IOpenXrProgram {
 
     void RenderFrame() override {
         CHECK(m_session != XR_NULL_HANDLE);
+        if (m_options.PipelinedFrameLoop) {
+            RenderFramePipelined();
+            return;
+        }
+
+        FrameSnapshot snapshot;
         XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
-        XrFrameState frameState{XR_TYPE_FRAME_STATE};
-        CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        {
+            PROFILE_SCOPE(profileMarker_WaitFrame);
+            CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &snapshot.frameState));
+        }
+        SampleFrame(snapshot);
+        SubmitFrame(snapshot, true);
+    }
 
-        XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-        CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+    // Render thread side of the pipelined loop: take the next snapshot produced by the simulation
+    // thread and begin/render/end it. xrWaitFrame for the next frame is released by our xrBeginFrame,
+    // so the simulation of frame N+1 overlaps the rendering of frame N.
+    void RenderFramePipelined() {
+        if (!m_simulationThread.joinable()) {
+            StartSimulationThread();
+        }
 
-        std::vector<XrCompositionLayerBaseHeader*> layers;
-        XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
-        std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
-        if (frameState.shouldRender == XR_TRUE) {
-            if (RenderLayer(frameState.predictedDisplayTime, projectionLayerViews, layer)) {
-                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
+        FrameSnapshot snapshot;
+        if (!TakePendingFrame(snapshot)) {
+            StopSimulationThread();
+            if (m_simulationError) {
+                std::rethrow_exception(m_simulationError);
             }
+            return;
         }
+        DispatchInputEvents(snapshot.applicationEvent);
+        SubmitFrame(snapshot, true);
+    }
 
-        if (m_extentions.activePassthrough) {
-            XrCompositionLayerPassthroughFB compositionLayerPassthrough = {XR_TYPE_COMPOSITION_LAYER_PASSTHROUGH_FB};
-            compositionLayerPassthrough.layerHandle = m_passthroughLayerReconstruction;
-            //passthrough_layer.layerHandle = m_passthroughLayer_project;
-            compositionLayerPassthrough.flags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
-            compositionLayerPassthrough.space = XR_NULL_HANDLE;
-            layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&compositionLayerPassthrough));
+    void StartSimulationThread() {
+        CHECK(!m_simulationThread.joinable());
+        m_simulationStop = false;
+        m_simulationDone = false;
+        m_pendingFrameValid = false;
+        m_simulationError = nullptr;
+        m_simulationThread = std::thread(&OpenXrProgram::SimulationThread, this);
+    }
+
+    void StopSimulationThread() {
+        if (!m_simulationThread.joinable()) {
+            return;
         }
+        {
+            std::lock_guard<std::mutex> lock(m_frameMutex);
+            m_simulationStop = true;
+        }
+        m_frameCondition.notify_all();
 
-        XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
-        frameEndInfo.displayTime = frameState.predictedDisplayTime;
-        frameEndInfo.environmentBlendMode = m_options.Parsed.EnvironmentBlendMode;
-        frameEndInfo.layerCount = (uint32_t)layers.size();
-        frameEndInfo.layers = layers.data();
-        CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        // Every frame the simulation thread has waited on must still be begun and ended, otherwise
+        // its next xrWaitFrame would never return. Submit them without layers until it exits.
+        FrameSnapshot snapshot;
+        while (TakePendingFrame(snapshot)) {
+            SubmitFrame(snapshot, false);
+        }
+        m_simulationThread.join();
+    }
+
+    // Blocks until the simulation thread has a snapshot ready. Returns false once it has exited.
+    bool TakePendingFrame(FrameSnapshot& snapshot) {
+        {
+            std::unique_lock<std::mutex> lock(m_frameMutex);
+            m_frameCondition.wait(lock, [this] { return m_pendingFrameValid || m_simulationDone; });
+            if (!m_pendingFrameValid) {
+                return false;
+            }
+            snapshot = m_pendingFrame;
+            m_pendingFrameValid = false;
+        }
+        m_frameCondition.notify_all();
+        return true;
+    }
+
+    void SimulationThread() {
+        try {
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(m_frameMutex);
+                    if (m_simulationStop) {
+                        break;
+                    }
+                }
+
+                FrameSnapshot snapshot;
+                XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
+                {
+                    PROFILE_SCOPE(profileMarker_WaitFrame);
+                    CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &snapshot.frameState));
+                }
+                SyncActions(m_simulationEvent);
+                std::copy(std::begin(m_simulationEvent), std::end(m_simulationEvent), std::begin(snapshot.applicationEvent));
+                SampleFrame(snapshot);
+
+                // Single slot hand-off: wait for the render thread to pick up the previous frame.
+                std::unique_lock<std::mutex> lock(m_frameMutex);
+                m_frameCondition.wait(lock, [this] { return !m_pendingFrameValid; });
+                m_pendingFrame = snapshot;
+                m_pendingFrameValid = true;
+                lock.unlock();
+                m_frameCondition.notify_all();
+            }
+        } catch (...) {
+            Log::Write(Log::Level::Error, "Simulation thread stopped on error");
+            m_simulationError = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_frameMutex);
+            m_simulationDone = true;
+        }
+        m_frameCondition.notify_all();
     }
 
-    bool RenderLayer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews, XrCompositionLayerProjection& layer) {
+    // Locate everything the frame needs at its predicted display time. Only touches OpenXR, never
+    // the application, so it is safe to run on the simulation thread.
+    void SampleFrame(FrameSnapshot& snapshot) {
+        if (snapshot.frameState.shouldRender != XR_TRUE) {
+            return;
+        }
+        const XrTime predictedDisplayTime = snapshot.frameState.predictedDisplayTime;
+
         XrResult res;
         XrViewState viewState{XR_TYPE_VIEW_STATE};
-        uint32_t viewCapacityInput = (uint32_t)m_views.size();
+        uint32_t viewCapacityInput = (uint32_t)snapshot.views.size();
         uint32_t viewCountOutput;
         XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
         viewLocateInfo.viewConfigurationType = m_options.Parsed.ViewConfigType;
         viewLocateInfo.displayTime = predictedDisplayTime;
         viewLocateInfo.space = m_appSpace;
 
-        res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, m_views.data());
+        snapshot.views.fill({XR_TYPE_VIEW});
+        res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, snapshot.views.data());
         CHECK_XRRESULT(res, "xrLocateViews");
         if ((viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) == 0 || (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
-            return false;  // There is no valid tracking poses for the views.
+            return;  // There is no valid tracking poses for the views.
         }
 
-        // get ipd
-        float ipd = sqrt(pow(abs(m_views[1].pose.position.x - m_views[0].pose.position.x), 2) + pow(abs(m_views[1].pose.position.y - m_views[0].pose.position.y), 2) + pow(abs(m_views[1].pose.position.z - m_views[0].pose.position.z), 2));
-
         CHECK(viewCountOutput == viewCapacityInput);
         CHECK(viewCountOutput == m_configViews.size());
-        CHECK(viewCountOutput == m_swapchains.size());
+        snapshot.viewsValid = true;
 
-        projectionLayerViews.resize(viewCountOutput);
+        // get ipd
+        const std::array<XrView, Side::COUNT>& views = snapshot.views;
+        snapshot.ipd = sqrt(pow(abs(views[1].pose.position.x - views[0].pose.position.x), 2) + pow(abs(views[1].pose.position.y - views[0].pose.position.y), 2) + pow(abs(views[1].pose.position.z - views[0].pose.position.z), 2));
 
-        std::vector<XrPosef> handPose;
+        // aim and gaze spaces in one go, the gaze space only while eye tracking is on
+        const bool eyeTracking = m_extentions.isSupportEyeTracking && m_extentions.activeEyeTracking;
+        if (eyeTracking) {
+            m_poseCache.AddSpace(m_input.gazeActionSpace);
+        } else {
+            m_poseCache.RemoveSpace(m_input.gazeActionSpace);
+        }
+        m_poseCache.Locate(predictedDisplayTime);
         for (auto hand : {Side::LEFT, Side::RIGHT}) {
-            XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
-            res = xrLocateSpace(m_input.aimSpace[hand], m_appSpace, predictedDisplayTime, &spaceLocation);
-            CHECK_XRRESULT(res, "xrLocateSpace");
-            if (XR_UNQUALIFIED_SUCCESS(res)) {
-                if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
-                    (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-                    handPose.push_back(spaceLocation.pose);
-                    m_application->setControllerPose(int(hand), spaceLocation.pose);
-                }
+            if (m_poseCache.IsPoseValid(m_input.aimSpace[hand])) {
+                snapshot.aimValid[hand] = true;
+                snapshot.aimPose[hand] = m_poseCache.Get(m_input.aimSpace[hand])->pose;
             }
         }
 
         //eye tracking
-        if (m_extentions.isSupportEyeTracking && m_extentions.activeEyeTracking) {
-            if (m_input.gazeActive) {
-                XrEyeGazeSampleTimeEXT eyeGazeSampleTime{XR_TYPE_EYE_GAZE_SAMPLE_TIME_EXT};
-                XrSpaceLocation gazeLocation{XR_TYPE_SPACE_LOCATION, &eyeGazeSampleTime};
-                res = xrLocateSpace(m_input.gazeActionSpace, m_appSpace, predictedDisplayTime, &gazeLocation);
-                //Log::Write(Log::Level::Info, Fmt("gazeActionSpace pose(%f %f %f)  orientation(%f %f %f %f)", 
-                //                                gazeLocation.pose.position.x, gazeLocation.pose.position.y, gazeLocation.pose.position.z, 
-                //                                gazeLocation.pose.orientation.x, gazeLocation.pose.orientation.y, gazeLocation.pose.orientation.z, gazeLocation.pose.orientation.w));
-                m_application->setGazeLocation(gazeLocation, m_views, ipd, res);
+        if (eyeTracking) {
+            const XrSpaceLocationData* gazeLocation = m_poseCache.Get(m_input.gazeActionSpace);
+            if (m_input.gazeActive && gazeLocation != nullptr) {
+                //Log::Write(Log::Level::Info, Fmt("gazeActionSpace pose(%f %f %f)  orientation(%f %f %f %f)",
+                //                                gazeLocation->pose.position.x, gazeLocation->pose.position.y, gazeLocation->pose.position.z,
+                //                                gazeLocation->pose.orientation.x, gazeLocation->pose.orientation.y, gazeLocation->pose.orientation.z, gazeLocation->pose.orientation.w));
+                snapshot.gazeValid = true;
+                snapshot.gazeLocation.locationFlags = gazeLocation->locationFlags;
+                snapshot.gazeLocation.pose = gazeLocation->pose;
+                snapshot.gazeResult = m_poseCache.Result();
             }
         }
 
         //hand tracking
-        XrHandJointLocationEXT jointLocations[Side::COUNT][XR_HAND_JOINT_COUNT_EXT];
-        for (auto hand : {Side::LEFT, Side::RIGHT}) {
-            XrHandJointLocationsEXT locations{XR_TYPE_HAND_JOINT_LOCATIONS_EXT};
-            locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
-            locations.jointLocations = jointLocations[hand];
-
-            XrHandJointsLocateInfoEXT locateInfo{XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT};
-            locateInfo.baseSpace = m_appSpace;
-            locateInfo.time = predictedDisplayTime;
-            XrResult res = xrLocateHandJointsEXT(m_handTracker[hand], &locateInfo, &locations);
-            if (res != XR_SUCCESS) {
-                Log::Write(Log::Level::Error, Fmt("m_pfnXrLocateHandJointsEXT res %d", res));
-            }
-        }
+        XrHandJointLocationEXT (&jointLocations)[Side::COUNT][XR_HAND_JOINT_COUNT_EXT] = snapshot.jointLocations;
+        LocateHandJoints(predictedDisplayTime, jointLocations);
         XrHandJointLocationEXT& leftIndexTip = jointLocations[Side::LEFT][XR_HAND_JOINT_INDEX_TIP_EXT];
         XrHandJointLocationEXT& rightIndexTip = jointLocations[Side::RIGHT][XR_HAND_JOINT_INDEX_TIP_EXT];
         //Log::Write(Log::Level::Error, Fmt("leftIndexTip.locationFlags:%d, rightIndexTip.locationFlags %d", leftIndexTip.locationFlags, rightIndexTip.locationFlags));
@@ -1463,6 +1511,26 @@ struct OpenXrProgram : IOpenXrProgram {
                 Log::Write(Log::Level::Error, Fmt("len %f", len));
             }
         }
+        //end hand tracking
+    }
+
+    void LocateHandJoints(XrTime time, XrHandJointLocationEXT (&jointLocations)[Side::COUNT][XR_HAND_JOINT_COUNT_EXT]) {
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            if (m_handTracker[hand] == XR_NULL_HANDLE) {
+                continue;
+            }
+            XrHandJointLocationsEXT locations{XR_TYPE_HAND_JOINT_LOCATIONS_EXT};
+            locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
+            locations.jointLocations = jointLocations[hand];
+
+            XrHandJointsLocateInfoEXT locateInfo{XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT};
+            locateInfo.baseSpace = m_appSpace;
+            locateInfo.time = time;
+            XrResult res = xrLocateHandJointsEXT(m_handTracker[hand], &locateInfo, &locations);
+            if (res != XR_SUCCESS) {
+                Log::Write(Log::Level::Error, Fmt("m_pfnXrLocateHandJointsEXT res %d", res));
+            }
+        }
         for (auto hand : {Side::LEFT, Side::RIGHT}) {
             for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
                 XrHandJointLocationEXT& jointLocation = jointLocations[hand][i];
@@ -1488,24 +1556,122 @@ struct OpenXrProgram : IOpenXrProgram {
                 }
             }
         }
+    }
+
+    // Locates the aim poses and hand joints once more, right before a view is drawn, and hands them to the
+    // application. The renderers read them from the LateLatch uniform block written at the start of the view.
+    void LateLatchPoses(XrTime predictedDisplayTime) {
+        if (!LateLatch::instance().isActive()) {
+            return;
+        }
+        m_lateLatchPoseCache.Locate(predictedDisplayTime);
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            if (m_lateLatchPoseCache.IsPoseValid(m_input.aimSpace[hand])) {
+                m_application->setControllerPose(int(hand), m_lateLatchPoseCache.Get(m_input.aimSpace[hand])->pose);
+            }
+        }
+
+        XrHandJointLocationEXT jointLocations[Side::COUNT][XR_HAND_JOINT_COUNT_EXT] = {};
+        LocateHandJoints(predictedDisplayTime, jointLocations);
         m_application->setHandJointLocation((XrHandJointLocationEXT*)jointLocations);
-        //end hand tracking
+    }
 
-        XrSpaceVelocity velocity{XR_TYPE_SPACE_VELOCITY};
-        XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION, &velocity};
-        res = xrLocateSpace(m_ViewSpace, m_appSpace, predictedDisplayTime, &spaceLocation);
-        CHECK_XRRESULT(res, "xrLocateSpace");
+    // xrBeginFrame, render the sampled frame and xrEndFrame. Always runs on the thread owning the GL context.
+    void SubmitFrame(const FrameSnapshot& snapshot, bool renderLayers) {
+        XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+        {
+            PROFILE_SCOPE(profileMarker_BeginFrame);
+            CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        }
 
+        // Everything below until xrEndFrame allocates from the frame arena instead of the heap.
+        FrameArena::instance().reset();
+        if (m_options.CountFrameAllocations) {
+            AllocationCounter::begin();
+        }
 
-        XrPosef pose[Side::COUNT];
-        for (uint32_t i = 0; i < viewCountOutput; i++) {
-            pose[i] = m_views[i].pose;
+        FrameVector<XrCompositionLayerBaseHeader*> layers;
+        layers.reserve(3 + APPLICATION_MAX_VIDEO_LAYERS);
+        XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
+        FrameVector<XrCompositionLayerProjectionView> projectionLayerViews;
+        XrCompositionLayerQuad panelLayer{XR_TYPE_COMPOSITION_LAYER_QUAD};
+        if (renderLayers && snapshot.frameState.shouldRender == XR_TRUE && snapshot.viewsValid) {
+            if (RenderLayer(snapshot, projectionLayerViews, layer)) {
+                // The video shows through where the eye buffers stayed transparent.
+                XrCompositionLayerBaseHeader* videoLayers[APPLICATION_MAX_VIDEO_LAYERS];
+                const uint32_t videoLayerCount = m_extentions.activeVideoLayer ? m_application->videoLayers(m_appSpace, videoLayers) : 0;
+                if (videoLayerCount > 0) {
+                    layers.insert(layers.end(), videoLayers, videoLayers + videoLayerCount);
+                    layer.layerFlags |= XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+                }
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
+                if (m_options.GuiLayer && RenderPanelLayer(panelLayer)) {
+                    layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&panelLayer));
+                }
+            }
         }
 
-        // Render view to the appropriate part of the swapchain image.
-        for (uint32_t i = 0; i < viewCountOutput; i++) {
-            // Each view has a separate swapchain which is acquired, rendered to, and released.
-            const Swapchain viewSwapchain = m_swapchains[i];
+        XrCompositionLayerPassthroughFB compositionLayerPassthrough = {XR_TYPE_COMPOSITION_LAYER_PASSTHROUGH_FB};
+        if (renderLayers && m_extentions.activePassthrough) {
+            compositionLayerPassthrough.layerHandle = m_passthroughLayerReconstruction;
+            //passthrough_layer.layerHandle = m_passthroughLayer_project;
+            compositionLayerPassthrough.flags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+            compositionLayerPassthrough.space = XR_NULL_HANDLE;
+            layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&compositionLayerPassthrough));
+        }
+
+        XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+        frameEndInfo.displayTime = snapshot.frameState.predictedDisplayTime;
+        frameEndInfo.environmentBlendMode = m_options.Parsed.EnvironmentBlendMode;
+        frameEndInfo.layerCount = (uint32_t)layers.size();
+        frameEndInfo.layers = layers.data();
+        {
+            PROFILE_SCOPE(profileMarker_EndFrame);
+            CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        }
+
+        if (m_options.CountFrameAllocations) {
+            const uint32_t allocationCount = AllocationCounter::end();
+            if (allocationCount > 0) {
+                Log::Write(Log::Level::Warning, Fmt("%u heap allocations between xrBeginFrame and xrEndFrame", allocationCount));
+            }
+        }
+
+        Profiler::instance().endFrame(snapshot.frameState.predictedDisplayTime, snapshot.frameState.predictedDisplayPeriod);
+        GLState::instance().endFrame();
+    }
+
+    bool RenderLayer(const FrameSnapshot& snapshot, FrameVector<XrCompositionLayerProjectionView>& projectionLayerViews, XrCompositionLayerProjection& layer) {
+        const uint32_t viewCount = (uint32_t)snapshot.views.size();
+        CHECK(m_swapchains.size() == (m_extentions.activeMultiview ? 1 : viewCount));
+
+        projectionLayerViews.resize(viewCount);
+
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            if (snapshot.aimValid[hand]) {
+                m_application->setControllerPose(int(hand), snapshot.aimPose[hand]);
+            }
+        }
+
+        //eye tracking
+        if (snapshot.gazeValid) {
+            XrSpaceLocation gazeLocation = snapshot.gazeLocation;
+            std::copy(snapshot.views.begin(), snapshot.views.end(), m_views.begin());
+            m_application->setGazeLocation(gazeLocation, m_views, snapshot.ipd, snapshot.gazeResult);
+        }
+
+        //hand tracking
+        m_application->setHandJointLocation((XrHandJointLocationEXT*)snapshot.jointLocations);
+
+        // Per-frame application work (layout, GUI, device queries) runs once, before any view is rendered.
+        FrameState frameState;
+        frameState.predictedDisplayTime = snapshot.frameState.predictedDisplayTime;
+        frameState.predictedDisplayPeriod = snapshot.frameState.predictedDisplayPeriod;
+        m_application->update(frameState);
+
+        if (m_extentions.activeMultiview) {
+            // Both views are rendered in one pass, each into its own layer of the array swapchain.
+            const Swapchain viewSwapchain = m_swapchains[0];
             XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
             uint32_t swapchainImageIndex;
             CHECK_XRCMD(xrAcquireSwapchainImage(viewSwapchain.handle, &acquireInfo, &swapchainImageIndex));
@@ -1514,21 +1680,60 @@ struct OpenXrProgram : IOpenXrProgram {
             waitInfo.timeout = XR_INFINITE_DURATION;
             CHECK_XRCMD(xrWaitSwapchainImage(viewSwapchain.handle, &waitInfo));
 
-            projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
-            projectionLayerViews[i].pose = pose[i];
-            projectionLayerViews[i].fov = m_views[i].fov;
-            projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
-            projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
-            projectionLayerViews[i].subImage.imageRect.extent = {viewSwapchain.width, viewSwapchain.height};
+            LateLatchPoses(snapshot.frameState.predictedDisplayTime);
+
+            for (uint32_t i = 0; i < viewCount; i++) {
+                projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+                projectionLayerViews[i].pose = snapshot.views[i].pose;
+                projectionLayerViews[i].fov = snapshot.views[i].fov;
+                projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
+                projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
+                projectionLayerViews[i].subImage.imageRect.extent = {viewSwapchain.width, viewSwapchain.height};
+                projectionLayerViews[i].subImage.imageArrayIndex = i;
+            }
 
             const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[viewSwapchain.handle][swapchainImageIndex];
 
-            m_graphicsPlugin->RenderView(m_application, projectionLayerViews[i], swapchainImage, m_colorSwapchainFormat, i);
+            {
+                PROFILE_SCOPE(profileMarker_RenderView);
+                m_graphicsPlugin->RenderMultiView(m_application, projectionLayerViews.data(), viewCount, swapchainImage, m_colorSwapchainFormat);
+            }
 
             XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
             CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
-        }
+        } else {
+            // Render view to the appropriate part of the swapchain image.
+            for (uint32_t i = 0; i < viewCount; i++) {
+                // Each view has a separate swapchain which is acquired, rendered to, and released.
+                const Swapchain viewSwapchain = m_swapchains[i];
+                XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+                uint32_t swapchainImageIndex;
+                CHECK_XRCMD(xrAcquireSwapchainImage(viewSwapchain.handle, &acquireInfo, &swapchainImageIndex));
+
+                XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+                waitInfo.timeout = XR_INFINITE_DURATION;
+                CHECK_XRCMD(xrWaitSwapchainImage(viewSwapchain.handle, &waitInfo));
+
+                LateLatchPoses(snapshot.frameState.predictedDisplayTime);
+
+                projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+                projectionLayerViews[i].pose = snapshot.views[i].pose;
+                projectionLayerViews[i].fov = snapshot.views[i].fov;
+                projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
+                projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
+                projectionLayerViews[i].subImage.imageRect.extent = {viewSwapchain.width, viewSwapchain.height};
+
+                const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[viewSwapchain.handle][swapchainImageIndex];
+
+                {
+                    PROFILE_SCOPE(profileMarker_RenderView);
+                    m_graphicsPlugin->RenderView(m_application, projectionLayerViews[i], swapchainImage, m_colorSwapchainFormat, i);
+                }
 
+                XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+                CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
+            }
+        }
 
         layer.space = m_appSpace;
         if (m_extentions.activePassthrough) {
@@ -1539,6 +1744,69 @@ struct OpenXrProgram : IOpenXrProgram {
         return true;
     }
 
+    // The dashboard as a quad layer in front of the projection layer, after m_application->update of this frame.
+    // Its swapchain image is only replaced when the panel was redrawn, otherwise the runtime keeps showing the
+    // image released last.
+    bool RenderPanelLayer(XrCompositionLayerQuad& layer) {
+        PanelLayer panel{};
+        if (!m_application->panelLayer(panel)) {
+            return false;
+        }
+
+        bool copy = panel.changed;
+        if (m_panelSwapchain.handle == XR_NULL_HANDLE) {
+            // Created with the first frame that shows the panel, its size is known after the application initialized.
+            XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+            swapchainCreateInfo.arraySize = 1;
+            swapchainCreateInfo.format = m_colorSwapchainFormat;
+            swapchainCreateInfo.width = panel.width;
+            swapchainCreateInfo.height = panel.height;
+            swapchainCreateInfo.mipCount = 1;
+            swapchainCreateInfo.faceCount = 1;
+            swapchainCreateInfo.sampleCount = 1;
+            swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+            m_panelSwapchain.width = swapchainCreateInfo.width;
+            m_panelSwapchain.height = swapchainCreateInfo.height;
+            CHECK_XRCMD(xrCreateSwapchain(m_session, &swapchainCreateInfo, &m_panelSwapchain.handle));
+            Log::Write(Log::Level::Info, Fmt("Creating panel swapchain with dimensions Width=%d Height=%d", panel.width, panel.height));
+
+            uint32_t imageCount;
+            CHECK_XRCMD(xrEnumerateSwapchainImages(m_panelSwapchain.handle, 0, &imageCount, nullptr));
+            std::vector<XrSwapchainImageBaseHeader*> swapchainImages = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
+            CHECK_XRCMD(xrEnumerateSwapchainImages(m_panelSwapchain.handle, imageCount, &imageCount, swapchainImages[0]));
+            m_swapchainImages.insert(std::make_pair(m_panelSwapchain.handle, std::move(swapchainImages)));
+            copy = true;
+        }
+
+        if (copy) {
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+            uint32_t swapchainImageIndex;
+            CHECK_XRCMD(xrAcquireSwapchainImage(m_panelSwapchain.handle, &acquireInfo, &swapchainImageIndex));
+
+            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+            waitInfo.timeout = XR_INFINITE_DURATION;
+            CHECK_XRCMD(xrWaitSwapchainImage(m_panelSwapchain.handle, &waitInfo));
+
+            const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[m_panelSwapchain.handle][swapchainImageIndex];
+            m_graphicsPlugin->CopyToSwapchainImage(panel.texture, m_panelSwapchain.width, m_panelSwapchain.height, swapchainImage);
+
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            CHECK_XRCMD(xrReleaseSwapchainImage(m_panelSwapchain.handle, &releaseInfo));
+        }
+
+        // The panel texture is cleared to transparent black and blended over it, so its color is premultiplied.
+        layer.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+        layer.space = m_appSpace;
+        layer.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+        layer.subImage.swapchain = m_panelSwapchain.handle;
+        layer.subImage.imageRect.offset = {0, 0};
+        layer.subImage.imageRect.extent = {m_panelSwapchain.width, m_panelSwapchain.height};
+        layer.subImage.imageArrayIndex = 0;
+        layer.pose = panel.pose;
+        layer.size = panel.size;
+        return true;
+    }
+
 
    private:
     const Options m_options;
@@ -1551,6 +1819,7 @@ struct OpenXrProgram : IOpenXrProgram {
 
     std::vector<XrViewConfigurationView> m_configViews;
     std::vector<Swapchain> m_swapchains;
+    Swapchain m_panelSwapchain{XR_NULL_HANDLE, 0, 0};   // Options::GuiLayer
     std::map<XrSwapchain, std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;
     std::vector<XrView> m_views;
     int64_t m_colorSwapchainFormat{-1};
@@ -1561,9 +1830,17 @@ struct OpenXrProgram : IOpenXrProgram {
 
     XrEventDataBuffer m_eventDataBuffer;
     InputState m_input;
+    // last value of every ActionEventBindings() row, only used by float and vector rows
+    std::vector<XrVector2f> m_actionEventValues[Side::COUNT];
 
     XrSpace m_ViewSpace{XR_NULL_HANDLE};
 
+    // XR_KHR_locate_spaces. SampleFrame and LateLatchPoses run on different threads in the pipelined
+    // frame loop, so each has its own cache.
+    bool m_locateSpacesEnabled{false};
+    PoseCache m_poseCache;
+    PoseCache m_lateLatchPoseCache;
+
     std::shared_ptr<IApplication> m_application;
 
     //for XR_FB_passthrough
@@ -1605,6 +1882,17 @@ struct OpenXrProgram : IOpenXrProgram {
     Extentions m_extentions;
 
     ApplicationEvent m_applicationEvent[Side::COUNT] = {0};
+    ApplicationEvent m_simulationEvent[Side::COUNT] = {0};
+
+    // pipelined frame loop, see RenderFramePipelined
+    std::thread m_simulationThread;
+    std::mutex m_frameMutex;
+    std::condition_variable m_frameCondition;
+    FrameSnapshot m_pendingFrame;
+    bool m_pendingFrameValid{false};
+    bool m_simulationStop{false};
+    bool m_simulationDone{false};
+    std::exception_ptr m_simulationError;
     DeviceType m_deviceType;
     uint32_t m_deviceROM;
 
@@ -15,6 +15,24 @@ struct Options {
 
     std::string AppSpace{"Local"};
 
+    // Run xrWaitFrame, action sync and pose sampling on a separate simulation thread so that the
+    // CPU work of frame N+1 overlaps the GPU work of frame N.
+    bool PipelinedFrameLoop{false};
+
+    // Render both eyes in a single pass into a two layer array swapchain when GL_OVR_multiview2 is available.
+    bool Multiview{false};
+
+    // Debug builds: report heap allocations made by the render thread between xrBeginFrame and xrEndFrame.
+    bool CountFrameAllocations{false};
+
+    // Submit the dashboard as a quad composition layer with its own swapchain instead of drawing it into the
+    // eye buffers. The runtime resamples it once at display resolution and it is only copied when it changed.
+    bool GuiLayer{false};
+
+    // Decode video straight into an XR_KHR_android_surface_swapchain and let the runtime present it as quad or
+    // equirect layers under the projection layer, instead of drawing each frame into the eye buffers.
+    bool VideoLayer{false};
+
     struct {
         XrFormFactor FormFactor{XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY};
 
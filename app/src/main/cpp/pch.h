@@ -109,4 +109,8 @@
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
 #include <openxr/openxr_reflection.h>
-#include <openxr/openxr_pico.h>
\ No newline at end of file
+#include <openxr/openxr_pico.h>
+
+#if defined(XR_USE_PLATFORM_EGL) && !defined(XR_USE_PLATFORM_ANDROID)
+#include "loader_linux.h"
+#endif
@@ -0,0 +1,26 @@
+// Copyright (c) 2017-2020 The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pch.h"
+#include "common.h"
+#include "platformplugin.h"
+
+#if defined(XR_USE_PLATFORM_EGL) && !defined(XR_USE_PLATFORM_ANDROID)
+
+namespace {
+// Headless Linux host. The loader finds the runtime through XR_RUNTIME_JSON and the graphics plugin renders
+// on a surfaceless EGL context, so nothing is chained to XrInstanceCreateInfo.
+struct LinuxPlatformPlugin : public IPlatformPlugin {
+    LinuxPlatformPlugin(const std::shared_ptr<Options>& /*unused*/) {}
+
+    std::vector<std::string> GetInstanceExtensions() const override { return {}; }
+
+    XrBaseInStructure* GetInstanceCreateExtension() const override { return nullptr; }
+};
+}  // namespace
+
+std::shared_ptr<IPlatformPlugin> CreatePlatformPlugin_Linux(const std::shared_ptr<Options>& options) {
+    return std::make_shared<LinuxPlatformPlugin>(options);
+}
+#endif
@@ -0,0 +1,86 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pch.h"
+#include "common.h"
+#include "posecache.h"
+
+void PoseCache::Initialize(XrInstance instance, XrSession session, XrSpace baseSpace, bool locateSpacesEnabled) {
+    m_session = session;
+    m_baseSpace = baseSpace;
+    m_xrLocateSpacesKHR = nullptr;
+    if (locateSpacesEnabled) {
+        CHECK_XRCMD(xrGetInstanceProcAddr(instance, "xrLocateSpacesKHR", (PFN_xrVoidFunction*)(&m_xrLocateSpacesKHR)));
+    }
+}
+
+void PoseCache::AddSpace(XrSpace space) {
+    if (space == XR_NULL_HANDLE || std::find(m_spaces.begin(), m_spaces.end(), space) != m_spaces.end()) {
+        return;
+    }
+    m_spaces.push_back(space);
+    XrSpaceLocationData location{};
+    location.pose.orientation.w = 1.0f;
+    m_locations.push_back(location);
+}
+
+void PoseCache::RemoveSpace(XrSpace space) {
+    auto it = std::find(m_spaces.begin(), m_spaces.end(), space);
+    if (it == m_spaces.end()) {
+        return;
+    }
+    m_locations.erase(m_locations.begin() + (it - m_spaces.begin()));
+    m_spaces.erase(it);
+}
+
+XrResult PoseCache::Locate(XrTime time) {
+    m_time = time;
+    if (m_spaces.empty()) {
+        m_result = XR_SUCCESS;
+        return m_result;
+    }
+
+    if (m_xrLocateSpacesKHR != nullptr) {
+        XrSpacesLocateInfoKHR locateInfo{XR_TYPE_SPACES_LOCATE_INFO_KHR};
+        locateInfo.baseSpace = m_baseSpace;
+        locateInfo.time = time;
+        locateInfo.spaceCount = (uint32_t)m_spaces.size();
+        locateInfo.spaces = m_spaces.data();
+
+        XrSpaceLocationsKHR locations{XR_TYPE_SPACE_LOCATIONS_KHR};
+        locations.locationCount = (uint32_t)m_locations.size();
+        locations.locations = m_locations.data();
+        m_result = m_xrLocateSpacesKHR(m_session, &locateInfo, &locations);
+        CHECK_XRRESULT(m_result, "xrLocateSpacesKHR");
+        return m_result;
+    }
+
+    m_result = XR_SUCCESS;
+    for (size_t i = 0; i < m_spaces.size(); i++) {
+        XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
+        XrResult res = xrLocateSpace(m_spaces[i], m_baseSpace, time, &spaceLocation);
+        CHECK_XRRESULT(res, "xrLocateSpace");
+        m_locations[i].locationFlags = XR_UNQUALIFIED_SUCCESS(res) ? spaceLocation.locationFlags : 0;
+        m_locations[i].pose = spaceLocation.pose;
+        if (res != XR_SUCCESS) {
+            m_result = res;
+        }
+    }
+    return m_result;
+}
+
+const XrSpaceLocationData* PoseCache::Get(XrSpace space) const {
+    for (size_t i = 0; i < m_spaces.size(); i++) {
+        if (m_spaces[i] == space) {
+            return &m_locations[i];
+        }
+    }
+    return nullptr;
+}
+
+bool PoseCache::IsPoseValid(XrSpace space) const {
+    const XrSpaceLocationData* location = Get(space);
+    return location != nullptr && (location->locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
+           (location->locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0;
+}
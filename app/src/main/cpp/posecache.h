@@ -0,0 +1,38 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// Locates a fixed set of spaces against one base space, once per frame. All spaces are resolved by a
+// single xrLocateSpacesKHR call when XR_KHR_locate_spaces is enabled, otherwise by one xrLocateSpace per
+// space. Consumers read the results by space until the next Locate. An instance is only used by one thread.
+class PoseCache {
+   public:
+    void Initialize(XrInstance instance, XrSession session, XrSpace baseSpace, bool locateSpacesEnabled);
+
+    // Registers a space to be located by every following Locate call.
+    void AddSpace(XrSpace space);
+    // Stops locating a space added before, no-op for any other.
+    void RemoveSpace(XrSpace space);
+
+    XrResult Locate(XrTime time);
+
+    // nullptr if the space was not added
+    const XrSpaceLocationData* Get(XrSpace space) const;
+
+    // True if both position and orientation of the space are valid.
+    bool IsPoseValid(XrSpace space) const;
+
+    XrTime Time() const { return m_time; }
+    XrResult Result() const { return m_result; }
+
+   private:
+    XrSession m_session{XR_NULL_HANDLE};
+    XrSpace m_baseSpace{XR_NULL_HANDLE};
+    PFN_xrLocateSpacesKHR m_xrLocateSpacesKHR{nullptr};
+    std::vector<XrSpace> m_spaces;
+    std::vector<XrSpaceLocationData> m_locations;
+    XrTime m_time{0};
+    XrResult m_result{XR_SUCCESS};
+};